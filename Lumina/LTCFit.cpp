@@ -0,0 +1,29 @@
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "./Lights/LTCFit.hpp"
+
+// Fits the LTC Tables offline and writes the File LTCTables loads <no Context needed>
+// Texture/LTC_GGX.bin is its Output for the default Size, rerun it after changing the Fit
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "./Texture/LTC_GGX.bin";
+    int size = argc > 2 ? std::atoi(argv[2]) : 64;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    std::vector<glm::vec4> ltc_matrix, ltc_amplitude;
+    auto start = std::chrono::high_resolution_clock::now();
+    LTCFit::Fit(size, ltc_matrix, ltc_amplitude, threads);
+    double fit_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << "LTC Fit " << size << " * " << size << ": " << fit_ms / 1000.0 << "s" << std::endl;
+    std::cout << "Mean relative Error: " << LTCFit::Error(size, ltc_matrix, ltc_amplitude) << std::endl;
+
+    if (!LTCFit::Save(path, size, ltc_matrix, ltc_amplitude))
+        return -1;
+    std::cout << "Saved to " << path << std::endl;
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "./glm/glm.hpp"
+#include "./Attachments.hpp"
+
+// Shapes <matches AREA_RECT and AREA_DISK in the Shaders>
+#define AREA_RECT 0
+#define AREA_DISK 1
+
+// Rectangle or Disk evaluated with Linearly Transformed Cosines, attrib.diffuse and attrib.specular are its Radiance
+class AreaLight {
+
+public:
+    glm::vec3 position;
+    // Half Extents, the Light shines along cross(right, up) <Radii for a Disk>
+    glm::vec3 right;
+    glm::vec3 up;
+    LightAttrib attrib;
+    int shape;
+    bool two_sided;
+
+    AreaLight(LightAttrib attrib, glm::vec3 pos, glm::vec3 right, glm::vec3 up, int shape = AREA_RECT, bool two_sided = false) {
+        this->attrib = attrib;
+        this->position = pos;
+        this->right = right;
+        this->up = up;
+        this->shape = shape;
+        this->two_sided = two_sided;
+    };
+};
\ No newline at end of file
@@ -0,0 +1,219 @@
+// Cascaded Shadow Maps: the Camera Frustum is cut into Slices along the View Depth, each Slice gets its own
+// Orthographic Shadow Map fitted to it, all stored as Layers of one Depth Texture Array
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "./DirLight.hpp"
+#include "./ShadowCulling.hpp"
+#include "../Shaders/Model.hpp"
+
+// Cascade Limits <matches CASCADE_LIMITATION in the Shaders>
+#define CASCADE_LIMITATION 4
+// GL_TEXTURE25 <after the Material Arrays>
+#define CASCADE_TEXTURE_UNIT 25
+
+class CascadedShadowMap {
+
+public:
+    // 0 splits linearly, 1 logarithmically <Practical Split Scheme>
+    float lambda = 0.75f;
+    // Fraction of each Cascade cross-faded into the next one, 0 to switch hard
+    float blend = 0.1f;
+    // Shadows end here even if the Camera sees further, 0 uses the Camera's far Plane
+    float max_distance = 0.0f;
+
+    // Needs a current Context
+    CascadedShadowMap(int resolution = 2048, int cascades = CASCADE_LIMITATION) {
+        this->resolution = resolution;
+        this->cascades = std::clamp(cascades, 1, CASCADE_LIMITATION);
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, resolution, resolution, this->cascades);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &fbo);
+    }
+
+    void Delete() {
+        glDeleteTextures(1, &texture);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    // Casters are culled per Mesh against every Cascade
+    int AddCaster(Model *model, glm::mat4 transform) {
+        casters.push_back({model, transform, {}});
+        bound(casters.back());
+        return casters.size() - 1;
+    }
+
+    void MoveCaster(int caster, glm::mat4 transform) {
+        casters.at(caster).transform = transform;
+        bound(casters.at(caster));
+    }
+
+    // Fits every Cascade to its Slice of the Camera Frustum and redraws it <depth_shader: SimpleDepth>
+    // Leaves the Default FrameBuffer bound, the Caller resets the Viewport
+    void Update(DirLight &light, glm::mat4 view, float fov, float aspect, float znear, float zfar, Shader *depth_shader) {
+        Tools::ShaderCheck(depth_shader);
+
+        float shadow_far = max_distance > 0.0f ? std::min(max_distance, zfar) : zfar;
+        splitDepths(znear, shadow_far);
+
+        // Light Rotation only, the Cascades move in Texel Steps inside it
+        glm::vec3 dir = glm::normalize(light.direction);
+        glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f), dir, up);
+        glm::mat4 inverse_view = glm::inverse(view);
+
+        float tan_half_fov = std::tan(glm::radians(fov) * 0.5f);
+        // Squared Half Diagonal of a Slice at Depth 1
+        float k = tan_half_fov * tan_half_fov * (1.0f + aspect * aspect);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        glViewport(0, 0, resolution, resolution);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_TRUE);
+        depth_shader->Use();
+        depth_shader->setBool("useInstance", false);
+
+        for (int i = 0; i < cascades; ++i) {
+            float n = i == 0 ? znear : splits[i - 1];
+            float f = splits[i];
+
+            // Smallest Sphere around the Slice <its Radius doesn't change when the Camera turns, so neither does the Texel Size>
+            float center_depth = std::min(0.5f * (f + n) * (1.0f + k), f);
+            float radius = std::sqrt((center_depth - n) * (center_depth - n) + n * n * k);
+            radius = std::max(radius, std::sqrt((f - center_depth) * (f - center_depth) + f * f * k));
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+            glm::vec3 center = glm::vec3(inverse_view * glm::vec4(0.0f, 0.0f, -center_depth, 1.0f));
+
+            // Snap to whole Texels so the Map doesn't shimmer while the Camera moves
+            float texel = 2.0f * radius / resolution;
+            glm::vec3 light_center = glm::vec3(light_view * glm::vec4(center, 1.0f));
+            light_center.x = std::floor(light_center.x / texel) * texel;
+            light_center.y = std::floor(light_center.y / texel) * texel;
+
+            glm::vec2 box_min = glm::vec2(light_center) - radius;
+            glm::vec2 box_max = glm::vec2(light_center) + radius;
+            // the Light looks down -Z, Receivers lie within the Sphere
+            float z_far = light_center.z - radius;
+            float z_near = light_center.z + radius;
+
+            visible[i].clear();
+            for (Caster &caster : casters)
+                for (size_t m = 0; m < caster.bounds.size(); ++m) {
+                    glm::vec3 lmin, lmax;
+                    lightBounds(light_view, caster.bounds[m], lmin, lmax);
+                    if (lmax.x < box_min.x || lmin.x > box_max.x || lmax.y < box_min.y || lmin.y > box_max.y || lmax.z < z_far)
+                        continue;
+                    // Casters between the Light and the Slice still throw Shadows into it
+                    z_near = std::max(z_near, lmax.z);
+                    visible[i].push_back({&caster, m});
+                }
+
+            glm::mat4 projection = glm::ortho(box_min.x, box_max.x, box_min.y, box_max.y, -z_near, -z_far);
+            transforms[i] = projection * light_view;
+            texels[i] = texel;
+
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            depth_shader->setMat4("LightSpaceTransform", transforms[i]);
+            for (VisibleMesh &visible_mesh : visible[i]) {
+                depth_shader->setMat4("model", visible_mesh.caster->transform);
+                visible_mesh.caster->model->DrawDepth(visible_mesh.mesh);
+            }
+        }
+
+        // Keeps the Shaders that read lightMatrix on the nearest Cascade
+        light.lightMatrix = transforms[0];
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // dirlight: index in LightManager::dirlights whose Shadow comes from the Cascades
+    void ShaderConfig(Shader *shader, int dirlight) {
+        Tools::ShaderCheck(shader);
+
+        shader->Use();
+        shader->setInt("cascade_dirlight", dirlight);
+        shader->setInt("cascade_count", cascades);
+        shader->setFloat("cascade_blend", blend);
+        for (int i = 0; i < cascades; ++i) {
+            shader->setMat4("cascade_transforms[" + std::to_string(i) + "]", transforms[i]);
+            shader->setFloat("cascade_splits[" + std::to_string(i) + "]", splits[i]);
+            shader->setFloat("cascade_texels[" + std::to_string(i) + "]", texels[i]);
+        }
+
+        shader->setInt("cascade_shadowmap", CASCADE_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + CASCADE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    unsigned int ServeTexture() { return texture; }
+    int ServeResolution() { return resolution; }
+    int ServeCascades() { return cascades; }
+    float ServeSplit(int cascade) { return splits[cascade]; }
+    int ServeDrawnMeshes(int cascade) { return visible[cascade].size(); }
+
+private:
+    struct Caster {
+        Model *model;
+        glm::mat4 transform;
+        std::vector<ShadowCulling::Bounds> bounds;      // World AABB per Mesh
+    };
+
+    struct VisibleMesh {
+        Caster *caster;
+        size_t mesh;
+    };
+
+    int resolution;
+    int cascades;
+
+    unsigned int texture = 0;
+    unsigned int fbo = 0;
+
+    std::vector<Caster> casters;
+    std::vector<VisibleMesh> visible[CASCADE_LIMITATION];
+
+    glm::mat4 transforms[CASCADE_LIMITATION] = {};
+    float splits[CASCADE_LIMITATION] = {};      // far View Depth of each Cascade
+    float texels[CASCADE_LIMITATION] = {};      // World Size of one Texel
+
+    void bound(Caster &caster) {
+        ShadowCulling::MeshBounds(caster.model, caster.transform, caster.bounds);
+    }
+
+    // AABB of a World AABB seen from the Light
+    void lightBounds(const glm::mat4 &light_view, const ShadowCulling::Bounds &bounds, glm::vec3 &lmin, glm::vec3 &lmax) {
+        glm::vec3 center = glm::vec3(light_view * glm::vec4((bounds.first + bounds.second) * 0.5f, 1.0f));
+        glm::vec3 half = 0.5f * (bounds.second - bounds.first);
+        glm::vec3 extent = glm::abs(glm::vec3(light_view[0])) * half.x + glm::abs(glm::vec3(light_view[1])) * half.y + glm::abs(glm::vec3(light_view[2])) * half.z;
+        lmin = center - extent;
+        lmax = center + extent;
+    }
+
+    // Practical Split Scheme: Blend of the logarithmic and the uniform Split
+    void splitDepths(float znear, float zfar) {
+        for (int i = 1; i <= cascades; ++i) {
+            float t = (float)i / cascades;
+            float logarithmic = znear * std::pow(zfar / znear, t);
+            float uniform = znear + (zfar - znear) * t;
+            splits[i - 1] = lambda * logarithmic + (1.0f - lambda) * uniform;
+        }
+    }
+};
@@ -10,6 +10,7 @@ public:
     LightAttrib attrib;
     glm::mat4 lightMatrix;
     unsigned int depthmap;
+    glm::vec4 atlas = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);   // Region of depthmap in use <offset, scale>
 
     DirLight(LightAttrib attrib, glm::vec3 dir, glm::mat4 matrix, unsigned int depth) {
         this->attrib = attrib;
@@ -0,0 +1,157 @@
+// Exponential Variance Shadow Maps: Depth is warped by a positive and a negative Exponential and stored with its Square,
+// so the Map can be blurred and mipmapped like a Color Texture and one filtered Fetch resolves a soft Shadow
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#include "./Attachments.hpp"
+
+// GL_TEXTURE28 <after the PCSS Textures>
+#define EVSM_TEXTURE_UNIT 28
+
+class EVSMShadows {
+
+public:
+    // fp32 Moments overflow above about 42 <positive> and get imprecise above about 5 to 10 <negative>
+    float positive_exponent = 40.0f;
+    float negative_exponent = 8.0f;
+    // Cuts the Tail of Chebyshev's Bound where unrelated Occluders overlap
+    float bleeding_reduction = 0.3f;
+    float min_variance = 0.0001f;
+    // Gaussian Radius in Moment Texels, 0 only averages the Depth Texels
+    int blur_radius = 2;
+
+    // Needs a current Context <convert_shader: FullScreen + EVSMConvert, blur_shader: FullScreen + EVSMBlur>
+    // resolution should divide the Depth Resolution
+    EVSMShadows(Shader *convert_shader, Shader *blur_shader, int resolution = 1024, int layers = 1) {
+        this->convert_shader = convert_shader;
+        this->blur_shader = blur_shader;
+        this->resolution = resolution;
+        this->layers = layers;
+
+        levels = 1;
+        while ((resolution >> levels) > 0)
+            ++levels;
+
+        glGenTextures(1, &moments);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, moments);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA32F, resolution, resolution, layers);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        float max_anisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY, std::min(max_anisotropy, 8.0f));
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        // Ping-Pong Targets of one Layer
+        for (unsigned int &temp : temps) {
+            glGenTextures(1, &temp);
+            glBindTexture(GL_TEXTURE_2D, temp);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, resolution, resolution);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &fbo);
+        glGenVertexArrays(1, &VAO);
+    }
+
+    void Delete() {
+        glDeleteTextures(1, &moments);
+        glDeleteTextures(2, temps);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // Converts, blurs and mipmaps every Layer <depthmap: GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY>
+    // Call after every Shadow Map Update. Leaves the Default FrameBuffer bound, the Caller resets the Viewport
+    void Build(unsigned int depthmap, GLenum target, int depth_resolution) {
+        Tools::ShaderCheck(convert_shader);
+        Tools::ShaderCheck(blur_shader);
+
+        bool array_source = target == GL_TEXTURE_2D_ARRAY;
+        int ratio = std::max(depth_resolution / resolution, 1);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, resolution, resolution);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glBindVertexArray(VAO);
+
+        for (int layer = 0; layer < layers; ++layer) {
+            // Depth to Moments
+            convert_shader->Use();
+            convert_shader->setBool("array_source", array_source);
+            convert_shader->setInt("layer", layer);
+            convert_shader->setInt("ratio", ratio);
+            convert_shader->setVec2("exponents", glm::vec2(positive_exponent, negative_exponent));
+            convert_shader->setInt(array_source ? "depth_array" : "depth_single", 0);
+            convert_shader->setInt(array_source ? "depth_single" : "depth_array", 1);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(target, depthmap);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, temps[0], 0);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindTexture(target, 0);
+
+            // Horizontal then Vertical, the second Pass lands in the Layer
+            blur_shader->Use();
+            blur_shader->setInt("image", 0);
+            blur_shader->setInt("radius", blur_radius);
+
+            blur_shader->setBool("horizontal", true);
+            glBindTexture(GL_TEXTURE_2D, temps[0]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, temps[1], 0);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            blur_shader->setBool("horizontal", false);
+            glBindTexture(GL_TEXTURE_2D, temps[1]);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, moments, 0, layer);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, moments);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glEnable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    // enabled: false keeps the Shader on its Depth Compare Path
+    void ShaderConfig(Shader *shader, bool enabled = true) {
+        Tools::ShaderCheck(shader);
+
+        shader->Use();
+        shader->setBool("evsm.enabled", enabled);
+        shader->setVec2("evsm.exponents", glm::vec2(positive_exponent, negative_exponent));
+        shader->setFloat("evsm.bleeding_reduction", bleeding_reduction);
+        shader->setFloat("evsm.min_variance", min_variance);
+
+        shader->setInt("evsm_moments", EVSM_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + EVSM_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, moments);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    unsigned int ServeTexture() { return moments; }
+
+private:
+    Shader *convert_shader;
+    Shader *blur_shader;
+
+    int resolution;
+    int layers;
+    int levels;
+
+    unsigned int moments = 0;
+    unsigned int temps[2] = {};
+    unsigned int fbo = 0;
+    unsigned int VAO = 0;
+};
@@ -0,0 +1,406 @@
+// Linearly Transformed Cosines Fitting: for every Roughness and View Angle the GGX Lobe is approximated by a clamped
+// Cosine under a 3x3 Matrix, which Area Lights can integrate in closed Form <Heitz et al. 2016>
+// Rows run over sqrt(1 - cos(theta)), Columns over Roughness = sqrt(alpha), both from 0 to 1
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include "glm/glm.hpp"
+
+class LTCFit {
+
+public:
+    // ltc_matrix: Terms of the normalized inverse Matrix <m00, m20, m02, m22 of the Columns>
+    // ltc_amplitude: Norm and Fresnel Integral of the BRDF, unused, horizon-clipped Sphere Scale <Row: Form Factor, Column: cos(elevation)>
+    static void Fit(int size, std::vector<glm::vec4> &ltc_matrix, std::vector<glm::vec4> &ltc_amplitude, int threads = 0) {
+        if (threads <= 0)
+            threads = std::max((int)std::thread::hardware_concurrency(), 1);
+
+        std::vector<LTC> fits(size * size);
+
+        // Straight Views are isotropic, each Roughness starts from the rougher one before it
+        for (int a = size - 1; a >= 0; --a) {
+            LTC ltc;
+            if (a < size - 1) {
+                ltc.m11 = fits[a + 1].m11;
+                ltc.m22 = fits[a + 1].m22;
+            }
+            fitCell(ltc, a, 0, size);
+            fits[a] = ltc;
+        }
+
+        // Then every Roughness walks the View Angle on its own, starting from the Fit before
+        std::vector<std::thread> pool;
+        auto work = [&](int first) {
+            for (int a = first; a < size; a += threads) {
+                LTC ltc = fits[a];
+                for (int t = 1; t < size; ++t) {
+                    fitCell(ltc, a, t, size);
+                    fits[t * size + a] = ltc;
+                }
+            }
+        };
+        for (int i = 1; i < threads; ++i)
+            pool.emplace_back(work, i);
+        work(0);
+        for (std::thread &thread : pool)
+            thread.join();
+
+        ltc_matrix.resize(size * size);
+        ltc_amplitude.resize(size * size);
+        for (int i = 0; i < size * size; ++i) {
+            glm::mat3 inverse = glm::inverse(fits[i].M);
+            inverse /= inverse[1][1];
+            ltc_matrix[i] = glm::vec4(inverse[0][0], inverse[0][2], inverse[2][0], inverse[2][2]);
+            ltc_amplitude[i] = glm::vec4(fits[i].norm, fits[i].fresnel, 0.0f, 0.0f);
+        }
+
+        for (int j = 0; j < size; ++j)
+            for (int i = 0; i < size; ++i)
+                ltc_amplitude[j * size + i].w = clippedSphere(2.0f * i / (size - 1) - 1.0f, (float)j / (size - 1));
+    }
+
+    // Raw File: Size, then both Tables as Floats
+    static bool Save(const std::string &path, int size, const std::vector<glm::vec4> &ltc_matrix, const std::vector<glm::vec4> &ltc_amplitude) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            std::cout << "ERROR::LTC_FIT::SAVE:: can't write " << path << std::endl;
+            return false;
+        }
+        file.write((const char *)&size, sizeof(int));
+        file.write((const char *)ltc_matrix.data(), ltc_matrix.size() * sizeof(glm::vec4));
+        file.write((const char *)ltc_amplitude.data(), ltc_amplitude.size() * sizeof(glm::vec4));
+        return (bool)file;
+    }
+
+    // Fails quietly when the File is missing or holds another Size
+    static bool Load(const std::string &path, int size, std::vector<glm::vec4> &ltc_matrix, std::vector<glm::vec4> &ltc_amplitude) {
+        std::ifstream file(path, std::ios::binary);
+        int stored = 0;
+        if (!file || !file.read((char *)&stored, sizeof(int)) || stored != size)
+            return false;
+        ltc_matrix.resize(size * size);
+        ltc_amplitude.resize(size * size);
+        file.read((char *)ltc_matrix.data(), ltc_matrix.size() * sizeof(glm::vec4));
+        file.read((char *)ltc_amplitude.data(), ltc_amplitude.size() * sizeof(glm::vec4));
+        return (bool)file;
+    }
+
+    // Mean relative L1 Distance between Fit and BRDF over the Table <for the Fitting Tool's Report>
+    static float Error(int size, const std::vector<glm::vec4> &ltc_matrix, const std::vector<glm::vec4> &ltc_amplitude) {
+        double sum = 0.0;
+        for (int t = 0; t < size; ++t)
+            for (int a = 0; a < size; ++a) {
+                glm::vec4 m = ltc_matrix[t * size + a];
+                glm::mat3 inverse = glm::mat3(glm::vec3(m.x, 0.0f, m.y), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(m.z, 0.0f, m.w));
+                LTC ltc;
+                ltc.M = glm::inverse(inverse);
+                ltc.invM = inverse;
+                ltc.detM = std::abs(glm::determinant(ltc.M));
+                ltc.norm = ltc_amplitude[t * size + a].x;
+
+                float alpha, theta;
+                cell(a, t, size, alpha, theta);
+                sum += difference(ltc, glm::vec3(std::sin(theta), 0.0f, std::cos(theta)), alpha, 1) / ltc.norm;
+            }
+        return sum / (size * size);
+    }
+
+private:
+    static constexpr float PI = 3.14159265358979f;
+    static constexpr float MIN_ALPHA = 0.0001f;
+    // Stratified Samples per Axis for the Integrals
+    static constexpr int SAMPLES = 32;
+
+    struct LTC {
+        float m11 = 1.0f;
+        float m22 = 1.0f;
+        float m13 = 0.0f;
+        glm::vec3 X = glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 Y = glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 Z = glm::vec3(0.0f, 0.0f, 1.0f);
+
+        float norm = 1.0f;
+        float fresnel = 1.0f;
+
+        glm::mat3 M = glm::mat3(1.0f);
+        glm::mat3 invM = glm::mat3(1.0f);
+        float detM = 1.0f;
+
+        void update() {
+            M = glm::mat3(X, Y, Z) * glm::mat3(glm::vec3(m11, 0.0f, 0.0f), glm::vec3(0.0f, m22, 0.0f), glm::vec3(m13, 0.0f, 1.0f));
+            invM = glm::inverse(M);
+            detM = std::abs(glm::determinant(M));
+        }
+
+        // Clamped Cosine carried to L, scaled by the BRDF's Norm
+        float eval(const glm::vec3 &L) const {
+            glm::vec3 original = glm::normalize(invM * L);
+            glm::vec3 transformed = M * original;
+            float l = glm::length(transformed);
+            float jacobian = detM / (l * l * l);
+            return norm * std::max(original.z, 0.0f) / PI / jacobian;
+        }
+
+        glm::vec3 sample(float u1, float u2) const {
+            float theta = std::acos(std::sqrt(u1));
+            float phi = 2.0f * PI * u2;
+            return glm::normalize(M * glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)));
+        }
+    };
+
+    static void cell(int a, int t, int size, float &alpha, float &theta) {
+        float roughness = (float)a / (size - 1);
+        alpha = std::max(roughness * roughness, MIN_ALPHA);
+        float x = (float)t / (size - 1);
+        theta = std::min(1.57f, std::acos(1.0f - x * x));
+    }
+
+    // GGX with Smith's height-correlated Masking, cos(L) included
+    static float ggx(const glm::vec3 &V, const glm::vec3 &L, float alpha, float &pdf) {
+        if (V.z <= 0.0f) {
+            pdf = 0.0f;
+            return 0.0f;
+        }
+
+        float G2 = 0.0f;
+        if (L.z > 0.0f)
+            G2 = 1.0f / (1.0f + lambda(alpha, V.z) + lambda(alpha, L.z));
+
+        glm::vec3 H = glm::normalize(V + L);
+        float slope_x = H.x / H.z;
+        float slope_y = H.y / H.z;
+        float D = 1.0f / (1.0f + (slope_x * slope_x + slope_y * slope_y) / (alpha * alpha));
+        D = D * D / (PI * alpha * alpha * H.z * H.z * H.z * H.z);
+
+        pdf = std::abs(D * H.z / 4.0f / glm::dot(V, H));
+        return D * G2 / 4.0f / V.z;
+    }
+
+    static float lambda(float alpha, float cos_theta) {
+        float tan_theta = std::sqrt(std::max(1.0f - cos_theta * cos_theta, 0.0f)) / cos_theta;
+        if (tan_theta == 0.0f)
+            return 0.0f;
+        float a = 1.0f / (alpha * tan_theta);
+        return 0.5f * (-1.0f + std::sqrt(1.0f + 1.0f / (a * a)));
+    }
+
+    static glm::vec3 sampleGGX(const glm::vec3 &V, float alpha, float u1, float u2) {
+        float phi = 2.0f * PI * u1;
+        float r = alpha * std::sqrt(u2 / (1.0f - u2));
+        glm::vec3 N = glm::normalize(glm::vec3(r * std::cos(phi), r * std::sin(phi), 1.0f));
+        return -V + 2.0f * N * glm::dot(N, V);
+    }
+
+    // Norm, Schlick Fresnel Weight and mean Direction of the Lobe
+    static void averageTerms(const glm::vec3 &V, float alpha, float &norm, float &fresnel, glm::vec3 &direction) {
+        norm = 0.0f;
+        fresnel = 0.0f;
+        direction = glm::vec3(0.0f);
+
+        for (int j = 0; j < SAMPLES; ++j)
+            for (int i = 0; i < SAMPLES; ++i) {
+                glm::vec3 L = sampleGGX(V, alpha, (i + 0.5f) / SAMPLES, (j + 0.5f) / SAMPLES);
+                float pdf;
+                float value = ggx(V, L, alpha, pdf);
+                if (pdf <= 0.0f)
+                    continue;
+                float weight = value / pdf;
+                glm::vec3 H = glm::normalize(V + L);
+                norm += weight;
+                fresnel += weight * std::pow(1.0f - std::max(glm::dot(V, H), 0.0f), 5.0f);
+                direction += weight * L;
+            }
+
+        norm /= SAMPLES * SAMPLES;
+        fresnel /= SAMPLES * SAMPLES;
+        // the Lobe stays in the Plane of V
+        direction.y = 0.0f;
+        direction = glm::normalize(direction);
+    }
+
+    // Integral of |BRDF - LTC|^power, Multiple Importance Sampling of both Lobes <the Fit minimizes the cubed one>
+    static float difference(const LTC &ltc, const glm::vec3 &V, float alpha, int power) {
+        double sum = 0.0;
+        for (int j = 0; j < SAMPLES; ++j)
+            for (int i = 0; i < SAMPLES; ++i) {
+                float u1 = (i + 0.5f) / SAMPLES;
+                float u2 = (j + 0.5f) / SAMPLES;
+                glm::vec3 directions[2] = {ltc.sample(u1, u2), sampleGGX(V, alpha, u1, u2)};
+                for (glm::vec3 &L : directions) {
+                    float pdf_brdf;
+                    float brdf = ggx(V, L, alpha, pdf_brdf);
+                    float value = ltc.eval(L);
+                    float pdf_ltc = value / ltc.norm;
+                    double distance = std::pow(std::abs(brdf - value), power);
+                    if (pdf_ltc + pdf_brdf > 0.0f)
+                        sum += distance / (pdf_ltc + pdf_brdf);
+                }
+            }
+        return sum / (SAMPLES * SAMPLES);
+    }
+
+    static void fitCell(LTC &ltc, int a, int t, int size) {
+        float alpha, theta;
+        cell(a, t, size, alpha, theta);
+        glm::vec3 V = glm::vec3(std::sin(theta), 0.0f, std::cos(theta));
+
+        glm::vec3 direction;
+        averageTerms(V, alpha, ltc.norm, ltc.fresnel, direction);
+
+        bool isotropic = t == 0;
+        if (isotropic) {
+            ltc.X = glm::vec3(1.0f, 0.0f, 0.0f);
+            ltc.Y = glm::vec3(0.0f, 1.0f, 0.0f);
+            ltc.Z = glm::vec3(0.0f, 0.0f, 1.0f);
+            ltc.m13 = 0.0f;
+        }
+        else {
+            // the Frame follows the Lobe's mean Direction
+            ltc.X = glm::vec3(direction.z, 0.0f, -direction.x);
+            ltc.Y = glm::vec3(0.0f, 1.0f, 0.0f);
+            ltc.Z = direction;
+        }
+        ltc.update();
+
+        auto apply = [&](const float *params) {
+            if (isotropic) {
+                ltc.m11 = std::max(params[0], MIN_ALPHA);
+                ltc.m22 = ltc.m11;
+                ltc.m13 = 0.0f;
+            }
+            else {
+                ltc.m11 = std::max(params[0], 1e-7f);
+                ltc.m22 = std::max(params[1], 1e-7f);
+                ltc.m13 = params[2];
+            }
+            ltc.update();
+        };
+
+        float params[3] = {ltc.m11, ltc.m22, ltc.m13};
+        nelderMead(params, 0.05f, 1e-5f, 100, [&](const float *p) {
+            apply(p);
+            return difference(ltc, V, alpha, 3);
+        });
+        apply(params);
+    }
+
+    // Downhill Simplex over 3 Parameters, params holds the Start and gets the Minimum
+    static float nelderMead(float *params, float delta, float tolerance, int max_iterations, const std::function<float(const float *)> &f) {
+        const int DIM = 3;
+        float points[DIM + 1][DIM];
+        float values[DIM + 1];
+
+        for (int i = 0; i <= DIM; ++i) {
+            for (int d = 0; d < DIM; ++d)
+                points[i][d] = params[d] + (i == d + 1 ? delta : 0.0f);
+            values[i] = f(points[i]);
+        }
+
+        for (int iteration = 0; iteration < max_iterations; ++iteration) {
+            int lowest = 0, highest = 0, second = 0;
+            for (int i = 1; i <= DIM; ++i) {
+                if (values[i] < values[lowest])
+                    lowest = i;
+                if (values[i] > values[highest])
+                    highest = i;
+            }
+            second = lowest;
+            for (int i = 0; i <= DIM; ++i)
+                if (i != highest && values[i] > values[second])
+                    second = i;
+
+            if (std::abs(values[highest] - values[lowest]) <= tolerance * (std::abs(values[highest]) + std::abs(values[lowest])) * 0.5f)
+                break;
+
+            // Centroid of every Point but the worst
+            float centroid[DIM] = {};
+            for (int i = 0; i <= DIM; ++i)
+                if (i != highest)
+                    for (int d = 0; d < DIM; ++d)
+                        centroid[d] += points[i][d] / DIM;
+
+            auto along = [&](float scale, float *out) {
+                for (int d = 0; d < DIM; ++d)
+                    out[d] = centroid[d] + scale * (points[highest][d] - centroid[d]);
+                return f(out);
+            };
+
+            float reflected[DIM];
+            float reflected_value = along(-1.0f, reflected);
+            if (reflected_value < values[lowest]) {
+                float expanded[DIM];
+                float expanded_value = along(-2.0f, expanded);
+                bool expand = expanded_value < reflected_value;
+                std::copy(expand ? expanded : reflected, (expand ? expanded : reflected) + DIM, points[highest]);
+                values[highest] = expand ? expanded_value : reflected_value;
+                continue;
+            }
+            if (reflected_value < values[second]) {
+                std::copy(reflected, reflected + DIM, points[highest]);
+                values[highest] = reflected_value;
+                continue;
+            }
+
+            float contracted[DIM];
+            float contracted_value = along(0.5f, contracted);
+            if (contracted_value < values[highest]) {
+                std::copy(contracted, contracted + DIM, points[highest]);
+                values[highest] = contracted_value;
+                continue;
+            }
+
+            // Shrink towards the best Point
+            for (int i = 0; i <= DIM; ++i) {
+                if (i == lowest)
+                    continue;
+                for (int d = 0; d < DIM; ++d)
+                    points[i][d] = 0.5f * (points[i][d] + points[lowest][d]);
+                values[i] = f(points[i]);
+            }
+        }
+
+        int lowest = 0;
+        for (int i = 1; i <= DIM; ++i)
+            if (values[i] < values[lowest])
+                lowest = i;
+        std::copy(points[lowest], points[lowest] + DIM, params);
+        return values[lowest];
+    }
+
+    // Form Factor of a Sphere Cap above the Horizon over its unclipped Form Factor
+    // <z: cos(elevation) of its Center, form_factor: sin^2 of its angular Radius>
+    static float clippedSphere(float z, float form_factor) {
+        if (form_factor <= 0.0f)
+            return std::max(z, 0.0f);
+
+        const int RINGS = 64;
+        const int SEGMENTS = 128;
+        float sigma = std::asin(std::sqrt(std::min(form_factor, 1.0f)));
+        glm::vec3 center = glm::vec3(std::sqrt(std::max(1.0f - z * z, 0.0f)), 0.0f, z);
+        glm::vec3 t1 = glm::vec3(z, 0.0f, -center.x);
+        glm::vec3 t2 = glm::vec3(0.0f, 1.0f, 0.0f);
+
+        double sum = 0.0;
+        for (int r = 0; r < RINGS; ++r) {
+            float angle = sigma * (r + 0.5f) / RINGS;
+            float ring = 0.0f;
+            for (int s = 0; s < SEGMENTS; ++s) {
+                float phi = 2.0f * PI * (s + 0.5f) / SEGMENTS;
+                glm::vec3 direction = std::cos(angle) * center + std::sin(angle) * (std::cos(phi) * t1 + std::sin(phi) * t2);
+                ring += std::max(direction.z, 0.0f);
+            }
+            sum += ring * std::sin(angle);
+        }
+        // Solid Angle Element sin(angle) dangle dphi, Cosine over pi
+        sum *= (sigma / RINGS) * (2.0f * PI / SEGMENTS) / PI;
+        return sum / form_factor;
+    }
+};
@@ -0,0 +1,72 @@
+// Linearly Transformed Cosine Tables for the Area Lights: fitted offline by LTCFit.cpp and shipped as Texture/LTC_GGX.bin,
+// then kept as two RGBA32F Textures the Shaders filter bilinearly
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "./LTCFit.hpp"
+#include "./Attachments.hpp"
+
+// GL_TEXTURE30 ~ 31 <after the Spot Light Shadows>
+#define LTC_MATRIX_TEXTURE_UNIT 30
+#define LTC_AMPLITUDE_TEXTURE_UNIT 31
+
+class LTCTables {
+
+public:
+    // Needs a current Context. Never fits: a missing File or another Size falls back to a plain Cosine Lobe
+    // <identity Matrix, no Horizon Clipping> until LTCFit.cpp writes the Tables again
+    LTCTables(const std::string &path = "./Texture/LTC_GGX.bin", int size = 64) {
+        this->size = size;
+
+        std::vector<glm::vec4> ltc_matrix, ltc_amplitude;
+        if (!LTCFit::Load(path, size, ltc_matrix, ltc_amplitude)) {
+            std::cout << "ERROR::LTC_TABLES::LOAD:: no " << size << " * " << size << " Tables in " << path << ", run LTCFit to generate them" << std::endl;
+            ltc_matrix.assign(size * size, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+            ltc_amplitude.assign(size * size, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+        }
+
+        matrix = createTexture(ltc_matrix);
+        amplitude = createTexture(ltc_amplitude);
+    }
+
+    void Delete() {
+        glDeleteTextures(1, &matrix);
+        glDeleteTextures(1, &amplitude);
+    }
+
+    void ShaderConfig(Shader *shader) {
+        Tools::ShaderCheck(shader);
+
+        shader->Use();
+        shader->setInt("ltc_matrix", LTC_MATRIX_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + LTC_MATRIX_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, matrix);
+        shader->setInt("ltc_amplitude", LTC_AMPLITUDE_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + LTC_AMPLITUDE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, amplitude);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    int ServeSize() { return size; }
+
+private:
+    int size;
+    unsigned int matrix = 0;
+    unsigned int amplitude = 0;
+
+    unsigned int createTexture(const std::vector<glm::vec4> &data) {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, size, size, 0, GL_RGBA, GL_FLOAT, data.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+};
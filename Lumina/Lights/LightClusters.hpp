@@ -0,0 +1,365 @@
+// Clustered Light Culling: the View Frustum is cut into depth-sliced Froxels, each holding the Lights that reach it
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LIGHT_CLUSTERS_SSE
+#endif
+
+#include "glm/glm.hpp"
+#include "./LightingManager.hpp"
+
+// Must match the Cluster Blocks in LightingPass.frag and ModelwithShadow.frag
+const int CLUSTER_X = 16;
+const int CLUSTER_Y = 9;
+const int CLUSTER_Z = 24;
+const int LIGHT_GRID_SSBO_BINDING = 4;
+const int LIGHT_INDICES_SSBO_BINDING = 5;
+
+// below this many Lights the Slices are culled on the calling Thread <waking the Workers costs more than the Culling>
+const int LIGHT_CLUSTER_PARALLEL_LIGHTS = 64;
+
+// Lights end where they drop below this fraction of their Diffuse <the Shaders cut them at the same Range>
+const float LIGHT_CLUSTER_CUTOFF = 1.0f / 256.0f;
+
+class LightClusters {
+
+public:
+    LightClusters() {
+        lists.resize(CLUSTER_X * CLUSTER_Y * CLUSTER_Z);
+        grid.resize(CLUSTER_X * CLUSTER_Y * CLUSTER_Z);
+    }
+
+    ~LightClusters() {
+        stopWorkers();
+    }
+
+    // Unshadowed Point and Spot Lights are culled against the Froxels of this View <DirLights reach every Pixel and are not clustered>
+    // Must come after LightManager::Upload so the Indices match the Lights Buffer
+    void Build(LightManager &LM, const glm::mat4 &view, float fov, float aspect, float znear, float zfar, int width, int height, int threads = 0) {
+        if (threads <= 0)
+            threads = std::max((int)std::thread::hardware_concurrency(), 1);
+        threads = std::min(threads, CLUSTER_Z);
+
+        // Froxel Bounds only change with the Projection
+        if (fov != cached_fov || aspect != cached_aspect || znear != cached_near || zfar != cached_far)
+            buildFroxels(fov, aspect, znear, zfar);
+
+        gatherSpheres(LM, view);
+
+        // Each Slice is culled by exactly one Thread so no two write the same List
+        if (threads == 1 || (int)spheres.size() < LIGHT_CLUSTER_PARALLEL_LIGHTS) {
+            for (int z = 0; z < CLUSTER_Z; ++z)
+                cullSlice(z);
+        }
+        else
+            cullParallel(threads);
+
+        // Offset / Index List
+        indices.clear();
+        for (size_t i = 0; i < lists.size(); ++i) {
+            grid[i] = glm::uvec2((unsigned int)indices.size(), (unsigned int)lists[i].size());
+            indices.insert(indices.end(), lists[i].begin(), lists[i].end());
+        }
+
+        header.dims = glm::uvec4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, 0);
+        header.params = glm::vec4(depth_scale, depth_bias, (float)width / CLUSTER_X, (float)height / CLUSTER_Y);
+        upload();
+    }
+
+    void Bind() {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_GRID_SSBO_BINDING, GridSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDICES_SSBO_BINDING, IndexSSBO);
+    }
+
+    size_t ServeIndexCount() { return indices.size(); }
+    size_t ServeCulledLights() { return spheres.size(); }
+
+    // Largest Light List of any Cluster
+    size_t ServeMaxClusterLights() {
+        size_t most = 0;
+        for (const glm::uvec2 &cluster : grid)
+            most = std::max(most, (size_t)cluster.y);
+        return most;
+    }
+
+    // Distance where a Light with Attenuation 1 / (constant + linear * d) falls under the Cutoff
+    static float Range(const LightAttrib &attrib, const Attenuation &attenuation) {
+        float brightest = std::max(attrib.diffuse.r, std::max(attrib.diffuse.g, attrib.diffuse.b));
+        if (attenuation.linear <= 0.0f)
+            return INFINITY;
+        return std::max((brightest / LIGHT_CLUSTER_CUTOFF - attenuation.constant) / attenuation.linear, 0.0f);
+    }
+
+private:
+    struct GridHeader {
+        glm::uvec4 dims;
+        glm::vec4 params;   // log-Depth Scale and Bias, Tile Size in Pixels
+    };
+
+    struct Sphere {
+        glm::vec3 center;   // View Space
+        float radius;
+        unsigned int index; // into the Lights Buffer
+        int first_slice;
+        int last_slice;
+    };
+
+    // Froxel AABBs in View Space, Structure of Arrays per Slice for the 4-wide Tests
+    std::vector<float> min_x, max_x, min_y, max_y;
+    float slice_near[CLUSTER_Z];
+    float slice_far[CLUSTER_Z];
+    float depth_scale = 0.0f;
+    float depth_bias = 0.0f;
+    float cached_fov = -1.0f, cached_aspect = -1.0f, cached_near = -1.0f, cached_far = -1.0f;
+
+    std::vector<Sphere> spheres;
+
+    // Workers live as long as the Clusters and are woken once per Build <Slices are claimed from next_slice>
+    std::vector<std::thread> workers;
+    std::mutex pool_mutex;
+    std::condition_variable pool_wake;
+    std::condition_variable pool_done;
+    unsigned long long generation = 0;  // guarded by pool_mutex
+    int busy = 0;                       // guarded by pool_mutex
+    bool stopping = false;              // guarded by pool_mutex
+    std::atomic<int> next_slice{0};
+
+    void cullSlices() {
+        for (int z = next_slice.fetch_add(1); z < CLUSTER_Z; z = next_slice.fetch_add(1))
+            cullSlice(z);
+    }
+
+    // seen is the Generation at Spawn so a restarted Worker doesn't run a finished Build again
+    void workerLoop(unsigned long long seen) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(pool_mutex);
+                pool_wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            cullSlices();
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (--busy == 0)
+                pool_done.notify_one();
+        }
+    }
+
+    // the calling Thread is one of the threads
+    void cullParallel(int threads) {
+        if ((int)workers.size() != threads - 1) {
+            stopWorkers();
+            for (int i = 1; i < threads; ++i)
+                workers.emplace_back(&LightClusters::workerLoop, this, generation);
+        }
+
+        next_slice = 0;
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            busy = (int)workers.size();
+            ++generation;
+        }
+        pool_wake.notify_all();
+        cullSlices();
+
+        std::unique_lock<std::mutex> lock(pool_mutex);
+        pool_done.wait(lock, [&]() { return busy == 0; });
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            stopping = true;
+        }
+        pool_wake.notify_all();
+        for (std::thread &thread : workers)
+            thread.join();
+        workers.clear();
+        stopping = false;
+    }
+    std::vector<std::vector<unsigned int>> lists;
+    std::vector<glm::uvec2> grid;
+    std::vector<unsigned int> indices;
+    GridHeader header;
+
+    unsigned int GridSSBO = 0;
+    unsigned int IndexSSBO = 0;
+    size_t index_capacity = 0;
+
+    // Exponential Slices: slice = log(depth) * scale + bias
+    void buildFroxels(float fov, float aspect, float znear, float zfar) {
+        cached_fov = fov;
+        cached_aspect = aspect;
+        cached_near = znear;
+        cached_far = zfar;
+
+        float ratio = std::log(zfar / znear);
+        depth_scale = CLUSTER_Z / ratio;
+        depth_bias = -CLUSTER_Z * std::log(znear) / ratio;
+
+        float tan_y = std::tan(glm::radians(fov) * 0.5f);
+        float tan_x = tan_y * aspect;
+
+        const int tiles = CLUSTER_X * CLUSTER_Y;
+        min_x.resize(tiles * CLUSTER_Z);
+        max_x.resize(tiles * CLUSTER_Z);
+        min_y.resize(tiles * CLUSTER_Z);
+        max_y.resize(tiles * CLUSTER_Z);
+
+        for (int z = 0; z < CLUSTER_Z; ++z) {
+            float dn = znear * std::pow(zfar / znear, (float)z / CLUSTER_Z);
+            float df = znear * std::pow(zfar / znear, (float)(z + 1) / CLUSTER_Z);
+            slice_near[z] = dn;
+            slice_far[z] = df;
+
+            for (int y = 0; y < CLUSTER_Y; ++y)
+                for (int x = 0; x < CLUSTER_X; ++x) {
+                    // Tile Edges in NDC, scaled out to both Slice Depths
+                    float x0 = (-1.0f + 2.0f * x / CLUSTER_X) * tan_x;
+                    float x1 = (-1.0f + 2.0f * (x + 1) / CLUSTER_X) * tan_x;
+                    float y0 = (-1.0f + 2.0f * y / CLUSTER_Y) * tan_y;
+                    float y1 = (-1.0f + 2.0f * (y + 1) / CLUSTER_Y) * tan_y;
+
+                    int i = z * tiles + y * CLUSTER_X + x;
+                    min_x[i] = std::min(x0 * dn, x0 * df);
+                    max_x[i] = std::max(x1 * dn, x1 * df);
+                    min_y[i] = std::min(y0 * dn, y0 * df);
+                    max_y[i] = std::max(y1 * dn, y1 * df);
+                }
+        }
+    }
+
+    int sliceOf(float depth) {
+        if (depth <= cached_near)
+            return 0;
+        return std::min((int)(std::log(depth) * depth_scale + depth_bias), CLUSTER_Z - 1);
+    }
+
+    // Bounding Spheres in View Space, Lights behind the Camera or past the far Plane are dropped here
+    void gatherSpheres(LightManager &LM, const glm::mat4 &view) {
+        spheres.clear();
+
+        auto add = [&](glm::vec3 center, float radius, unsigned int index) {
+            radius = std::min(radius, cached_far * 2.0f);
+            glm::vec3 position = glm::vec3(view * glm::vec4(center, 1.0f));
+            float depth = -position.z;
+            if (depth + radius < cached_near || depth - radius > cached_far)
+                return;
+            Sphere sphere;
+            sphere.center = position;
+            sphere.radius = radius;
+            sphere.index = index;
+            sphere.first_slice = sliceOf(depth - radius);
+            sphere.last_slice = sliceOf(depth + radius);
+            spheres.push_back(sphere);
+        };
+
+        // Shadowed PointLights are shaded in their own uniform Loop <Sampler Indices must stay dynamically uniform>
+        unsigned int index = LM.dirlights.size();
+        int cube = 0;
+        for (PointLight &light : LM.pointlights) {
+            if ((light.depthmap || light.shadow_layer >= 0) && cube < POINT_SHADOWS_LIMITATION) {
+                ++cube;
+                ++index;
+                continue;
+            }
+            add(light.position, Range(light.attrib, light.attenuation), index++);
+        }
+
+        // Tightest Sphere around the Cone <wide Cones are bounded by their Cap, narrow ones by the Circumsphere>
+        // Shadowed SpotLights have their own Loop as well
+        int spot = 0;
+        for (SpotLight &light : LM.spotlights) {
+            if (light.depthmap && spot < SPOTLIGHT_SHADOWS_LIMITATION) {
+                ++spot;
+                ++index;
+                continue;
+            }
+            float range = std::min(Range(light.attrib, light.attenuation), cached_far * 2.0f);
+            float angle = glm::radians(light.outtercutoff);
+            glm::vec3 direction = glm::normalize(light.direction);
+            if (angle > glm::radians(45.0f))
+                add(light.position + direction * range * std::cos(angle), range * std::sin(angle), index++);
+            else
+                add(light.position + direction * (range * 0.5f / std::cos(angle)), range * 0.5f / std::cos(angle), index++);
+        }
+    }
+
+    void cullSlice(int z) {
+        const int tiles = CLUSTER_X * CLUSTER_Y;
+        int base = z * tiles;
+        for (int i = 0; i < tiles; ++i)
+            lists[base + i].clear();
+
+        for (const Sphere &sphere : spheres) {
+            if (z < sphere.first_slice || z > sphere.last_slice)
+                continue;
+
+            // Depth Distance is shared by the whole Slice
+            float depth = -sphere.center.z;
+            float dz = std::max(slice_near[z] - depth, 0.0f) + std::max(depth - slice_far[z], 0.0f);
+            float remain = sphere.radius * sphere.radius - dz * dz;
+            if (remain < 0.0f)
+                continue;
+
+#ifdef LIGHT_CLUSTERS_SSE
+            __m128 cx = _mm_set1_ps(sphere.center.x);
+            __m128 cy = _mm_set1_ps(sphere.center.y);
+            __m128 limit = _mm_set1_ps(remain);
+            __m128 zero = _mm_setzero_ps();
+            for (int i = 0; i < tiles; i += 4) {
+                __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&min_x[base + i]), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&max_x[base + i])), zero));
+                __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&min_y[base + i]), cy), zero), _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&max_y[base + i])), zero));
+                __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                int mask = _mm_movemask_ps(_mm_cmple_ps(distance, limit));
+                for (int lane = 0; mask; ++lane, mask >>= 1)
+                    if (mask & 1)
+                        lists[base + i + lane].push_back(sphere.index);
+            }
+#else
+            for (int i = 0; i < tiles; ++i) {
+                float dx = std::max(min_x[base + i] - sphere.center.x, 0.0f) + std::max(sphere.center.x - max_x[base + i], 0.0f);
+                float dy = std::max(min_y[base + i] - sphere.center.y, 0.0f) + std::max(sphere.center.y - max_y[base + i], 0.0f);
+                if (dx * dx + dy * dy <= remain)
+                    lists[base + i].push_back(sphere.index);
+            }
+#endif
+        }
+    }
+
+    void upload() {
+        if (!GridSSBO) {
+            glGenBuffers(1, &GridSSBO);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, GridSSBO);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GridHeader) + grid.size() * sizeof(glm::uvec2), NULL, GL_DYNAMIC_DRAW);
+            glGenBuffers(1, &IndexSSBO);
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, GridSSBO);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GridHeader), &header);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GridHeader), grid.size() * sizeof(glm::uvec2), grid.data());
+
+        // Index List grows in Powers of two, never empty so the Binding stays valid
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, IndexSSBO);
+        if (indices.size() > index_capacity || index_capacity == 0) {
+            index_capacity = std::max(index_capacity, (size_t)1024);
+            while (index_capacity < indices.size())
+                index_capacity *= 2;
+            glBufferData(GL_SHADER_STORAGE_BUFFER, index_capacity * sizeof(unsigned int), NULL, GL_DYNAMIC_DRAW);
+        }
+        if (!indices.empty())
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+};
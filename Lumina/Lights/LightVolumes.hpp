@@ -0,0 +1,168 @@
+// Deferred Light Volumes: unshadowed Point Lights draw a Sphere and Spot Lights a Cone sized from their Attenuation,
+// shading only the G-Buffer Pixels inside the Volume and adding onto the HDR Target
+#pragma once
+
+#include <vector>
+#include <cmath>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
+#include "./LightingManager.hpp"
+
+// Stencil Value the Geometry Pass writes wherever there is Geometry <Sky Pixels are never shaded>
+const int LIGHT_VOLUME_STENCIL = 1;
+
+class LightVolumes {
+
+public:
+    // Needs a current Context
+    LightVolumes(int segments = 16) {
+        buildSphere(segments);
+        buildCone(segments);
+    }
+
+    void Delete() {
+        glDeleteVertexArrays(1, &sphere.VAO);
+        glDeleteBuffers(1, &sphere.VBO);
+        glDeleteBuffers(1, &sphere.EBO);
+        glDeleteVertexArrays(1, &cone.VAO);
+        glDeleteBuffers(1, &cone.VBO);
+        glDeleteBuffers(1, &cone.EBO);
+    }
+
+    // Expects the Lighting FrameBuffer bound with the G-Buffer Depth and Stencil blitted in,
+    // and LightManager::ShaderConfig already called this Frame so the Lights Buffer is current
+    // <G-Buffer and SSAO Textures are configured on the Shader by the Caller>
+    void Draw(LightManager &LM, Shader *shader, float max_range) {
+        Tools::ShaderCheck(shader);
+
+        int points = LM.pointlights.size();
+        int spots = LM.spotlights.size();
+        if (points + spots == 0)
+            return;
+
+        shader->Use();
+        shader->setFloat("max_range", max_range);
+
+        // Back Faces behind the Surface: Pixels in Front of the far Side of the Volume <works from inside the Volume too>
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GEQUAL);
+        glDepthMask(GL_FALSE);
+        // Volumes past the far Plane keep their Back Faces
+        glEnable(GL_DEPTH_CLAMP);
+
+        glEnable(GL_STENCIL_TEST);
+        glStencilFunc(GL_EQUAL, LIGHT_VOLUME_STENCIL, 0xFF);
+        glStencilMask(0x00);
+
+        // Additive into the HDR Target
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        // Spheres cover Point Lights and wide Spot Lights, Cones the rest <the Vertex Shader drops the other Instances>
+        shader->setInt("first_light", LM.dirlights.size());
+        shader->setInt("volume_type", 0);
+        glBindVertexArray(sphere.VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, sphere.count, GL_UNSIGNED_INT, 0, points + spots);
+
+        if (spots > 0) {
+            shader->setInt("first_light", LM.dirlights.size() + points);
+            shader->setInt("volume_type", 1);
+            glBindVertexArray(cone.VAO);
+            glDrawElementsInstanced(GL_TRIANGLES, cone.count, GL_UNSIGNED_INT, 0, spots);
+        }
+        glBindVertexArray(0);
+
+        // Back to the Render16 Defaults
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glStencilMask(0xFF);
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_DEPTH_CLAMP);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LEQUAL);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+    }
+
+private:
+    struct Volume {
+        unsigned int VAO = 0;
+        unsigned int VBO = 0;
+        unsigned int EBO = 0;
+        int count = 0;
+    };
+
+    Volume sphere;
+    Volume cone;
+
+    // Unit Sphere pushed out so its flat Faces enclose the round one
+    void buildSphere(int segments) {
+        int stacks = segments / 2;
+        float grow = 1.0f / (std::cos(glm::pi<float>() / segments) * std::cos(glm::pi<float>() / (2 * stacks)));
+
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        for (int stack = 0; stack <= stacks; ++stack) {
+            float phi = glm::pi<float>() * stack / stacks;
+            for (int slice = 0; slice <= segments; ++slice) {
+                float theta = 2.0f * glm::pi<float>() * slice / segments;
+                positions.push_back(grow * glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)));
+            }
+        }
+
+        // Counter-Clockwise seen from outside
+        for (int stack = 0; stack < stacks; ++stack)
+            for (int slice = 0; slice < segments; ++slice) {
+                unsigned int a = stack * (segments + 1) + slice;
+                unsigned int b = a + segments + 1;
+                indices.insert(indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+            }
+
+        upload(sphere, positions, indices);
+    }
+
+    // Apex at the Origin opening along +Z to a Base of Radius 1 at z = 1
+    void buildCone(int segments) {
+        float grow = 1.0f / std::cos(glm::pi<float>() / segments);
+
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        positions.push_back(glm::vec3(0.0f));
+        positions.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+        for (int slice = 0; slice < segments; ++slice) {
+            float theta = 2.0f * glm::pi<float>() * slice / segments;
+            positions.push_back(glm::vec3(grow * std::cos(theta), grow * std::sin(theta), 1.0f));
+        }
+
+        for (int slice = 0; slice < segments; ++slice) {
+            unsigned int a = 2 + slice;
+            unsigned int b = 2 + (slice + 1) % segments;
+            indices.insert(indices.end(), {0, b, a});     // Side
+            indices.insert(indices.end(), {1, a, b});     // Base
+        }
+
+        upload(cone, positions, indices);
+    }
+
+    void upload(Volume &volume, const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices) {
+        volume.count = indices.size();
+
+        glGenVertexArrays(1, &volume.VAO);
+        glGenBuffers(1, &volume.VBO);
+        glGenBuffers(1, &volume.EBO);
+
+        glBindVertexArray(volume.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, volume.VBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, volume.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
@@ -1,10 +1,26 @@
 #pragma once
 
 #include <vector>
+#include <cstring>
+#include <algorithm>
 
 #include "./DirLight.hpp"
 #include "./PointLight.hpp"
 #include "./SpotLight.hpp"
+#include "./AreaLight.hpp"
+
+// Binding Point of the Lights Storage Block <matches layout (binding = 3) in the Shaders>
+#define LIGHTS_SSBO_BINDING 3
+// Area Lights have their own Block <matches layout (binding = 6)>, every Pixel evaluates all of them
+#define AREA_LIGHTS_SSBO_BINDING 6
+
+// Shadow Map Limits <GL_TEXTURE7 ~ 16 used for ShadowMapping>
+#define DIRLIGHT_SHADOWS_LIMITATION 2
+#define POINT_SHADOWS_LIMITATION 8
+#define SHADOW_TEXTURE_UNIT 7
+// Spot Light Shadows share one Depth Texture <the Shadow Atlas>, Matrices and Regions go up as Uniforms
+#define SPOTLIGHT_SHADOWS_LIMITATION 4
+#define SPOT_SHADOW_TEXTURE_UNIT 29
 
 class LightManager{
 
@@ -12,6 +28,7 @@ public:
     std::vector<DirLight> dirlights;
     std::vector<PointLight> pointlights;
     std::vector<SpotLight> spotlights;
+    std::vector<AreaLight> arealights;
 
     int lights_num = 0;
 
@@ -19,70 +36,261 @@ public:
         this->lights_num = dirlights.size() + pointlights.size() + spotlights.size();
     }
 
-    void ShaderConfig(Shader *shader) {
-        Tools::ShaderCheck(shader);
-
-        shader->Use();
-
-        // LightInfo Block
-        shader->setInt("lightinfo.num_dirlight", dirlights.size());
-        shader->setInt("lightinfo.num_pointlight", pointlights.size());
-        shader->setInt("lightinfo.num_spotlight", spotlights.size());
+    // Packs every Light and sends only the Slots that changed since the last Upload
+    // <in-place Edits on the public Vectors are picked up by comparing the packed Data>
+    void Upload() {
+        CountLight();
+        pack();
 
-        for (int slot = 0; slot < dirlights.size(); ++slot)
-            shader->setMat4("lightinfo.DirLight_Transform[" + std::to_string(slot) + "]", dirlights.at(slot).lightMatrix);
+        if (!ssbo)
+            glGenBuffers(1, &ssbo);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
 
-        // DirLights
-        for (int slot = 0; slot < dirlights.size(); ++slot) {
-            shader->setVec3("dirlights[" + std::to_string(slot) + "].direction", dirlights.at(slot).direction);
-            shader->setVec3("dirlights[" + std::to_string(slot) + "].attrib.ambient", dirlights.at(slot).attrib.ambient);
-            shader->setVec3("dirlights[" + std::to_string(slot) + "].attrib.diffuse", dirlights.at(slot).attrib.diffuse);
-            shader->setVec3("dirlights[" + std::to_string(slot) + "].attrib.specular", dirlights.at(slot).attrib.specular);
+        // Grow to the next Power of two, everything goes up with the new Storage
+        if (packed.size() > capacity) {
+            capacity = 64;
+            while (capacity < packed.size())
+                capacity *= 2;
+            glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPUHeader) + capacity * sizeof(GPULight), NULL, GL_DYNAMIC_DRAW);
+            uploaded.clear();
+            header_valid = false;
         }
 
-        // PointLights
-        for (int slot = 0; slot < pointlights.size(); ++slot) {
-            shader->setVec3("pointlights[" + std::to_string(slot) + "].position", pointlights.at(slot).position);
-            shader->setFloat("pointlights[" + std::to_string(slot) + "].far", pointlights.at(slot).far);
-            shader->setVec3("pointlights[" + std::to_string(slot) + "].attrib.ambient", pointlights.at(slot).attrib.ambient);
-            shader->setVec3("pointlights[" + std::to_string(slot) + "].attrib.diffuse", pointlights.at(slot).attrib.diffuse);
-            shader->setVec3("pointlights[" + std::to_string(slot) + "].attrib.specular", pointlights.at(slot).attrib.specular);
-            shader->setFloat("pointlights[" + std::to_string(slot) + "].attenuation.constant", pointlights.at(slot).attenuation.constant);
-            shader->setFloat("pointlights[" + std::to_string(slot) + "].attenuation.linear", pointlights.at(slot).attenuation.linear);
+        if (!header_valid || std::memcmp(&header, &uploaded_header, sizeof(GPUHeader)) != 0) {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GPUHeader), &header);
+            uploaded_header = header;
+            header_valid = true;
         }
 
-        // SpotLight
-        for (int slot = 0; slot < spotlights.size(); ++slot) {
-            shader->setVec3("spotlights[" + std::to_string(slot) + "].direction", spotlights.at(slot).direction);
-            shader->setVec3("spotlights[" + std::to_string(slot) + "].position", spotlights.at(slot).position);
-            shader->setVec3("spotlights[" + std::to_string(slot) + "].attrib.ambient", spotlights.at(slot).attrib.ambient);
-            shader->setVec3("spotlights[" + std::to_string(slot) + "].attrib.diffuse", spotlights.at(slot).attrib.diffuse);
-            shader->setVec3("spotlights[" + std::to_string(slot) + "].attrib.specular", spotlights.at(slot).attrib.specular);
-            shader->setFloat("spotlights[" + std::to_string(slot) + "].attenuation.constant", spotlights.at(slot).attenuation.constant);
-            shader->setFloat("spotlights[" + std::to_string(slot) + "].attenuation.linear", spotlights.at(slot).attenuation.linear);
-
-            shader->setFloat("spotlights[" + std::to_string(slot) + "].cutoff", glm::cos(glm::radians(spotlights.at(slot).cutoff)));
-            shader->setFloat("spotlights[" + std::to_string(slot) + "].outer_cutoff", glm::cos(glm::radians(spotlights.at(slot).outtercutoff)));
+        // Contiguous dirty Runs go up in one Call each
+        size_t slot = 0;
+        last_uploaded = 0;
+        while (slot < packed.size()) {
+            if (!dirty(slot)) {
+                ++slot;
+                continue;
+            }
+
+            size_t end = slot + 1;
+            while (end < packed.size() && dirty(end))
+                ++end;
+
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GPUHeader) + slot * sizeof(GPULight), (end - slot) * sizeof(GPULight), &packed[slot]);
+            if (uploaded.size() < end)
+                uploaded.resize(end);
+            std::copy(packed.begin() + slot, packed.begin() + end, uploaded.begin() + slot);
+            last_uploaded += end - slot;
+            slot = end;
         }
 
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        uploadAreaLights();
+    }
+
+    void ShaderConfig(Shader *shader) {
+        Tools::ShaderCheck(shader);
+
+        Upload();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHTS_SSBO_BINDING, ssbo);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, AREA_LIGHTS_SSBO_BINDING, area_ssbo);
+
+        shader->Use();
+
         // Shadow Maps Bindings
-        // GL_TEXTURE7 ~ 16 used for ShadowMapping
         int slot = 0;
-        for (int i = 0; i < dirlights.size(); ++i) {
-            ++slot;
-            shader->setInt("dirlights[" + std::to_string(i) + "].shadowmap", 7 + slot);
-            glActiveTexture(GL_TEXTURE7 + slot);
+        for (int i = 0; i < dirlights.size() && slot < DIRLIGHT_SHADOWS_LIMITATION; ++i) {
+            if (!dirlights.at(i).depthmap)
+                continue;
+            shader->setInt("dirlight_shadowmaps[" + std::to_string(slot) + "]", SHADOW_TEXTURE_UNIT + slot);
+            glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT + slot);
             glBindTexture(GL_TEXTURE_2D, dirlights.at(i).depthmap);
-        }
-        
-        for (int i = 0; i < pointlights.size(); ++i) {
             ++slot;
-            shader->setInt("pointlights[" + std::to_string(i) + "].shadowmap", 7 + slot);
-            glActiveTexture(GL_TEXTURE7 + slot);
+        }
+
+        // Slots count the Cube Map Array Lights too, their Arrays are bound by PointShadows
+        int cube = 0;
+        for (int i = 0; i < pointlights.size() && cube < POINT_SHADOWS_LIMITATION; ++i) {
+            if (!pointlights.at(i).depthmap && pointlights.at(i).shadow_layer < 0)
+                continue;
+            if (!pointlights.at(i).depthmap) {
+                ++cube;
+                continue;
+            }
+            shader->setInt("pointlight_shadowmaps[" + std::to_string(cube) + "]", SHADOW_TEXTURE_UNIT + DIRLIGHT_SHADOWS_LIMITATION + cube);
+            glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT + DIRLIGHT_SHADOWS_LIMITATION + cube);
             glBindTexture(GL_TEXTURE_CUBE_MAP, pointlights.at(i).depthmap);
+            ++cube;
         }
 
+        // Shadowed SpotLights are listed by Slot like the PointLights
+        int spot = 0;
+        unsigned int spot_depthmap = 0;
+        for (int i = 0; i < spotlights.size() && spot < SPOTLIGHT_SHADOWS_LIMITATION; ++i) {
+            SpotLight &light = spotlights.at(i);
+            if (!light.depthmap)
+                continue;
+            // ShaderConfig runs every Frame, the Warning only once
+            if (spot_depthmap && light.depthmap != spot_depthmap && !spot_map_warned) {
+                spot_map_warned = true;
+                std::cout << "ERROR::LIGHT_MANAGER::SHADER_CONFIG:: SpotLight " << i << " has its own Shadow Map, only one is bound." << std::endl;
+            }
+            spot_depthmap = spot_depthmap ? spot_depthmap : light.depthmap;
+
+            shader->setInt("spotshadow_lights[" + std::to_string(spot) + "]", i);
+            shader->setMat4("spotshadow_transforms[" + std::to_string(spot) + "]", light.lightMatrix);
+            shader->setVec4("spotshadow_atlas[" + std::to_string(spot) + "]", light.atlas);
+            ++spot;
+        }
+        shader->setInt("spotshadow_count", spot);
+        shader->setInt("spotlight_shadowmap", SPOT_SHADOW_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + SPOT_SHADOW_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, spot_depthmap);
+
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
-};
\ No newline at end of file
+
+    unsigned int ServeBuffer() { return ssbo; }
+    size_t ServeUploadedSlots() { return last_uploaded; }
+
+private:
+    // std430 Layouts of the Lights Block
+    struct GPUHeader {
+        int num_dirlight;
+        int num_pointlight;
+        int num_spotlight;
+        int num_pointshadow;
+        glm::mat4 DirLight_Transform[DIRLIGHT_SHADOWS_LIMITATION];
+        int shadow_pointlights[POINT_SHADOWS_LIMITATION];
+    };
+
+    struct GPULight {
+        glm::vec4 position;     // w: far <point> | cos(outer_cutoff) <spot>, Shadow Atlas Region <dir>
+        glm::vec4 direction;    // w: shadow slot, -1 without <point: xy Cube Map Array Tier and Layer>
+        glm::vec4 ambient;      // a: attenuation constant
+        glm::vec4 diffuse;      // a: attenuation linear
+        glm::vec4 specular;     // a: cos(cutoff)
+    };
+
+    // std430 Layout of the AreaLights Block <the Count is padded to a vec4>
+    struct GPUAreaLight {
+        glm::vec4 position;     // w: shape
+        glm::vec4 right;        // w: two sided
+        glm::vec4 up;
+        glm::vec4 ambient;
+        glm::vec4 diffuse;
+        glm::vec4 specular;
+    };
+
+    unsigned int ssbo = 0;
+    size_t capacity = 0;
+    size_t last_uploaded = 0;
+
+    GPUHeader header;
+    GPUHeader uploaded_header;
+    bool header_valid = false;
+
+    std::vector<GPULight> packed;
+    std::vector<GPULight> uploaded;     // Copy of what the Buffer holds
+
+    unsigned int area_ssbo = 0;
+    std::vector<GPUAreaLight> area_packed;
+    std::vector<GPUAreaLight> area_uploaded;
+    bool area_valid = false;
+
+    bool spot_map_warned = false;
+
+    // Few enough to go up whole whenever one changed
+    void uploadAreaLights() {
+        area_packed.clear();
+        for (AreaLight &light : arealights)
+            area_packed.push_back({
+                glm::vec4(light.position, (float)light.shape),
+                glm::vec4(light.right, light.two_sided ? 1.0f : 0.0f),
+                glm::vec4(light.up, 0.0f),
+                glm::vec4(light.attrib.ambient, 0.0f),
+                glm::vec4(light.attrib.diffuse, 0.0f),
+                glm::vec4(light.attrib.specular, 0.0f)
+            });
+
+        if (area_valid && area_packed.size() == area_uploaded.size() &&
+            std::memcmp(area_packed.data(), area_uploaded.data(), area_packed.size() * sizeof(GPUAreaLight)) == 0)
+            return;
+
+        if (!area_ssbo)
+            glGenBuffers(1, &area_ssbo);
+        glm::ivec4 count = glm::ivec4((int)area_packed.size(), 0, 0, 0);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, area_ssbo);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::ivec4) + area_packed.size() * sizeof(GPUAreaLight), NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(glm::ivec4), &count);
+        if (!area_packed.empty())
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::ivec4), area_packed.size() * sizeof(GPUAreaLight), area_packed.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        area_uploaded = area_packed;
+        area_valid = true;
+    }
+
+    bool dirty(size_t slot) {
+        if (slot >= uploaded.size())
+            return true;
+        return std::memcmp(&packed[slot], &uploaded[slot], sizeof(GPULight)) != 0;
+    }
+
+    void pack() {
+        std::memset(&header, 0, sizeof(GPUHeader));
+        header.num_dirlight = dirlights.size();
+        header.num_pointlight = pointlights.size();
+        header.num_spotlight = spotlights.size();
+
+        packed.resize(lights_num);
+
+        size_t index = 0;
+        int slot = 0;
+        for (int i = 0; i < dirlights.size(); ++i) {
+            DirLight &light = dirlights.at(i);
+            bool shadowed = light.depthmap && slot < DIRLIGHT_SHADOWS_LIMITATION;
+            // Transforms follow the Light index, the Shader reads DirLight_Transform[i]
+            if (i < DIRLIGHT_SHADOWS_LIMITATION)
+                header.DirLight_Transform[i] = light.lightMatrix;
+
+            packed[index++] = {
+                light.atlas,
+                glm::vec4(light.direction, shadowed ? slot++ : -1),
+                glm::vec4(light.attrib.ambient, 0.0f),
+                glm::vec4(light.attrib.diffuse, 0.0f),
+                glm::vec4(light.attrib.specular, 0.0f)
+            };
+        }
+
+        int cube = 0;
+        for (int i = 0; i < pointlights.size(); ++i) {
+            PointLight &light = pointlights.at(i);
+            bool shadowed = (light.depthmap || light.shadow_layer >= 0) && cube < POINT_SHADOWS_LIMITATION;
+            // Shadowed PointLights are also listed by Slot so Shaders can walk them in a uniform Loop
+            if (shadowed)
+                header.shadow_pointlights[cube] = i;
+            packed[index++] = {
+                glm::vec4(light.position, light.far),
+                glm::vec4(light.shadow_tier, light.shadow_layer, 0.0f, shadowed ? cube++ : -1),
+                glm::vec4(light.attrib.ambient, light.attenuation.constant),
+                glm::vec4(light.attrib.diffuse, light.attenuation.linear),
+                glm::vec4(light.attrib.specular, 0.0f)
+            };
+        }
+        header.num_pointshadow = cube;
+
+        int spot = 0;
+        for (SpotLight &light : spotlights) {
+            bool shadowed = light.depthmap && spot < SPOTLIGHT_SHADOWS_LIMITATION;
+            packed[index++] = {
+                glm::vec4(light.position, glm::cos(glm::radians(light.outtercutoff))),
+                glm::vec4(light.direction, shadowed ? spot++ : -1),
+                glm::vec4(light.attrib.ambient, light.attenuation.constant),
+                glm::vec4(light.attrib.diffuse, light.attenuation.linear),
+                glm::vec4(light.attrib.specular, glm::cos(glm::radians(light.cutoff)))
+            };
+        }
+    }
+};
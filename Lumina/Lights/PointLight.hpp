@@ -11,6 +11,9 @@ public:
     Attenuation attenuation;
     unsigned int depthmap;
     float far;
+    // Cube Map Array Tier and Layer given by PointShadows, -1 without
+    int shadow_tier = -1;
+    int shadow_layer = -1;
 
     PointLight(LightAttrib attrib, glm::vec3 pos, Attenuation attenuation, unsigned int depth, float far_plane) {
         this->attrib = attrib;
@@ -0,0 +1,356 @@
+// Point Light Shadows in Cube Map Arrays: one Array per Resolution Tier, each shadowed Light takes a Layer
+// of the Tier its Screen Coverage asks for. Faces are culled on the CPU and only redrawn when what they see changed
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "./LightingManager.hpp"
+#include "./LightClusters.hpp"
+#include "./ShadowCulling.hpp"
+#include "../Shaders/Model.hpp"
+
+// Tiers halve the Resolution and double the Layers <matches POINT_SHADOW_TIERS in the Shaders>
+#define POINT_SHADOW_TIERS 3
+// Coverage has to pass a Tier Threshold by this Fraction before a Light changes its wanted Tier
+#define POINT_SHADOW_HYSTERESIS 0.15f
+// GL_TEXTURE9 ~ 11 <the Units the per-Light Cube Maps used to take>
+#define POINT_SHADOW_TEXTURE_UNIT 9
+
+class PointShadows {
+
+public:
+    // Needs a current Context, Tier 0 is resolution * resolution with layers Lights
+    PointShadows(int resolution = 1024, int layers = 2, float near = 0.1f) {
+        this->near = near;
+        for (int t = 0; t < POINT_SHADOW_TIERS; ++t) {
+            Tier &tier = tiers[t];
+            tier.resolution = std::max(resolution >> t, 16);
+            tier.owners.assign(layers << t, -1);
+
+            glGenTextures(1, &tier.texture);
+            glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tier.texture);
+            glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 1, GL_DEPTH_COMPONENT24, tier.resolution, tier.resolution, 6 * tier.owners.size());
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+        glGenFramebuffers(1, &fbo);
+    }
+
+    void Delete() {
+        for (Tier &tier : tiers)
+            glDeleteTextures(1, &tier.texture);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    int AddCaster(Model *model, glm::mat4 transform) {
+        casters.push_back({model, transform, 0, {}});
+        bound(casters.back());
+        return casters.size() - 1;
+    }
+
+    // Only Faces that saw the Caster before or see it now are redrawn
+    void MoveCaster(int caster, glm::mat4 transform) {
+        Caster &acaster = casters.at(caster);
+        if (std::memcmp(&acaster.transform, &transform, sizeof(glm::mat4)) == 0)
+            return;
+        acaster.transform = transform;
+        ++acaster.version;
+        bound(acaster);
+    }
+
+    // pointlight: index in LightManager::pointlights
+    void AddLight(int pointlight) {
+        lights.push_back(ShadowLight());
+        lights.back().pointlight = pointlight;
+    }
+
+    void RemoveLight(LightManager &LM, int pointlight) {
+        for (size_t i = 0; i < lights.size(); ++i)
+            if (lights[i].pointlight == pointlight) {
+                release(lights[i]);
+                if (pointlight < (int)LM.pointlights.size())
+                    detach(LM.pointlights.at(pointlight));
+                lights.erase(lights.begin() + i);
+                return;
+            }
+    }
+
+    // Picks each Light's Tier from how big its Range looks on Screen, then redraws the Faces that changed
+    // <depth_shader: PointDepth> Leaves the Default FrameBuffer bound, the Caller resets the Viewport
+    void Update(LightManager &LM, glm::vec3 viewpos, float fov, int screen_height, Shader *depth_shader) {
+        Tools::ShaderCheck(depth_shader);
+
+        last_faces = 0;
+        assignTiers(LM, viewpos, fov, screen_height);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_TRUE);
+        depth_shader->Use();
+
+        std::vector<Seen> seen;
+        for (ShadowLight &slight : lights) {
+            if (slight.layer < 0)
+                continue;
+            PointLight &light = LM.pointlights.at(slight.pointlight);
+            attach(light, slight);
+
+            // Moving the Light or its Range redraws every Face
+            if (light.position != slight.position || light.far != slight.far) {
+                slight.position = light.position;
+                slight.far = light.far;
+                for (int face = 0; face < 6; ++face)
+                    slight.valid[face] = false;
+            }
+
+            Tier &tier = tiers[slight.tier];
+            glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, near, slight.far);
+            for (int face = 0; face < 6; ++face) {
+                cullFace(slight, face, seen);
+                if (slight.valid[face] && seen == slight.seen[face])
+                    continue;
+                slight.seen[face] = seen;
+                slight.valid[face] = true;
+                ++last_faces;
+
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tier.texture, 0, 6 * slight.layer + face);
+                glViewport(0, 0, tier.resolution, tier.resolution);
+                glClear(GL_DEPTH_BUFFER_BIT);
+
+                depth_shader->setMat4("Face_Matrix", projection * glm::lookAt(slight.position, slight.position + FaceAxes[face][0], FaceAxes[face][1]));
+                depth_shader->setVec3("LightPos", slight.position);
+                depth_shader->setFloat("Far", slight.far);
+                for (const Seen &aseen : seen) {
+                    Caster &caster = casters[aseen.caster];
+                    depth_shader->setMat4("model", caster.transform);
+                    caster.model->DrawDepth(aseen.mesh);
+                }
+            }
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void ShaderConfig(Shader *shader) {
+        Tools::ShaderCheck(shader);
+
+        shader->Use();
+        for (int t = 0; t < POINT_SHADOW_TIERS; ++t) {
+            shader->setInt("pointshadow_arrays[" + std::to_string(t) + "]", POINT_SHADOW_TEXTURE_UNIT + t);
+            glActiveTexture(GL_TEXTURE0 + POINT_SHADOW_TEXTURE_UNIT + t);
+            glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tiers[t].texture);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    int ServeFaceRedraws() { return last_faces; }
+    // Meshes the Light's six Faces drew at their last Redraw, -1 without a Layer
+    int ServeLightCasters(int pointlight) {
+        for (ShadowLight &slight : lights)
+            if (slight.pointlight == pointlight && slight.layer >= 0) {
+                int count = 0;
+                for (int face = 0; face < 6; ++face)
+                    count += slight.seen[face].size();
+                return count;
+            }
+        return -1;
+    }
+    int ServeTierResolution(int tier) { return tiers[tier].resolution; }
+    int ServeTierUsed(int tier) { return std::count_if(tiers[tier].owners.begin(), tiers[tier].owners.end(), [](int owner) { return owner >= 0; }); }
+
+private:
+    struct Caster {
+        Model *model;
+        glm::mat4 transform;
+        unsigned int version;
+        std::vector<ShadowCulling::Bounds> bounds;      // World AABB per Mesh
+    };
+
+    // a Mesh one Face drew, with the Version of its Caster at that Time
+    struct Seen {
+        int caster;
+        int mesh;
+        unsigned int version;
+
+        bool operator==(const Seen &other) const {
+            return caster == other.caster && mesh == other.mesh && version == other.version;
+        }
+    };
+
+    struct ShadowLight {
+        int pointlight = -1;
+        int wanted = -1;            // Tier the Coverage asks for
+        int tier = -1;              // Tier granted, another one while the wanted Tier is full
+        int layer = -1;
+        float coverage = 0.0f;      // Pixels the Light's Range spans on Screen
+
+        glm::vec3 position = glm::vec3(0.0f);
+        float far = 0.0f;
+        bool valid[6] = {};
+        std::vector<Seen> seen[6];
+    };
+
+    struct Tier {
+        int resolution = 0;
+        unsigned int texture = 0;
+        std::vector<int> owners;    // Light of each Layer, -1 when free
+    };
+
+    // Direction and Up of each Face in GL_TEXTURE_CUBE_MAP_POSITIVE_X Order
+    inline static const glm::vec3 FaceAxes[6][2] = {
+        {glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)},
+        {glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)},
+        {glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)},
+        {glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)},
+        {glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)},
+        {glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f)}
+    };
+
+    Tier tiers[POINT_SHADOW_TIERS];
+    unsigned int fbo = 0;
+    float near;
+
+    std::vector<Caster> casters;
+    std::vector<ShadowLight> lights;
+
+    int last_faces = 0;
+
+    void bound(Caster &caster) {
+        ShadowCulling::MeshBounds(caster.model, caster.transform, caster.bounds);
+    }
+
+    // a Face sees rel with dot(axis, rel) >= |dot(side, rel)| for both Sides, inside the far Sphere
+    // <the Face's Frustum without its near Plane, so Casters right at the Light still count>
+    void cullFace(const ShadowLight &slight, int face, std::vector<Seen> &seen) {
+        glm::vec3 axis = FaceAxes[face][0];
+        glm::vec3 side_u = FaceAxes[face][1];
+        glm::vec3 side_v = glm::cross(axis, side_u);
+        glm::vec3 planes[4] = {axis - side_u, axis + side_u, axis - side_v, axis + side_v};
+
+        seen.clear();
+        for (size_t c = 0; c < casters.size(); ++c)
+            for (size_t m = 0; m < casters[c].bounds.size(); ++m) {
+                const ShadowCulling::Bounds &bounds = casters[c].bounds[m];
+                glm::vec3 center = (bounds.first + bounds.second) * 0.5f - slight.position;
+                glm::vec3 half = (bounds.second - bounds.first) * 0.5f;
+
+                glm::vec3 closest = glm::clamp(glm::vec3(0.0f), center - half, center + half);
+                if (glm::dot(closest, closest) > slight.far * slight.far)
+                    continue;
+
+                bool inside = true;
+                for (glm::vec3 &plane : planes)
+                    if (glm::dot(plane, center) + glm::dot(glm::abs(plane), half) < 0.0f) {
+                        inside = false;
+                        break;
+                    }
+                if (inside)
+                    seen.push_back({(int)c, (int)m, casters[c].version});
+            }
+    }
+
+    // Biggest Lights get first Pick, a full Tier hands its Light down to the next smaller one
+    void assignTiers(LightManager &LM, glm::vec3 viewpos, float fov, int screen_height) {
+        float tan_half_fov = std::tan(glm::radians(fov) * 0.5f);
+        std::vector<ShadowLight *> order;
+
+        for (ShadowLight &slight : lights) {
+            PointLight &light = LM.pointlights.at(slight.pointlight);
+            float radius = std::min(LightClusters::Range(light.attrib, light.attenuation), light.far);
+            float distance = glm::length(light.position - viewpos);
+            slight.coverage = distance <= radius ? (float)screen_height : std::min(radius / (distance * tan_half_fov), 1.0f) * screen_height;
+
+            // Only a changed wanted Tier gives the Layer back, a Fallback Layer is kept while the wanted Tier is full
+            int wanted = wantedTier(slight);
+            if (slight.wanted != wanted) {
+                release(slight);
+                slight.wanted = wanted;
+            }
+            order.push_back(&slight);
+        }
+
+        std::sort(order.begin(), order.end(), [](ShadowLight *a, ShadowLight *b) { return a->coverage > b->coverage; });
+        for (ShadowLight *slight : order) {
+            // a Fallback moves up once its wanted Tier has room again
+            if (slight->layer >= 0 && slight->tier != slight->wanted && hasFreeLayer(slight->wanted))
+                release(*slight);
+            if (slight->layer >= 0)
+                continue;
+
+            for (int t = slight->wanted; t < POINT_SHADOW_TIERS && slight->layer < 0; ++t)
+                allocate(*slight, t);
+            for (int t = slight->wanted - 1; t >= 0 && slight->layer < 0; --t)
+                allocate(*slight, t);
+
+            if (slight->layer < 0)
+                detach(LM.pointlights.at(slight->pointlight));
+        }
+    }
+
+    // Coarsest Tier still holding one Texel per covered Pixel
+    int tierFor(float coverage) {
+        int tier = 0;
+        while (tier + 1 < POINT_SHADOW_TIERS && tiers[tier + 1].resolution >= coverage)
+            ++tier;
+        return tier;
+    }
+
+    // the current wanted Tier holds until the Coverage is POINT_SHADOW_HYSTERESIS past either of its Thresholds
+    int wantedTier(const ShadowLight &slight) {
+        if (slight.wanted < 0)
+            return tierFor(slight.coverage);
+        int finest = tierFor(slight.coverage * (1.0f + POINT_SHADOW_HYSTERESIS));
+        int coarsest = tierFor(slight.coverage / (1.0f + POINT_SHADOW_HYSTERESIS));
+        return std::clamp(slight.wanted, finest, coarsest);
+    }
+
+    bool hasFreeLayer(int tier) {
+        for (int owner : tiers[tier].owners)
+            if (owner < 0)
+                return true;
+        return false;
+    }
+
+    void allocate(ShadowLight &slight, int tier) {
+        std::vector<int> &owners = tiers[tier].owners;
+        for (size_t layer = 0; layer < owners.size(); ++layer)
+            if (owners[layer] < 0) {
+                owners[layer] = slight.pointlight;
+                slight.tier = tier;
+                slight.layer = layer;
+                for (int face = 0; face < 6; ++face)
+                    slight.valid[face] = false;
+                return;
+            }
+    }
+
+    void release(ShadowLight &slight) {
+        if (slight.layer >= 0)
+            tiers[slight.tier].owners[slight.layer] = -1;
+        slight.tier = -1;
+        slight.layer = -1;
+    }
+
+    void attach(PointLight &light, const ShadowLight &slight) {
+        light.shadow_tier = slight.tier;
+        light.shadow_layer = slight.layer;
+    }
+
+    void detach(PointLight &light) {
+        light.shadow_tier = -1;
+        light.shadow_layer = -1;
+    }
+};
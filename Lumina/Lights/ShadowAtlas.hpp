@@ -0,0 +1,421 @@
+// Shadow Atlas: every 2D Shadow Map is a square Region of one Depth Texture, handed out by a Quadtree
+// Static Casters are cached per Region and only redrawn when a Caster or the Light moves,
+// Dynamic Casters are drawn over a Copy of that cached Layer. Spot Lights get perspective Regions sized from their Cone
+// The Atlas starts at the given Size and doubles when a Region does not fit, up to max_size
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "./LightingManager.hpp"
+#include "./LightClusters.hpp"
+#include "./ShadowCulling.hpp"
+#include "../Shaders/Model.hpp"
+
+class ShadowAtlas {
+
+public:
+    // near Plane of the Spot Light Frustums, their far Plane is the Light's Range
+    float spot_near = 0.05f;
+
+    // Needs a current Context, Size, min_tile and max_size are rounded to Powers of two
+    ShadowAtlas(int size = 1024, int min_tile = 256, int max_size = 8192) {
+        this->size = 1;
+        while (this->size < size)
+            this->size *= 2;
+        this->min_tile = std::min(std::max(min_tile, 1), this->size);
+        this->max_size = this->size;
+        while (this->max_size < max_size)
+            this->max_size *= 2;
+
+        levels = 1;
+        while ((this->size >> (levels - 1)) > this->min_tile)
+            ++levels;
+        free_nodes.resize(levels);
+        free_nodes[0].push_back({0, 0});
+
+        live = createDepthTexture();
+        glGenFramebuffers(1, &fbo);
+    }
+
+    void Delete() {
+        glDeleteTextures(1, &live);
+        if (cache)
+            glDeleteTextures(1, &cache);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    // Casters: Static ones stay cached until MoveCaster touches them
+    int AddCaster(Model *model, glm::mat4 transform, bool dynamic = false) {
+        casters.push_back({model, transform, dynamic, {}});
+        ShadowCulling::MeshBounds(model, transform, casters.back().bounds);
+        if (dynamic && !cache)
+            cache = createDepthTexture();
+        invalidate(dynamic);
+        return casters.size() - 1;
+    }
+
+    void MoveCaster(int caster, glm::mat4 transform) {
+        Caster &acaster = casters.at(caster);
+        if (std::memcmp(&acaster.transform, &transform, sizeof(glm::mat4)) == 0)
+            return;
+        acaster.transform = transform;
+        ShadowCulling::MeshBounds(acaster.model, transform, acaster.bounds);
+        invalidate(acaster.dynamic);
+    }
+
+    // Gives LM.dirlights[dirlight] a Region of the requested Resolution and points its depthmap at the Atlas
+    // Returns false when the Atlas is full
+    bool AddDirLight(LightManager &LM, int dirlight, int resolution) {
+        Region region;
+        if (!allocate(resolution, region))
+            return false;
+        region.dirlight = dirlight;
+        regions.push_back(region);
+        attach(LM.dirlights.at(dirlight), region);
+        return true;
+    }
+
+    void RemoveDirLight(LightManager &LM, int dirlight) {
+        for (size_t i = 0; i < regions.size(); ++i)
+            if (regions[i].dirlight == dirlight) {
+                release(regions[i]);
+                LM.dirlights.at(dirlight).atlas = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                LM.dirlights.at(dirlight).depthmap = 0;
+                regions.erase(regions.begin() + i);
+                return;
+            }
+    }
+
+    // Gives LM.spotlights[spotlight] a perspective Region, resolution is for a 90 degree Cone
+    // and scales with the Cone's Width so every Spot Light gets about the same Texel Density
+    bool AddSpotLight(LightManager &LM, int spotlight, int resolution) {
+        Region region;
+        region.spotlight = spotlight;
+        region.resolution = resolution;
+        if (!allocate(spotResolution(LM.spotlights.at(spotlight), resolution), region))
+            return false;
+        regions.push_back(region);
+        attach(LM.spotlights.at(spotlight), region);
+        return true;
+    }
+
+    void RemoveSpotLight(LightManager &LM, int spotlight) {
+        for (size_t i = 0; i < regions.size(); ++i)
+            if (regions[i].spotlight == spotlight) {
+                release(regions[i]);
+                LM.spotlights.at(spotlight).atlas = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                LM.spotlights.at(spotlight).depthmap = 0;
+                regions.erase(regions.begin() + i);
+                return;
+            }
+    }
+
+    // Redraws only the Regions whose Light or Casters changed <depth_shader: SimpleDepth>
+    // Leaves the Default FrameBuffer bound, the Caller resets the Viewport
+    void Update(LightManager &LM, Shader *depth_shader) {
+        Tools::ShaderCheck(depth_shader);
+
+        last_static = 0;
+        last_dynamic = 0;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_SCISSOR_TEST);
+        depth_shader->Use();
+        depth_shader->setBool("useInstance", false);
+
+        for (Region &region : regions) {
+            glm::mat4 matrix;
+            if (region.spotlight >= 0) {
+                SpotLight &light = LM.spotlights.at(region.spotlight);
+                // a Cone that changed its Width moves to a Region of the new Size
+                int wanted = spotResolution(light, region.resolution);
+                if (tileOf(wanted) != region.size) {
+                    Region resized = region;
+                    release(region);
+                    if (allocate(wanted, resized))
+                        region = resized;
+                    else
+                        allocate(region.size, region);
+                    region.static_valid = false;
+                    region.dynamic_valid = false;
+                }
+                light.lightMatrix = spotMatrix(light);
+                matrix = light.lightMatrix;
+                // Re-attach in case the Vector was edited
+                attach(light, region);
+            }
+            else {
+                DirLight &light = LM.dirlights.at(region.dirlight);
+                matrix = light.lightMatrix;
+                attach(light, region);
+            }
+
+            bool moved = std::memcmp(&region.matrix, &matrix, sizeof(glm::mat4)) != 0;
+            if (moved || !region.static_valid) {
+                region.matrix = matrix;
+                region.static_valid = true;
+                region.dynamic_valid = false;
+                // Without Dynamic Casters the cached Layer is the live one
+                region.static_casters = drawRegion(cache ? cache : live, region, depth_shader, false);
+                ++last_static;
+            }
+
+            if (cache && !region.dynamic_valid) {
+                glCopyImageSubData(cache, GL_TEXTURE_2D, 0, region.x, region.y, 0, live, GL_TEXTURE_2D, 0, region.x, region.y, 0, region.size, region.size, 1);
+                region.dynamic_casters = drawRegion(live, region, depth_shader, true);
+                region.dynamic_valid = true;
+                ++last_dynamic;
+            }
+        }
+
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    unsigned int ServeTexture() { return live; }
+    int ServeSize() { return size; }
+    int ServeStaticRedraws() { return last_static; }
+    int ServeDynamicRedraws() { return last_dynamic; }
+    // Meshes that passed the Caster Culling the last Time the Light's Region was drawn, -1 without a Region
+    int ServeDirLightCasters(int dirlight) { return casterCount(dirlight, -1); }
+    int ServeSpotLightCasters(int spotlight) { return casterCount(-1, spotlight); }
+
+private:
+    struct Caster {
+        Model *model;
+        glm::mat4 transform;
+        bool dynamic;
+        std::vector<ShadowCulling::Bounds> bounds;      // World AABB per Mesh
+    };
+
+    struct Region {
+        int x = 0;
+        int y = 0;
+        int size = 0;
+        int level = 0;
+        int dirlight = -1;
+        int spotlight = -1;
+        int resolution = 0;         // asked for by AddSpotLight
+        glm::mat4 matrix = glm::mat4(0.0f);
+        int static_casters = 0;
+        int dynamic_casters = 0;
+        bool static_valid = false;
+        bool dynamic_valid = false;
+    };
+
+    struct Node {
+        int x;
+        int y;
+    };
+
+    int size;
+    int min_tile;
+    int max_size;
+    int levels;
+    // Free Squares per Level, Level 0 is the whole Atlas
+    std::vector<std::vector<Node>> free_nodes;
+
+    std::vector<Caster> casters;
+    std::vector<Region> regions;
+
+    unsigned int live = 0;
+    unsigned int cache = 0;     // Static Layer, only created once a Dynamic Caster exists
+    unsigned int fbo = 0;
+
+    int last_static = 0;
+    int last_dynamic = 0;
+
+    unsigned int createDepthTexture() {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        // Regions clamp themselves in the Shaders
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+
+    void invalidate(bool dynamic) {
+        for (Region &region : regions) {
+            if (!dynamic)
+                region.static_valid = false;
+            region.dynamic_valid = false;
+        }
+    }
+
+    template <typename Light>
+    void attach(Light &light, const Region &region) {
+        light.depthmap = live;
+        light.atlas = glm::vec4((float)region.x / size, (float)region.y / size, (float)region.size / size, (float)region.size / size);
+    }
+
+    int spotResolution(const SpotLight &light, int resolution) {
+        float angle = std::clamp(glm::radians(light.outtercutoff), 0.01f, glm::radians(80.0f));
+        return std::max((int)(resolution * std::tan(angle)), 1);
+    }
+
+    // Square Frustum around the Cone, reaching as far as the Light does
+    glm::mat4 spotMatrix(const SpotLight &light) {
+        glm::vec3 dir = glm::normalize(light.direction);
+        glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        float far = std::max(LightClusters::Range(light.attrib, light.attenuation), spot_near * 2.0f);
+        float angle = std::clamp(glm::radians(light.outtercutoff), 0.01f, glm::radians(80.0f));
+        return glm::perspective(2.0f * angle, 1.0f, spot_near, far) * glm::lookAt(light.position, light.position + dir, up);
+    }
+
+    int casterCount(int dirlight, int spotlight) {
+        for (Region &region : regions)
+            if ((dirlight >= 0 && region.dirlight == dirlight) || (spotlight >= 0 && region.spotlight == spotlight))
+                return region.static_casters + (cache ? region.dynamic_casters : 0);
+        return -1;
+    }
+
+    // Returns the Meshes drawn
+    int drawRegion(unsigned int target, const Region &region, Shader *depth_shader, bool dynamic) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, target, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+
+        glViewport(region.x, region.y, region.size, region.size);
+        glScissor(region.x, region.y, region.size, region.size);
+        // the Dynamic Pass draws over the copied Static Depth
+        if (!dynamic)
+            glClear(GL_DEPTH_BUFFER_BIT);
+
+        depth_shader->setMat4("LightSpaceTransform", region.matrix);
+        glm::vec4 planes[5];
+        ShadowCulling::ExtrudedPlanes(region.matrix, planes);
+
+        int drawn = 0;
+        for (Caster &caster : casters) {
+            if (caster.dynamic != dynamic)
+                continue;
+            depth_shader->setMat4("model", caster.transform);
+            for (size_t m = 0; m < caster.bounds.size(); ++m)
+                if (ShadowCulling::Touches(planes, caster.bounds[m])) {
+                    caster.model->DrawDepth(m);
+                    ++drawn;
+                }
+        }
+        return drawn;
+    }
+
+    // Side of the Square allocate hands out for a Resolution
+    int tileOf(int resolution) {
+        int tile = min_tile;
+        while (tile < resolution && tile < max_size)
+            tile *= 2;
+        return tile;
+    }
+
+    // Doubles the Atlas: the old Quadtree becomes the Square at the Origin and the other three are free
+    // Every Region is redrawn, Update re-attaches them with the new Size
+    void grow() {
+        int half = size;
+        size *= 2;
+        ++levels;
+        free_nodes.insert(free_nodes.begin(), std::vector<Node>());
+        std::vector<Node> &top = free_nodes[1];
+        // an empty old Atlas merges back into the whole new one
+        if (!top.empty()) {
+            top.clear();
+            free_nodes[0].push_back({0, 0});
+        }
+        else {
+            top.push_back({half, half});
+            top.push_back({0, half});
+            top.push_back({half, 0});
+        }
+        for (Region &region : regions)
+            ++region.level;
+
+        glDeleteTextures(1, &live);
+        live = createDepthTexture();
+        if (cache) {
+            glDeleteTextures(1, &cache);
+            cache = createDepthTexture();
+        }
+        invalidate(false);
+    }
+
+    // Quadtree: take a free Square of the Level, splitting a bigger one when there is none,
+    // the Atlas grows when neither exists
+    bool allocate(int resolution, Region &region) {
+        int tile = tileOf(resolution);
+        while (size < tile)
+            grow();
+
+        int level = 0;
+        while ((size >> level) > tile)
+            ++level;
+
+        int from = level;
+        while (from >= 0 && free_nodes[from].empty())
+            --from;
+        if (from < 0 && size < max_size) {
+            grow();
+            return allocate(resolution, region);
+        }
+        if (from < 0) {
+            std::cout << "ERROR::SHADOW_ATLAS::ALLOCATE:: no free Region of " << tile << " * " << tile << std::endl;
+            return false;
+        }
+
+        for (; from < level; ++from) {
+            Node node = free_nodes[from].back();
+            free_nodes[from].pop_back();
+            int half = (size >> from) / 2;
+            // Last pushed is taken first, so Regions fill from the Origin
+            free_nodes[from + 1].push_back({node.x + half, node.y + half});
+            free_nodes[from + 1].push_back({node.x, node.y + half});
+            free_nodes[from + 1].push_back({node.x + half, node.y});
+            free_nodes[from + 1].push_back({node.x, node.y});
+        }
+
+        Node node = free_nodes[level].back();
+        free_nodes[level].pop_back();
+        region.x = node.x;
+        region.y = node.y;
+        region.size = tile;
+        region.level = level;
+        return true;
+    }
+
+    // Gives the Square back and merges it with its three Siblings when they are all free
+    void release(const Region &region) {
+        int level = region.level;
+        Node node = {region.x, region.y};
+        while (level > 0) {
+            int parent_size = size >> (level - 1);
+            Node parent = {node.x - node.x % parent_size, node.y - node.y % parent_size};
+
+            std::vector<Node> &nodes = free_nodes[level];
+            int siblings = 0;
+            for (const Node &free : nodes)
+                if (free.x >= parent.x && free.x < parent.x + parent_size && free.y >= parent.y && free.y < parent.y + parent_size)
+                    ++siblings;
+            if (siblings < 3)
+                break;
+
+            nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [&](const Node &free) {
+                return free.x >= parent.x && free.x < parent.x + parent_size && free.y >= parent.y && free.y < parent.y + parent_size;
+            }), nodes.end());
+            node = parent;
+            --level;
+        }
+        free_nodes[level].push_back(node);
+    }
+};
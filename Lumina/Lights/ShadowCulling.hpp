@@ -0,0 +1,52 @@
+// Caster Culling for the Shadow Passes: a Mesh can only throw a Shadow into a Light's Frustum if its Bounds touch
+// that Frustum extruded back along the Light Direction, which is the Frustum without its near Plane
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "glm/glm.hpp"
+#include "../Shaders/Model.hpp"
+
+class ShadowCulling {
+public:
+    typedef std::pair<glm::vec3, glm::vec3> Bounds;     // World AABB <min, max>
+
+    // World AABB of every Mesh of the Model
+    static void MeshBounds(Model *model, const glm::mat4 &transform, std::vector<Bounds> &bounds) {
+        bounds.clear();
+        for (Mesh &amesh : model->ServeMeshes()) {
+            glm::vec3 center = glm::vec3(transform * glm::vec4((amesh.AABB_min + amesh.AABB_max) * 0.5f, 1.0f));
+            glm::vec3 half = 0.5f * (amesh.AABB_max - amesh.AABB_min);
+            glm::vec3 extent = glm::abs(glm::vec3(transform[0])) * half.x + glm::abs(glm::vec3(transform[1])) * half.y + glm::abs(glm::vec3(transform[2])) * half.z;
+            bounds.push_back({center - extent, center + extent});
+        }
+    }
+
+    // Side and far Planes of a Light's Clip Transform <xyz inward Normal, w Distance>
+    // Orthographic Sides are parallel to the Light Direction and perspective ones meet at the Light,
+    // so leaving out the near Plane extrudes the Frustum up to the Light
+    static void ExtrudedPlanes(const glm::mat4 &transform, glm::vec4 planes[5]) {
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; ++i)
+            row[i] = glm::vec4(transform[0][i], transform[1][i], transform[2][i], transform[3][i]);
+
+        planes[0] = row[3] + row[0];
+        planes[1] = row[3] - row[0];
+        planes[2] = row[3] + row[1];
+        planes[3] = row[3] - row[1];
+        planes[4] = row[3] - row[2];
+    }
+
+    static bool Touches(const glm::vec4 planes[5], const Bounds &bounds) {
+        glm::vec3 center = (bounds.first + bounds.second) * 0.5f;
+        glm::vec3 half = (bounds.second - bounds.first) * 0.5f;
+        for (int i = 0; i < 5; ++i) {
+            glm::vec3 normal = glm::vec3(planes[i]);
+            // the Corner furthest along the Normal is still behind the Plane
+            if (glm::dot(normal, center) + glm::dot(glm::abs(normal), half) + planes[i].w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
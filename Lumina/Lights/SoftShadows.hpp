@@ -0,0 +1,234 @@
+// Accelerated PCSS: a Min/Max Depth Mip Chain of one Shadow Region lets the Blocker Search skip fully lit and fully
+// shadowed Areas, the Sample Set and the Blue Noise that rotates it per Pixel are built once on the CPU
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+#include "./Attachments.hpp"
+
+// Matches PCSS_SAMPLES and the PCSSSamples Block in the Shaders <Uniform Block 0 is Matrices>
+#define PCSS_SAMPLES 32
+#define PCSS_UBO_BINDING 1
+// GL_TEXTURE26 ~ 27 <after the Cascades>
+#define PCSS_MINMAX_TEXTURE_UNIT 26
+#define PCSS_NOISE_TEXTURE_UNIT 27
+
+class SoftShadows {
+
+public:
+    // Needs a current Context <minmax_shader: MinMaxDepth>
+    SoftShadows(Shader *minmax_shader, int noise_size = 64) {
+        this->minmax_shader = minmax_shader;
+
+        buildSamples();
+        buildNoise(noise_size);
+
+        glGenFramebuffers(1, &fbo);
+        // the Reduction Passes make their Triangle from gl_VertexID
+        glGenVertexArrays(1, &VAO);
+    }
+
+    void Delete() {
+        glDeleteBuffers(1, &ubo);
+        glDeleteTextures(1, &noise);
+        if (minmax)
+            glDeleteTextures(1, &minmax);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // Rebuilds the Chain from the Region of the Depth Texture <region: offset and scale in [0, 1] like DirLight::atlas>
+    // Only needed after the Region was redrawn. Leaves the Default FrameBuffer bound, the Caller resets the Viewport
+    void Build(unsigned int depthmap, int depthmap_size, glm::vec4 region) {
+        Tools::ShaderCheck(minmax_shader);
+
+        glm::ivec2 offset = glm::ivec2(glm::vec2(region.x, region.y) * (float)depthmap_size);
+        int size = std::max((int)(region.z * depthmap_size) / 2, 1);
+        allocate(size);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        minmax_shader->Use();
+        minmax_shader->setInt("source", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(VAO);
+
+        for (int level = 0; level < levels; ++level) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, minmax, level);
+            glViewport(0, 0, std::max(size >> level, 1), std::max(size >> level, 1));
+
+            if (level == 0) {
+                // 2x2 Depth Texels of the Region per Texel
+                minmax_shader->setBool("from_depth", true);
+                minmax_shader->setIVec2("source_offset", offset);
+                glBindTexture(GL_TEXTURE_2D, depthmap);
+            }
+            else {
+                // Only the Level above is visible while this one is written <no Feedback Loop>
+                minmax_shader->setBool("from_depth", false);
+                minmax_shader->setIVec2("source_offset", glm::ivec2(0));
+                glBindTexture(GL_TEXTURE_2D, minmax);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+            }
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, minmax);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glEnable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+        ++builds;
+    }
+
+    void ShaderConfig(Shader *shader) {
+        Tools::ShaderCheck(shader);
+
+        shader->Use();
+        shader->setUniformBlock("PCSSSamples", PCSS_UBO_BINDING);
+        glBindBufferBase(GL_UNIFORM_BUFFER, PCSS_UBO_BINDING, ubo);
+
+        shader->setInt("pcss_levels", levels);
+        shader->setInt("pcss_minmax", PCSS_MINMAX_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + PCSS_MINMAX_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, minmax);
+        shader->setInt("pcss_noise", PCSS_NOISE_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + PCSS_NOISE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, noise);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    int ServeLevels() { return levels; }
+    int ServeBuilds() { return builds; }
+
+private:
+    Shader *minmax_shader;
+
+    unsigned int ubo = 0;
+    unsigned int noise = 0;
+    unsigned int minmax = 0;
+    unsigned int fbo = 0;
+    unsigned int VAO = 0;
+
+    int minmax_size = 0;
+    int levels = 0;
+    int builds = 0;
+
+    // RG32F: Min Depth in r, Max Depth in g, down to 1x1
+    void allocate(int size) {
+        if (minmax && size == minmax_size)
+            return;
+        if (minmax)
+            glDeleteTextures(1, &minmax);
+
+        minmax_size = size;
+        levels = 1;
+        while ((size >> levels) > 0)
+            ++levels;
+
+        glGenTextures(1, &minmax);
+        glBindTexture(GL_TEXTURE_2D, minmax);
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_RG32F, size, size);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Progressive Poisson Disk by Best Candidate: every Prefix is spread over the whole Disk,
+    // so Shaders taking only the first few Samples still cover it
+    void buildSamples() {
+        std::mt19937 random(37);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        auto candidate = [&]() {
+            float radius = std::sqrt(unit(random));
+            float angle = 6.283185307f * unit(random);
+            return glm::vec2(radius * std::cos(angle), radius * std::sin(angle));
+        };
+
+        std::vector<glm::vec2> samples;
+        samples.push_back(candidate());
+        while (samples.size() < PCSS_SAMPLES) {
+            glm::vec2 best(0.0f);
+            float best_distance = -1.0f;
+            for (size_t c = 0; c < 10 * samples.size() + 1; ++c) {
+                glm::vec2 point = candidate();
+                float nearest = INFINITY;
+                for (glm::vec2 &sample : samples)
+                    nearest = std::min(nearest, glm::dot(point - sample, point - sample));
+                if (nearest > best_distance) {
+                    best_distance = nearest;
+                    best = point;
+                }
+            }
+            samples.push_back(best);
+        }
+
+        // std140: two Samples per vec4
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, samples.size() * sizeof(glm::vec2), samples.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // Void and Cluster Ranking on a Torus: each next Pixel goes into the largest Void left,
+    // its Rank becomes the Rotation so neighbouring Pixels get very different Angles
+    void buildNoise(int size) {
+        const float sigma = 1.9f;
+        const int window = 6;
+
+        std::vector<float> weights((2 * window + 1) * (2 * window + 1));
+        for (int y = -window; y <= window; ++y)
+            for (int x = -window; x <= window; ++x)
+                weights[(y + window) * (2 * window + 1) + x + window] = std::exp(-(x * x + y * y) / (2.0f * sigma * sigma));
+
+        // a tiny Jitter decides the Ties of the empty Start
+        std::mt19937 random(64);
+        std::uniform_real_distribution<float> jitter(0.0f, 1e-4f);
+        std::vector<float> energy(size * size);
+        for (float &e : energy)
+            e = jitter(random);
+
+        std::vector<bool> filled(size * size, false);
+        std::vector<unsigned char> ranks(size * size);
+        for (int rank = 0; rank < size * size; ++rank) {
+            int pick = -1;
+            for (int p = 0; p < size * size; ++p)
+                if (!filled[p] && (pick < 0 || energy[p] < energy[pick]))
+                    pick = p;
+
+            filled[pick] = true;
+            ranks[pick] = (unsigned char)(rank * 256 / (size * size));
+
+            int px = pick % size;
+            int py = pick / size;
+            for (int y = -window; y <= window; ++y)
+                for (int x = -window; x <= window; ++x) {
+                    int wrapped = ((py + y + size) % size) * size + (px + x + size) % size;
+                    energy[wrapped] += weights[(y + window) * (2 * window + 1) + x + window];
+                }
+        }
+
+        glGenTextures(1, &noise);
+        glBindTexture(GL_TEXTURE_2D, noise);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, ranks.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
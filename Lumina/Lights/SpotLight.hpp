@@ -12,6 +12,10 @@ public:
     Attenuation attenuation;
     float cutoff;
     float outtercutoff;
+    // Perspective Shadow Map, 0 without <set by ShadowAtlas::AddSpotLight>
+    glm::mat4 lightMatrix = glm::mat4(1.0f);
+    unsigned int depthmap = 0;
+    glm::vec4 atlas = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);   // Region of depthmap in use <offset, scale>
 
     SpotLight(LightAttrib attrib, glm::vec3 pos, glm::vec3 dir, Attenuation attenuation, float a, float b) {
         this->attrib = attrib;
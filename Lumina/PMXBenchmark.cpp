@@ -0,0 +1,74 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+#include "lazy.hpp"
+#include "./Shaders/Model.hpp"
+
+// Native PMX Loader against the Assimp Importer on the same File
+// Runs alternate so both Paths see a warm File Cache, the first Run of each is discarded
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "./Model/Haku/TDA Lacy Haku.pmx";
+    int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    lazy::glfwCoreEnv(3, 3);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "PMX Benchmark", NULL, NULL);
+    if(window == NULL)
+    {
+        std::cout << "Failed to Create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+    if(!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to init GLAD" << std::endl;
+        return -1;
+    }
+
+    double native_ms = 0.0;
+    double assimp_ms = 0.0;
+    size_t native_vertices = 0;
+    size_t assimp_vertices = 0;
+    size_t native_meshes = 0;
+    size_t assimp_meshes = 0;
+
+    for (int run = 0; run <= runs; ++run)
+    {
+        for (int native = 1; native >= 0; --native)
+        {
+            Model model(path.c_str(), native ? MODEL_NATIVE_ALL : 0);
+            glFinish();
+
+            size_t vertices = 0;
+            for (Mesh &amesh : model.ServeMeshes())
+            {
+                vertices += amesh.vertices.size();
+                for (Texture &atexture : amesh.textures)
+                    glDeleteTextures(1, &atexture.id);
+                amesh.Delete();
+            }
+
+            if (run == 0)
+                continue;
+            (native ? native_ms : assimp_ms) += model.ServeLoadTime();
+            (native ? native_vertices : assimp_vertices) = vertices;
+            (native ? native_meshes : assimp_meshes) = model.ServeMeshes().size();
+        }
+    }
+
+    std::cout << "PMX Benchmark: " << path << " (" << runs << " Runs)" << std::endl;
+    std::cout << "Native: " << native_ms / runs << "ms\t" << native_meshes << " Meshes\t" << native_vertices << " Vertices" << std::endl;
+    std::cout << "Assimp: " << assimp_ms / runs << "ms\t" << assimp_meshes << " Meshes\t" << assimp_vertices << " Vertices" << std::endl;
+    if (native_ms > 0.0)
+        std::cout << "Speedup: " << assimp_ms / native_ms << "x" << std::endl;
+
+    glfwTerminate();
+    return 0;
+}
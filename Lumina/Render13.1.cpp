@@ -17,6 +17,7 @@
 #include "./Shaders/FrameBuffer.hpp"
 
 #include "./Lights/LightingManager.hpp"
+#include "./Lights/LightClusters.hpp"
 
 glm::vec3 campos(0.0, 0.0, 0.0);
 glm::vec3 camup(0.0, 1.0, 0.0);
@@ -96,7 +97,8 @@ void inputs(GLFWwindow* window)
 
 int main()
 {
-    lazy::glfwCoreEnv(3, 3);
+    // 4.3 for the Lights Storage Buffer
+    lazy::glfwCoreEnv(3, 4);
 
     // This Func Should be Called before the Window being Created
     glfwWindowHint(GLFW_SAMPLES, multisample);
@@ -309,6 +311,7 @@ int main()
 
     // Lighting Manager
     LightManager LM;
+    LightClusters LC;
 
     glm::vec3 lightcol(1.0f, 1.0f, 1.0f);
     glm::vec3 lightdir(0.0f, -1.0f, -1.0f);
@@ -499,6 +502,11 @@ int main()
         glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(projection));
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+        // Light Clusters for the forward Shaders
+        LM.Upload();
+        LC.Build(LM, view, camera.Fov, (float)ScreenWidth / (float)ScreenHeight, camera.Znear, camera.Zfar, ScreenWidth, ScreenHeight);
+        LC.Bind();
+
         glBindFramebuffer(GL_FRAMEBUFFER, usualfb.ID);
         glEnable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -96,7 +96,8 @@ void inputs(GLFWwindow* window)
 
 int main()
 {
-    lazy::glfwCoreEnv(3, 3);
+    // 4.3 for the Lights Storage Buffer
+    lazy::glfwCoreEnv(3, 4);
 
     // This Func Should be Called before the Window being Created
     glfwWindowHint(GLFW_SAMPLES, multisample);
@@ -397,7 +398,7 @@ int main()
         glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), sizeof(glm::vec3), glm::value_ptr(camera.Position));
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, usualfb.ID);
+        usualfb.Bind();
         glEnable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.0, 0.0, 0.0, 1.0);
@@ -425,7 +426,7 @@ int main()
         fbShader.Use();
 
         // Test Texture
-        glBindTexture(GL_TEXTURE_2D, usualfb.ServeTextures().at(0));
+        glBindTexture(GL_TEXTURE_2D, usualfb.ServeTexture(0));
         // glBindTexture(GL_TEXTURE_2D, DirLightShadowMap);
         glBindVertexArray(usualfb.VAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -96,7 +96,8 @@ void inputs(GLFWwindow* window)
 
 int main()
 {
-    lazy::glfwCoreEnv(3, 3);
+    // 4.3 for the Lights Storage Buffer
+    lazy::glfwCoreEnv(3, 4);
 
     // This Func Should be Called before the Window being Created
     glfwWindowHint(GLFW_SAMPLES, multisample);
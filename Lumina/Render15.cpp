@@ -19,7 +19,11 @@
 #include "./Shaders/Model.hpp"
 #include "./Shaders/FrameBuffer.hpp"
 #include "./Lights/LightingManager.hpp"
+#include "./Lights/ShadowAtlas.hpp"
+#include "./Lights/SoftShadows.hpp"
+#include "./Shaders/Profiler.hpp"
 #include "./Shaders/BloomTools.hpp"
+#include "./Shaders/PostCompositor.hpp"
 
 glm::vec3 campos(0.0, 0.0, 0.0);
 glm::vec3 camup(0.0, 1.0, 0.0);
@@ -100,7 +104,8 @@ void inputs(GLFWwindow* window)
 
 int main()
 {
-    lazy::glfwCoreEnv(3, 3);
+    // 4.3 for the Lights Storage Buffer
+    lazy::glfwCoreEnv(3, 4);
 
     // This Func Should be Called before the Window being Created
     glfwWindowHint(GLFW_SAMPLES, multisample);
@@ -155,7 +160,8 @@ int main()
     // Layer 0 = all color
     // Layer 1 = bright color
 
-    Shader fbShader("./Shaders/HDR.vert", "./Shaders/HDR.frag");
+    // Post Effects as one Pass, a Shader Variant per Combination of enabled Effects
+    PostCompositor post("./Shaders/HDR.vert", "./Shaders/PostCompositor.frag");
 
     // Models and Shaders
     Model Haku("./Model/nanosuit/nanosuit.obj");
@@ -167,6 +173,9 @@ int main()
     Model Cube("./Model/JustCube/untitled.fbx");
     Shader LightCubeShader("./Shaders/LightCube.vert", "./Shaders/LightCubeBloom.frag");
 
+    // Depth Pre-Pass
+    Shader DepthPrepassShader("./Shaders/DepthPrepass.vert", "./Shaders/DepthPrepass.frag");
+
     glm::mat4 model(1.0f);
     model = glm::scale(model, glm::vec3(0.1f));
     HakuShader.Use();
@@ -195,6 +204,9 @@ int main()
     LightCubeShader.Use();
     LightCubeShader.setUniformBlock("Matrices", 0);
 
+    DepthPrepassShader.Use();
+    DepthPrepassShader.setUniformBlock("Matrices", 0);
+
     // UniformbLock Slot Binding
     glBindBufferBase(GL_UNIFORM_BUFFER, 0, MatricesBlock);
 
@@ -215,30 +227,11 @@ int main()
     glm::vec3 lightdir(cos(glm::radians(vertical)) * sin(glm::radians(horizontal)), sin(glm::radians(vertical)), cos(glm::radians(vertical)) * cos(glm::radians(horizontal)));
     LightAttrib attrib(lightcol, lightcol, lightcol);
 
-    // DirLight Depth Map Texture
-    unsigned int DirLightShadowMap;
-    glGenTextures(1, &DirLightShadowMap);
-    glBindTexture(GL_TEXTURE_2D, DirLightShadowMap);
-
-    // Use the Depth Texture as a normal Texture and Sampling it
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, Shadow_Resolution, Shadow_Resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    // Remove overborder samples
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    float bordercolor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, bordercolor);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // Binding
-    glBindFramebuffer(GL_FRAMEBUFFER, ShadowMapfbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, DirLightShadowMap, 0);
-    glDrawBuffer(NULL);
-    glReadBuffer(NULL);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER::SHADOWMAPPING:: FrameBuffer is NOT Compelete." << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Shadow Atlas for the 2D Shadow Maps <the Scene is static, so it is only drawn again when the Light moves>
+    // sized for the one DirLight Region, it grows if more Lights are added
+    ShadowAtlas SA(Shadow_Resolution);
+    SA.AddCaster(&Haku, model);
+    SA.AddCaster(&Floor, model);
 
     // Matrices for Light Space Transform <only used for DirLight>
     // All Objects should be in the Space between far_plane and near_plane <Might need Refinements Here>
@@ -265,20 +258,19 @@ int main()
     LightCubeShader.setMat4("model", lightcubemodel);
     LightCubeShader.setVec3("light_col", lightcol);
 
-    // Static Lighting's Shadow Mapping
-    glViewport(0, 0, Shadow_Resolution, Shadow_Resolution); // Shadow Map Resolution
-    glBindFramebuffer(GL_FRAMEBUFFER, ShadowMapfbo);
-    glClear(GL_DEPTH_BUFFER_BIT);
-
-    // Pre-Render
-    DirLightShadowShader.Use();
-    Haku.Draw(&DirLightShadowShader);
-    Floor.Draw(&DirLightShadowShader);
+    // Lighting Management and Shadow Shader Config
+    LM.dirlights.push_back(DirLight(attrib, lightdir, DirLight_Transform, 0));
+    SA.AddDirLight(LM, 0, Shadow_Resolution);
+    SA.Update(LM, &DirLightShadowShader);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Accelerated PCSS <Min/Max Chain of the Sun's Region, rebuilt whenever the Region is>
+    Shader MinMaxDepthShader("./Shaders/FullScreen.vert", "./Shaders/MinMaxDepth.frag");
+    SoftShadows ss(&MinMaxDepthShader);
+    ss.Build(SA.ServeTexture(), SA.ServeSize(), LM.dirlights.at(0).atlas);
+    ss.ShaderConfig(&HakuShader);
+    ss.ShaderConfig(&FloorShader);
 
-    // Lighting Management and Shadow Shader Config
-    LM.dirlights.push_back(DirLight(attrib, lightdir, DirLight_Transform, DirLightShadowMap));
+    glViewport(0, 0, ScreenWidth, ScreenHeight);
     LM.ShaderConfig(&HakuShader);
     LM.ShaderConfig(&FloorShader);
 
@@ -343,20 +335,27 @@ int main()
     //LM.ShaderConfig(&FloorShader);
 
     // Bloom
-    Shader GaussainBlurShader("./Shaders/GaussainBlur.vert", "./Shaders/GaussainBlur.frag");
-    Shader BloomMixShader("./Shaders/BloomMix.vert", "./Shaders/BloomMix.frag");
-    BloomTool bt(&Orifb, &GaussainBlurShader, &BloomMixShader);
+    Shader BloomDownsampleShader("./Shaders/HDR.vert", "./Shaders/BloomDownsample.frag");
+    Shader BloomUpsampleShader("./Shaders/HDR.vert", "./Shaders/BloomUpsample.frag");
+    RenderTargetPool pool;
+    BloomTool bt(&Orifb, &BloomDownsampleShader, &BloomUpsampleShader, &pool);
 
     // Vars used for imgui
     bool grayscale = false;
     bool inversion = false;
     int kernel = 0;
     bool gammacorrection = true;
+    bool tonemapping = true;
 
     float exposure = 1.0;
 
     bool bloom = false;
-    int bloomloop = 15;
+    int bloomlevels = 6;
+
+    bool accelerated_pcss = true;
+    bool depth_prepass = true;
+    bool front_to_back = true;
+    Profiler profiler;
 
     while(!glfwWindowShouldClose(window))
     {
@@ -383,17 +382,34 @@ int main()
             ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Kernels Available:\n0::NoEffect\t1::Sharpen\t2::Blur\t3::EdgeDetection");
             ImGui::SliderInt("Kernel Selector", &kernel, 0, 3);
             ImGui::NewLine();
+            ImGui::Checkbox("Tone Mapping", &tonemapping);
             ImGui::SliderFloat("Exposure", &exposure, 0.0f, 100.0f, "%.2f");
+            post.ImGuiStatus();
 
             ImGui::NewLine();
             ImGui::Checkbox("Bloom", &bloom);
-            ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Blur by GaussainBlur");
-            ImGui::SliderInt("Bloom Blur Factor", &bloomloop, 1, 25);
+            ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Mip Chain <Radius by Levels>");
+            ImGui::SliderInt("Bloom Levels", &bloomlevels, 1, BLOOM_MAX_LEVELS);
+            ImGui::SliderFloat("Bloom Strength", &bt.strength, 0.0f, 1.0f, "%.2f");
 
             ImGui::NewLine();
             ImGui::SliderFloat("Dirlight Vertical", &vertical, -90.0f, 90.0f);
             ImGui::SliderFloat("Dirlight Horizontal", &horizontal, -180.0f, 180.0f);
 
+            ImGui::NewLine();
+            ImGui::Checkbox("Accelerated PCSS", &accelerated_pcss);
+            ImGui::BulletText("Min/Max Levels:%d Rebuilds:%d", ss.ServeLevels(), ss.ServeBuilds());
+
+            ImGui::NewLine();
+            ImGui::Checkbox("Depth Pre-Pass", &depth_prepass);
+            ImGui::Checkbox("Front-to-Back Sorting", &front_to_back);
+            // the Pre-Pass' own Count is what the Scene would shade without it
+            double covered = profiler.ServeSamples("Scene Fragments");
+            if (depth_prepass && covered > 0.0)
+                ImGui::BulletText("Overdraw without Pre-Pass:%.2fx", profiler.ServeSamples("Depth Pre-Pass Fragments") / covered);
+            ImGui::BulletText("Shaded Fragments per Screen Pixel:%.2f", covered / ((double)ScreenWidth * ScreenHeight));
+            profiler.ImGuiStatus();
+
             ImGui::End();
         }
 
@@ -441,30 +457,27 @@ int main()
         LightCubeShader.Use();
         LightCubeShader.setMat4("model", lightcubemodel);
 
-        // Dynamic Lighting's Shadow Mapping
-        glViewport(0, 0, Shadow_Resolution, Shadow_Resolution); // Shadow Map Resolution
-        glBindFramebuffer(GL_FRAMEBUFFER, ShadowMapfbo);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // Pre-Render
-        DirLightShadowShader.Use();
-        Haku.Draw(&DirLightShadowShader);
-        Floor.Draw(&DirLightShadowShader);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
         // Lighting Management and Shadow Shader Config
         LM.dirlights.at(0).direction = lightdir;
         LM.dirlights.at(0).lightMatrix = DirLight_Transform;
+        // Shadow Region is only redrawn when the Light was moved
+        SA.Update(LM, &DirLightShadowShader);
+        profiler.Count("Casters DirLight 0", SA.ServeDirLightCasters(0));
+        if (SA.ServeStaticRedraws() + SA.ServeDynamicRedraws() > 0)
+        {
+            profiler.Begin("Min/Max Chain");
+            ss.Build(SA.ServeTexture(), SA.ServeSize(), LM.dirlights.at(0).atlas);
+            profiler.End();
+        }
+        ss.ShaderConfig(&HakuShader);
+        ss.ShaderConfig(&FloorShader);
         LM.ShaderConfig(&HakuShader);
         LM.ShaderConfig(&FloorShader);
 
         // Reset Viewport
         glViewport(0, 0, ScreenWidth, ScreenHeight);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, Orifb.ID);
+        Orifb.Bind();
         glEnable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.0, 0.0, 0.0, 1.0);
@@ -472,12 +485,51 @@ int main()
         // Render Config
         Orifb.MRTRenderConfig();
 
-        // Render Code
+        // Opaque Models, the Suit first since it stands in Front of most of the Floor
+        // depth_only fetches the Model's packed Position Stream
+        auto draw_opaque = [&](Model *amodel, Shader *shader, const glm::mat4 &transform, bool depth_only) {
+            if (front_to_back)
+                amodel->DrawSorted(shader, transform, camera.Position, depth_only);
+            else if (depth_only)
+                amodel->DrawDepth();
+            else
+                amodel->Draw(shader);
+        };
+
+        // Depth Pre-Pass <Position only, the Scene then shades one Fragment per Pixel with GL_EQUAL>
+        if (depth_prepass)
+        {
+            profiler.Begin("Depth Pre-Pass");
+            profiler.BeginSamples("Depth Pre-Pass Fragments");
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            DepthPrepassShader.Use();
+            DepthPrepassShader.setMat4("model", model);
+            draw_opaque(&Haku, &DepthPrepassShader, model, true);
+            DepthPrepassShader.setMat4("model", glm::mat4(1.0f));
+            draw_opaque(&Floor, &DepthPrepassShader, glm::mat4(1.0f), true);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            profiler.EndSamples();
+            profiler.End();
+
+            glDepthFunc(GL_EQUAL);
+            glDepthMask(GL_FALSE);
+        }
+
+        // Render Code <timed per PCSS Path for the Comparison>
+        profiler.Begin(accelerated_pcss ? "Scene (Accelerated PCSS)" : "Scene (PCSS)");
+        profiler.BeginSamples("Scene Fragments");
         HakuShader.Use();
-        Haku.Draw(&HakuShader);
+        HakuShader.setBool("accelerated_pcss", accelerated_pcss);
+        draw_opaque(&Haku, &HakuShader, model, false);
 
         FloorShader.Use();
-        Floor.Draw(&FloorShader);
+        FloorShader.setBool("accelerated_pcss", accelerated_pcss);
+        draw_opaque(&Floor, &FloorShader, glm::mat4(1.0f), false);
+        profiler.EndSamples();
+        profiler.End();
+
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_TRUE);
 
         // Light Cube
         LightCubeShader.Use();
@@ -486,27 +538,31 @@ int main()
 
         // Bloom
         if(bloom)
-            bt.ApplyBloom(bloomloop);
+            bt.ApplyBloom(bloomlevels);
 
+        // the Bloom Levels leave their own Viewports behind
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, ScreenWidth, ScreenHeight);
         glDisable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT);
         glClearColor(0.0, 0.0, 0.0, 1.0);
 
         // Imgui Post Effects Dynamics
-        fbShader.Use();
-        fbShader.setBool("Grayscale", grayscale);
-        fbShader.setBool("Inversion", inversion);
-        fbShader.setInt("KernelIndex", kernel);
-        fbShader.setBool("GammaCorrection", gammacorrection);
-        fbShader.setFloat("exposure", exposure);
-
-        fbShader.Use();
-        Orifb.Draw(bloom ? bt.tex_finished() : Orifb.ServeTextures().at(0));
+        unsigned int effects = (bloom ? POST_BLOOM : 0) | (tonemapping ? POST_EXPOSURE : 0) | (inversion ? POST_INVERSION : 0)
+            | (grayscale ? POST_GRAYSCALE : 0) | (gammacorrection ? POST_GAMMA : 0);
+        Shader *post_shader = post.Use(effects, kernel);
+        post_shader->setFloat("exposure", exposure);
+
+        bt.ToneMapConfig(post_shader, bloom ? bt.tex_finished() : 0);
+        Orifb.Draw(Orifb.ServeTexture(0));
         // Orifb.Draw(Orifb.ServeTextures().at(0));
+        bt.Release();
+        profiler.Count("MSAA Resolves", Orifb.ServeResolves());
 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window);
+        profiler.Collect();
+        pool.EndFrame();
     }
     Orifb.Delete();
 
@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <random>
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -19,9 +20,23 @@
 #include "./Shaders/Model.hpp"
 #include "./Shaders/FrameBuffer.hpp"
 #include "./Lights/LightingManager.hpp"
+#include "./Lights/CascadedShadows.hpp"
+#include "./Lights/EVSMShadows.hpp"
+#include "./Lights/ShadowAtlas.hpp"
+#include "./Lights/PointShadows.hpp"
+#include "./Lights/LightClusters.hpp"
+#include "./Lights/LightVolumes.hpp"
+#include "./Lights/LTCTables.hpp"
 #include "./Shaders/BloomTools.hpp"
+#include "./Shaders/PostCompositor.hpp"
 #include "./Shaders/GBuffer.hpp"
 #include "./Shaders/SSAOtools.hpp"
+#include "./Shaders/TextureResidency.hpp"
+#include "./Shaders/MaterialSystem.hpp"
+#include "./Shaders/Profiler.hpp"
+#include "./Shaders/RenderTargetPool.hpp"
+#include "./Shaders/RenderGraph.hpp"
+#include "./Shaders/DynamicResolution.hpp"
 
 glm::vec3 campos(0.0, 0.0, 0.0);
 glm::vec3 camup(0.0, 1.0, 0.0);
@@ -37,11 +52,14 @@ int multisample = 1;
 // Screen
 int ScreenWidth = 1920;
 int ScreenHeight = 1080;
+// Targets are reallocated at the Start of the next Frame
+bool resized = false;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     ScreenWidth = width;
     ScreenHeight = height;
+    resized = true;
     glViewport(0, 0, ScreenWidth, ScreenHeight);
 }
 
@@ -102,7 +120,8 @@ void inputs(GLFWwindow* window)
 
 int main()
 {
-    lazy::glfwCoreEnv(3, 3);
+    // 4.6 for SSBOs, Multi Draw Indirect and gl_DrawID
+    lazy::glfwCoreEnv(6, 4);
 
     // This Func Should be Called before the Window being Created
     glfwWindowHint(GLFW_SAMPLES, multisample);
@@ -149,16 +168,16 @@ int main()
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
 
-    // to Store DEPTH used for SSAO (USUALLY LINEARIZED AND BIGGER THAN 1.0) Blend should be OFF to Avoid Color Problems
+    // Default Blend, the Graph sets it per Pass <off for the Geometry Pass>
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    GBuffer GeoPassgfb(ScreenWidth, ScreenHeight);
-    // Layer 0 = World_Position(RGB)LinearizedDepth(A)
-    // Layer 1 = View_Position(RGB)LinearizedDepth(A)
-    // Layer 2 = World_Normal
-    // Layer 3 = View_Normal
-    // Layer 4 = Albedo(RGB)Specular(A)
+    // the Material Layer carries the Roughness and Metallic Factors of the batched Materials to Lighting
+    GBuffer GeoPassgfb(ScreenWidth, ScreenHeight, true);
+    // Layer 0 = World_Normal <octahedral>
+    // Layer 1 = Albedo(RGB)Specular(A)
+    // Layer 2 = Roughness(R)Metallic(G)
+    // Depth = sampleable Depth Stencil, Positions are rebuilt from it
     Shader GeoPassShader("./Shaders/GeometryPass.vert", "./Shaders/GeometryPass.frag");
     FrameBuffer LightingPassfb(ScreenWidth, ScreenHeight, 1, 2);
     // Layer 0 = all color
@@ -167,20 +186,44 @@ int main()
 
     Shader SSAOPassShader("./Shaders/HDR.vert", "./Shaders/SSAO.frag");
 
-    Shader PostEffectsShader("./Shaders/HDR.vert", "./Shaders/HDR.frag");
+    // Post Effects as one Pass, a Shader Variant per Combination of enabled Effects
+    PostCompositor post("./Shaders/HDR.vert", "./Shaders/PostCompositor.frag");
+
+    // Dynamic Resolution: the internal Image is brought back to the native Size
+    Shader UpscaleShader("./Shaders/HDR.vert", "./Shaders/Upscale.frag");
+    Shader SharpenShader("./Shaders/HDR.vert", "./Shaders/Sharpen.frag");
 
     // Models and Shaders
     Model Pier("./Model/Pei_Er/Pei_Er.pmx");
+    Pier.BuildAtlases();
     Model Floor("./Model/Floor/draft_floor.fbx");
 
     Model Cube("./Model/JustCube/untitled.fbx");
     Shader LightCubeShader("./Shaders/LightCube.vert", "./Shaders/LightCubeBloom.frag");
 
     glm::mat4 model(1.0f);
+
+    // Texture Streaming
+    TextureResidency tr(256);
+    tr.Track(&Pier, model);
+    tr.Track(&Floor, model);
+
+    // Batched Materials
+    MaterialSystem ms;
+    ms.AddModel(&Pier, model);
+    ms.AddModel(&Floor, model);
+    ms.Build(&tr);
+    Shader GeoPassBatchedShader("./Shaders/GeometryPassBatched.vert", "./Shaders/GeometryPassBatched.frag");
+    ms.ShaderConfig(&GeoPassBatchedShader);
+
+    // Depth Pre-Pass
+    Shader DepthPrepassShader("./Shaders/DepthPrepass.vert", "./Shaders/DepthPrepass.frag");
+    Shader DepthPrepassBatchedShader("./Shaders/DepthPrepassBatched.vert", "./Shaders/DepthPrepass.frag");
+
     GeoPassShader.Use();
     GeoPassShader.setMat4("model", model);
-    GeoPassShader.setFloat("z_near", camera.Znear);
-    GeoPassShader.setFloat("z_far", camera.Zfar);
+    DepthPrepassShader.Use();
+    DepthPrepassShader.setMat4("model", model);
 
     // UniformBuffer
     unsigned int MatricesBlock;
@@ -196,6 +239,15 @@ int main()
     GeoPassShader.Use();
     GeoPassShader.setUniformBlock("Matrices", 0);
 
+    GeoPassBatchedShader.Use();
+    GeoPassBatchedShader.setUniformBlock("Matrices", 0);
+
+    DepthPrepassShader.Use();
+    DepthPrepassShader.setUniformBlock("Matrices", 0);
+
+    DepthPrepassBatchedShader.Use();
+    DepthPrepassBatchedShader.setUniformBlock("Matrices", 0);
+
     LightingPassShader.Use();
     LightingPassShader.setUniformBlock("Matrices", 0);
 
@@ -208,125 +260,44 @@ int main()
     // UniformbLock Slot Binding
     glBindBufferBase(GL_UNIFORM_BUFFER, 0, MatricesBlock);
 
-    // Shadow FrameBuffer
-    unsigned int ShadowMapfbo;
-    glGenFramebuffers(1, &ShadowMapfbo);
-
-    // Depth Map Texture Attachment
-    const unsigned int Shadow_Resolution = 4096;
-
     // Lighting Manager
     LightManager LM;
+    LightClusters LC;
+    LightVolumes LV;
+    Shader LightVolumeShader("./Shaders/LightVolume.vert", "./Shaders/LightVolume.frag");
+    LightVolumeShader.Use();
+    LightVolumeShader.setUniformBlock("Matrices", 0);
 
     // HDR
     glm::vec3 lightcol(10.0f, 10.0f, 10.0f);
     glm::vec3 lightdir(0.0f, -1.0f, -1.0f);
     LightAttrib attrib(lightcol, lightcol, lightcol);
 
-    // DirLight Depth Map Texture
-    unsigned int DirLightShadowMap;
-    glGenTextures(1, &DirLightShadowMap);
-    glBindTexture(GL_TEXTURE_2D, DirLightShadowMap);
-
-    // Use the Depth Texture as a normal Texture and Sampling it
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, Shadow_Resolution, Shadow_Resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    // Remove overborder samples
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    float bordercolor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, bordercolor);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // Binding
-    glBindFramebuffer(GL_FRAMEBUFFER, ShadowMapfbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, DirLightShadowMap, 0);
-
-    // and we don't need color attachment this time so disable the coloroutput of the framebuffer by setting its read/write buffer to NULL(GL_NONE aka 0)
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER::SHADOWMAPPING:: FrameBuffer is NOT Compelete." << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Matrices for Light Space Transform <only used for DirLight>
-    // All Objects should be in the Space between far_plane and near_plane <Might need Refinements Here>
-    float near_plane = 30.0f;
-    float far_plane = 120.0f;
-    float OrthoBorder = 10.0f;
-    glm::mat4 DirLight_projection = glm::ortho(-OrthoBorder, OrthoBorder, -OrthoBorder, OrthoBorder, near_plane, far_plane);
-    glm::vec3 DirLight_Pos = -25.0f * lightdir + 10.0f * camup;
-    glm::mat4 DirLight_view = glm::lookAt(DirLight_Pos, DirLight_Pos + lightdir, camup);
-    glm::mat4 DirLight_Transform = DirLight_projection * DirLight_view;
+    // Cascaded Shadow Maps for the DirLight <fitted to the Camera Frustum every Frame>
+    CascadedShadowMap CSM(2048, 4);
+    CSM.AddCaster(&Pier, model);
+    CSM.AddCaster(&Floor, model);
 
     // Shadow Shader
     Shader DirLightShadowShader("./Shaders/SimpleDepth.vert", "./Shaders/SimpleDepth.frag");
-    DirLightShadowShader.Use();
-    DirLightShadowShader.setMat4("LightSpaceTransform", DirLight_Transform);
-    DirLightShadowShader.setMat4("model", model);
-    DirLightShadowShader.setBool("useInstance", false);
 
-    // Static Lighting's Shadow Mapping
-    glViewport(0, 0, Shadow_Resolution, Shadow_Resolution); // Shadow Map Resolution
-    glBindFramebuffer(GL_FRAMEBUFFER, ShadowMapfbo);
-    glClear(GL_DEPTH_BUFFER_BIT);
+    // Filterable Cascades: Moments at half the Depth Resolution, blurred and mipmapped after every Update
+    Shader EVSMConvertShader("./Shaders/FullScreen.vert", "./Shaders/EVSMConvert.frag");
+    Shader EVSMBlurShader("./Shaders/FullScreen.vert", "./Shaders/EVSMBlur.frag");
+    EVSMShadows evsm(&EVSMConvertShader, &EVSMBlurShader, CSM.ServeResolution() / 2, CSM.ServeCascades());
 
-    // Pre-Render
-    DirLightShadowShader.Use();
-    Pier.Draw(&DirLightShadowShader);
-    Floor.Draw(&DirLightShadowShader);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Lighting Management and Shadow Shader Config
-    LM.dirlights.push_back(DirLight(attrib, lightdir, DirLight_Transform, DirLightShadowMap));
+    // Lighting Management and Shadow Shader Config <the Cascades replace the DirLight's own Shadow Map>
+    LM.dirlights.push_back(DirLight(attrib, lightdir, glm::mat4(1.0f), 0));
     LM.ShaderConfig(&LightingPassShader);
 
-    // PointLight ShadowMap
-    unsigned int CubeShadowMap;
-    glGenTextures(1, &CubeShadowMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP,CubeShadowMap);
-    for (unsigned int i = 0; i < 6; ++i)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, Shadow_Resolution, Shadow_Resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    // FrameBuffer Config <For PointLight Usage>
-    glBindFramebuffer(GL_FRAMEBUFFER, ShadowMapfbo);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, CubeShadowMap, 0);
-    glDrawBuffer(NULL);
-    glReadBuffer(NULL);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER::SHADOWMAPPING:: FrameBuffer is NOT Compelete." << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Matrices and Shaders for CubeDepthMap Usage
-    float aspect_ratio = 1.0f;
-    float near = 1.0f;
+    // PointLight Shadows <Cube Map Array Layers, each Face redrawn only when its Casters change>
+    PointShadows PS;
+    PS.AddCaster(&Pier, model);
+    PS.AddCaster(&Floor, model);
+    Shader PointLightShader("./Shaders/PointDepth.vert", "./Shaders/CubeDepth.frag");
+
     float far = 120.0f;
     glm::vec3 PointLight_Pos(0.0f, 2.0f, 2.0f);
-    glm::mat4 PointLight_projection = glm::perspective(glm::radians(90.0f), aspect_ratio, near, far);
-    std::vector<glm::mat4> PointLight_Transform;
-    PointLight_Transform.push_back(PointLight_projection * glm::lookAt(PointLight_Pos, PointLight_Pos + glm::vec3(1.0f, 0.0f, 0.0), glm::vec3(0.0f, -1.0f, 0.0f)));
-    PointLight_Transform.push_back(PointLight_projection * glm::lookAt(PointLight_Pos, PointLight_Pos + glm::vec3(-1.0f, 0.0f, 0.0), glm::vec3(0.0f, -1.0f, 0.0f)));
-    PointLight_Transform.push_back(PointLight_projection * glm::lookAt(PointLight_Pos, PointLight_Pos + glm::vec3(0.0f, 1.0f, 0.0), glm::vec3(0.0f, 0.0f, 1.0f)));
-    PointLight_Transform.push_back(PointLight_projection * glm::lookAt(PointLight_Pos, PointLight_Pos + glm::vec3(0.0f, -1.0f, 0.0), glm::vec3(0.0f, 0.0f, -1.0f)));
-    PointLight_Transform.push_back(PointLight_projection * glm::lookAt(PointLight_Pos, PointLight_Pos + glm::vec3(0.0f, 0.0f, 1.0), glm::vec3(0.0f, -1.0f, 0.0f)));
-    PointLight_Transform.push_back(PointLight_projection * glm::lookAt(PointLight_Pos, PointLight_Pos + glm::vec3(0.0f, 0.0f, -1.0), glm::vec3(0.0f, -1.0f, 0.0f)));
-    
-    // Cube Shadow Map Shader Config
-    Shader PointLightShader("./Shaders/CubeDepth.vert", "./Shaders/CubeDepth.geom", "./Shaders/CubeDepth.frag");
-    PointLightShader.Use();
-    PointLightShader.setMat4("model", model);
-    for (int i = 0; i < PointLight_Transform.size(); ++i)
-        PointLightShader.setMat4("Shadow_Matrices[" + std::to_string(i) + "]", PointLight_Transform.at(i));
-    PointLightShader.setVec3("LightPos", PointLight_Pos);
-    PointLightShader.setFloat("Far", far);
 
     // Light Cube Shader Config
     glm::mat4 lightcubemodel(1.0f);
@@ -336,52 +307,123 @@ int main()
     LightCubeShader.setMat4("model", lightcubemodel);
     LightCubeShader.setVec3("light_col", lightcol);
 
-    glViewport(0, 0, Shadow_Resolution, Shadow_Resolution);
-    glBindFramebuffer(GL_FRAMEBUFFER, ShadowMapfbo);
-    glClear(GL_DEPTH_BUFFER_BIT);
+    LM.pointlights.push_back(PointLight(attrib, PointLight_Pos, Attenuation(0.7f, 3.5f), 0, far));
+    PS.AddLight(0);
 
-    // Pre-Rendering
-    PointLightShader.Use();
-    Pier.Draw(&PointLightShader);
-    Floor.Draw(&PointLightShader);
+    // SpotLight Shadows <perspective Regions of an Atlas, sized from the Cone>
+    ShadowAtlas SA(1024);
+    SA.AddCaster(&Pier, model);
+    SA.AddCaster(&Floor, model);
+    LM.spotlights.push_back(SpotLight(attrib, glm::vec3(-2.0f, 4.0f, 1.0f), glm::vec3(0.4f, -1.0f, -0.2f), Attenuation(1.0f, 2.0f), 20.0f, 30.0f));
+    SA.AddSpotLight(LM, 0, 1024);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    LM.pointlights.push_back(PointLight(attrib, PointLight_Pos, Attenuation(0.7f, 3.5f), CubeShadowMap, far));
+    // Area Lights <a Softbox over the Pier and a round Lamp, Tables come precomputed from Texture/LTC_GGX.bin>
+    LTCTables ltc;
+    glm::vec3 area_radiance = glm::vec3(1.0f, 0.9f, 0.8f);
+    LM.arealights.push_back(AreaLight(LightAttrib(glm::vec3(0.0f), area_radiance, area_radiance), glm::vec3(2.0f, 3.0f, -2.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f), AREA_RECT));
+    LM.arealights.push_back(AreaLight(LightAttrib(glm::vec3(0.0f), area_radiance, area_radiance), glm::vec3(-3.0f, 1.5f, -1.0f), glm::vec3(0.0f, 0.0f, 0.6f), glm::vec3(0.0f, 0.6f, 0.0f), AREA_DISK, true));
+    ltc.ShaderConfig(&LightingPassShader);
 
     LM.ShaderConfig(&LightingPassShader);
 
     // Viewport Settings
     glViewport(0, 0, ScreenWidth, ScreenHeight);
 
+    // Transient Targets of SSAO and Bloom <GBuffer and LightingPassfb live for the whole Frame>
+    RenderTargetPool pool;
+    size_t fixed_target_bytes = (size_t)ScreenWidth * ScreenHeight * (
+        GeoPassgfb.ServePixelBytes() + 2 * RenderTargetPool::TexelBytes(GL_RGB16F) + RenderTargetPool::TexelBytes(GL_DEPTH24_STENCIL8));
+
     // SSAO Tools
-    SSAOtools st(ScreenWidth, ScreenHeight, &GeoPassgfb, &SSAOPassShader);
+    SSAOtools st(ScreenWidth, ScreenHeight, &GeoPassgfb, &SSAOPassShader, &pool);
     SSAOPassShader.Use();
     st.ShaderConfig();
 
     // Bloom
-    Shader GaussainBlurShader("./Shaders/GaussainBlur.vert", "./Shaders/GaussainBlur.frag");
-    Shader BloomMixShader("./Shaders/BloomMix.vert", "./Shaders/BloomMix.frag");
-    BloomTool bt(&LightingPassfb, &GaussainBlurShader, &BloomMixShader);
+    Shader BloomDownsampleShader("./Shaders/HDR.vert", "./Shaders/BloomDownsample.frag");
+    Shader BloomUpsampleShader("./Shaders/HDR.vert", "./Shaders/BloomUpsample.frag");
+    BloomTool bt(&LightingPassfb, &BloomDownsampleShader, &BloomUpsampleShader, &pool);
 
     // Vars used for imgui
     bool grayscale = false;
     bool inversion = false;
     int kernel = 0;
     bool gammacorrection = true;
+    bool tonemapping = true;
 
     float exposure = 0.4;
 
     bool bloom = false;
-    int bloomloop = 15;
+    int bloomlevels = 6;
     bool SSAO = true;
     bool SSAOBlur = true;
+    bool batched = true;
+    bool depth_prepass = true;
+    bool front_to_back = true;
+    // GPU Time of the Geometry with and without the Pre-Pass, kept from whenever each Path last ran
+    double geometry_ms = 0.0;
+    double prepass_geometry_ms = 0.0;
+
+    bool light_volumes = false;
+
+    float cascade_lambda = CSM.lambda;
+    float cascade_blend = CSM.blend;
+
+    bool evsm_enabled = true;
+
+    float spot_outer = LM.spotlights.at(0).outtercutoff;
+    float area_intensity = 1.0f;
+    Profiler profiler;
+    // every Pass is timed by the Profiler
+    RenderGraph graph(&pool, &profiler);
+    // follows the GPU Time of the Graph
+    DynamicResolution dynres(16.0f);
+    float sharpness = 0.5f;
+
+    // Unshadowed Lights scattered around the Pier to stress the Clusters
+    int extra_lights = 0;
+    size_t base_pointlights = LM.pointlights.size();
+    std::mt19937 light_random(16);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
 
     while(!glfwWindowShouldClose(window))
     {
         inputs(window);
         glfwPollEvents();
 
+        // Minimized Windows have nothing to draw into
+        if (ScreenWidth == 0 || ScreenHeight == 0)
+        {
+            glfwWaitEvents();
+            continue;
+        }
+
+        // Window Resizes reallocate the screen sized Targets, the Pool trims its old Sizes by itself
+        if (resized)
+        {
+            GeoPassgfb.Resize(ScreenWidth, ScreenHeight);
+            LightingPassfb.Resize(ScreenWidth, ScreenHeight);
+            st.Resize(ScreenWidth, ScreenHeight);
+            SSAOPassShader.Use();
+            st.ShaderConfig();
+            fixed_target_bytes = (size_t)ScreenWidth * ScreenHeight * (
+                GeoPassgfb.ServePixelBytes() + 2 * RenderTargetPool::TexelBytes(GL_RGB16F) + RenderTargetPool::TexelBytes(GL_DEPTH24_STENCIL8));
+            resized = false;
+        }
+
+        // Internal Resolution: the Scene draws into the lower left RenderWidth * RenderHeight of the native Targets
+        int RenderWidth = dynres.ServeSize(ScreenWidth);
+        int RenderHeight = dynres.ServeSize(ScreenHeight);
+        bool upscale = RenderWidth != ScreenWidth || RenderHeight != ScreenHeight;
+        glm::vec2 viewport_scale((float)RenderWidth / ScreenWidth, (float)RenderHeight / ScreenHeight);
+        for (Shader *shader : {&LightingPassShader, &LightVolumeShader})
+        {
+            shader->Use();
+            shader->setVec2("viewport_scale", viewport_scale);
+        }
+        post.ViewportScale(viewport_scale);
+        st.ViewportScale(viewport_scale);
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -402,22 +444,84 @@ int main()
             ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Kernels Available:\n0::NoEffect\t1::Sharpen\t2::Blur\t3::EdgeDetection");
             ImGui::SliderInt("Kernel Selector", &kernel, 0, 3);
             ImGui::NewLine();
+            ImGui::Checkbox("Tone Mapping", &tonemapping);
             ImGui::SliderFloat("Exposure", &exposure, 0.0f, 100.0f, "%.2f");
+            post.ImGuiStatus();
 
             ImGui::NewLine();
             ImGui::Checkbox("SSAO", &SSAO);
-            ImGui::Checkbox("SSAOBlur", &SSAOBlur);
+            if (st.mode == AO_SSAO)
+                ImGui::Checkbox("SSAOBlur", &SSAOBlur);
+            st.ImGuiStatus();
 
             ImGui::NewLine();
             ImGui::Checkbox("Bloom", &bloom);
-            ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Blur by GaussainBlur");
-            ImGui::SliderInt("Bloom Blur Factor", &bloomloop, 1, 25);
+            ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Mip Chain <Radius by Levels>");
+            ImGui::SliderInt("Bloom Levels", &bloomlevels, 1, BLOOM_MAX_LEVELS);
+            ImGui::SliderFloat("Bloom Strength", &bt.strength, 0.0f, 1.0f, "%.2f");
+
+            ImGui::NewLine();
+            ImGui::Checkbox("Batched Materials", &batched);
+            ImGui::BulletText("Arrays:%d Materials:%d Draws:%d", ms.ArrayCount(), ms.MaterialCount(), ms.DrawCount());
+            ImGui::Checkbox("Depth Pre-Pass", &depth_prepass);
+            ImGui::Checkbox("Front-to-Back Sorting", &front_to_back);
+            ImGui::BulletText("Depth Stream Vertices:%d <12 Bytes each, 56 interleaved>", Pier.ServeDepthVertices() + Floor.ServeDepthVertices());
+            // Overdraw: Fragments shaded per covered Pixel. The Pre-Pass' own Count is what the Geometry would shade without it
+            double covered = profiler.ServeSamples("Geometry Fragments");
+            if (depth_prepass && covered > 0.0)
+                ImGui::BulletText("Overdraw without Pre-Pass:%.2fx", profiler.ServeSamples("Depth Pre-Pass Fragments") / covered);
+            ImGui::BulletText("Shaded Fragments per Screen Pixel:%.2f", covered / ((double)ScreenWidth * ScreenHeight));
+            ImGui::BulletText("Geometry:%.3fms Pre-Pass + Geometry:%.3fms", geometry_ms, prepass_geometry_ms);
+
+            ImGui::NewLine();
+            ImGui::SliderInt("Extra Lights", &extra_lights, 0, 4096);
+            ImGui::Checkbox("Light Volumes", &light_volumes);
+            ImGui::BulletText("Lights:%d Clustered:%d Indices:%d Max per Cluster:%d", LM.lights_num, (int)LC.ServeCulledLights(), (int)LC.ServeIndexCount(), (int)LC.ServeMaxClusterLights());
+            ImGui::BulletText("Light Slots Uploaded:%d", (int)LM.ServeUploadedSlots());
+
+            ImGui::NewLine();
+            ImGui::SliderFloat("Cascade Split Lambda", &cascade_lambda, 0.0f, 1.0f, "%.2f");
+            ImGui::SliderFloat("Cascade Blend", &cascade_blend, 0.0f, 0.5f, "%.2f");
+            for (int i = 0; i < CSM.ServeCascades(); ++i)
+                ImGui::BulletText("Cascade %d: to %.1f Meshes:%d", i, CSM.ServeSplit(i), CSM.ServeDrawnMeshes(i));
+            ImGui::Checkbox("EVSM Cascades", &evsm_enabled);
+            ImGui::SliderFloat("EVSM Positive Exponent", &evsm.positive_exponent, 1.0f, 42.0f, "%.1f");
+            ImGui::SliderFloat("EVSM Negative Exponent", &evsm.negative_exponent, 1.0f, 10.0f, "%.1f");
+            ImGui::SliderFloat("Light Bleeding Reduction", &evsm.bleeding_reduction, 0.0f, 0.95f, "%.2f");
+            ImGui::SliderFloat("EVSM Min Variance", &evsm.min_variance, 0.0f, 0.001f, "%.5f");
+            ImGui::SliderInt("EVSM Blur Radius", &evsm.blur_radius, 0, 8);
+            for (int i = 0; i < POINT_SHADOW_TIERS; ++i)
+                ImGui::BulletText("Point Shadow Tier %d: %d Used:%d", i, PS.ServeTierResolution(i), PS.ServeTierUsed(i));
+            ImGui::BulletText("Point Shadow Faces Redrawn:%d", PS.ServeFaceRedraws());
+            ImGui::SliderFloat("Spot Outer Cutoff", &spot_outer, 5.0f, 75.0f, "%.1f");
+            ImGui::BulletText("Spot Shadow Redraws:%d", SA.ServeStaticRedraws() + SA.ServeDynamicRedraws());
+            ImGui::SliderFloat("Area Light Intensity", &area_intensity, 0.0f, 10.0f, "%.2f");
+            profiler.ImGuiStatus();
+            graph.ImGuiStatus();
+            ImGui::BulletText("Fixed Render Targets:%.1fMB", fixed_target_bytes / (1024.0f * 1024.0f));
+            dynres.ImGuiStatus(ScreenWidth, ScreenHeight);
+            ImGui::SliderFloat("Upscale Sharpness", &sharpness, 0.0f, 1.0f, "%.2f");
+            pool.ImGuiStatus();
+
+            ImGui::NewLine();
+            tr.ImGuiStatus();
 
             ImGui::End();
         }
 
         ImGui::Render();
 
+        // Small Lights reaching about 1.5 Units, only appended or popped so the others keep their Slots
+        while (LM.pointlights.size() > base_pointlights + extra_lights)
+            LM.pointlights.pop_back();
+        while (LM.pointlights.size() < base_pointlights + extra_lights)
+        {
+            glm::vec3 color = 2.0f * glm::vec3(unit(light_random), unit(light_random), unit(light_random));
+            glm::vec3 position(10.0f * unit(light_random) - 5.0f, 4.0f * unit(light_random), 10.0f * unit(light_random) - 5.0f);
+            float brightest = std::max(color.r, std::max(color.g, color.b));
+            LM.pointlights.push_back(PointLight(LightAttrib(glm::vec3(0.0f), color, color), position, Attenuation(1.0f, (brightest / LIGHT_CLUSTER_CUTOFF - 1.0f) / 1.5f), 0, far));
+        }
+
         // UniformBlock Data Update
         // View Matrice
         glm::mat4 view = camera.GetViewMatrix();
@@ -430,75 +534,331 @@ int main()
         glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), sizeof(glm::vec3), glm::value_ptr(camera.Position));
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-        // GeometryPass
-        glBindFramebuffer(GL_FRAMEBUFFER, GeoPassgfb.fb.ID);
-        glEnable(GL_DEPTH_TEST);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glClearColor(0.0, 0.0, 0.0, 1.0);
-
-        GeoPassgfb.fb.MRTRenderConfig();
-
-        // to Store DEPTH used for SSAO (USUALLY LINEARIZED AND BIGGER THAN 1.0) Blend should be OFF to Avoid Color Problems
-        glDisable(GL_BLEND);
-
-        GeoPassShader.Use();
-        Pier.Draw(&GeoPassShader);
-        Floor.Draw(&GeoPassShader);
+        // Texture Streaming
+        tr.Update(camera, ScreenHeight);
+
+        // Frame Graph <rebuilt every Frame, Passes only run if the Screen depends on them>
+        graph.Reset();
+        int cascades = graph.Import("Cascades");
+        int evsm_moments = graph.Import("EVSM Moments");
+        int point_shadows = graph.Import("Point Shadows");
+        int spot_shadows = graph.Import("Spot Shadows");
+        int gbuffer = graph.ImportTarget("GBuffer", GeoPassgfb.fb.ID, GeoPassgfb.SCRWidth, GeoPassgfb.SCRHeight);
+        int lighting = graph.ImportTarget("Lighting", LightingPassfb.ID, LightingPassfb.ScreenWidth, LightingPassfb.ScreenHeight, LightingPassfb.ServeAttachments().at(0));
+        int backbuffer = graph.ImportTarget("Screen", 0, ScreenWidth, ScreenHeight);
+        int ssao_raw = graph.Transient("SSAO", ScreenWidth, ScreenHeight, GL_R8);
+        int ssao_blurred = graph.Transient("SSAO Blurred", ScreenWidth, ScreenHeight, GL_R8);
+        // Bloom Levels at the native Sizes of the Chain, drawn in the Fraction the internal Resolution covers
+        std::vector<int> bloom_levels;
+        for (int i = 0; i < bloomlevels; ++i)
+        {
+            glm::ivec2 size = BloomTool::LevelSize(LightingPassfb.ScreenWidth, LightingPassfb.ScreenHeight, i);
+            glm::ivec2 region = BloomTool::LevelSize(RenderWidth, RenderHeight, i);
+            bloom_levels.push_back(graph.Transient("Bloom Level " + std::to_string(i), size.x, size.y, GL_RGB16F));
+            graph.Region(bloom_levels.back(), region.x, region.y);
+        }
+        // Post Effects land in display when the internal Resolution is below the native one
+        int display = graph.Transient("Display", ScreenWidth, ScreenHeight, GL_RGBA8);
+        int upscaled = graph.Transient("Upscaled", ScreenWidth, ScreenHeight, GL_RGBA8);
+        // GTAO works on half of the internal Resolution, its History belongs to SSAOtools
+        // Depth/Normal has the Key of Bloom Level 0 <half native Size, RGB16F> and dies before Lighting, so the Pool
+        // hands its Memory to the Bloom Chain later in the Frame
+        int ao_depth_normal = graph.Transient("AO Depth Normal", st.ServeHalfWidth(), st.ServeHalfHeight(), GL_RGB16F);
+        int ao_half = graph.Transient("GTAO Half", st.ServeHalfWidth(), st.ServeHalfHeight(), GL_R8);
+        int ao_history = graph.Import("AO History");
+        int ao_upsampled = graph.Transient("GTAO", ScreenWidth, ScreenHeight, GL_R8);
+        int ssao_result = st.mode == AO_GTAO ? ao_upsampled : (SSAOBlur ? ssao_blurred : ssao_raw);
+        for (int resource : {gbuffer, lighting, ssao_raw, ssao_blurred, ao_upsampled, display})
+            graph.Region(resource, RenderWidth, RenderHeight);
+        for (int resource : {ao_depth_normal, ao_half})
+            graph.Region(resource, (RenderWidth + 1) / 2, (RenderHeight + 1) / 2);
+        graph.Present(backbuffer);
+
+        // Cascades follow the Camera
+        CSM.lambda = cascade_lambda;
+        CSM.blend = cascade_blend;
+        graph.AddPass("Cascades",
+            [&](PassBuilder &pass) { pass.Write(cascades); pass.State({true, false, false}); },
+            [&](RenderGraph &) {
+                CSM.Update(LM.dirlights.at(0), view, camera.Fov, (float)ScreenWidth / (float)ScreenHeight, camera.Znear, camera.Zfar, &DirLightShadowShader);
+                for (int i = 0; i < CSM.ServeCascades(); ++i)
+                    profiler.Count("Casters Cascade " + std::to_string(i), CSM.ServeDrawnMeshes(i));
+            });
+        graph.AddPass("EVSM Prefilter",
+            [&](PassBuilder &pass) { pass.Read(cascades); pass.Write(evsm_moments); },
+            [&](RenderGraph &) { evsm.Build(CSM.ServeTexture(), GL_TEXTURE_2D_ARRAY, CSM.ServeResolution()); });
+        // Point Shadow Tiers follow the Light's Size on Screen
+        graph.AddPass("Point Shadows",
+            [&](PassBuilder &pass) { pass.Write(point_shadows); pass.State({true, false, false}); },
+            [&](RenderGraph &) {
+                PS.Update(LM, camera.Position, camera.Fov, ScreenHeight, &PointLightShader);
+                profiler.Count("Casters PointLight 0", PS.ServeLightCasters(0));
+            });
+        // Spot Regions are only redrawn when the Light or a Caster moved
+        LM.spotlights.at(0).outtercutoff = spot_outer;
+        LM.spotlights.at(0).cutoff = spot_outer * 2.0f / 3.0f;
+        for (AreaLight &light : LM.arealights)
+            light.attrib.diffuse = light.attrib.specular = area_radiance * area_intensity;
+        graph.AddPass("Spot Shadows",
+            [&](PassBuilder &pass) { pass.Write(spot_shadows); pass.State({true, false, false}); },
+            [&](RenderGraph &) {
+                SA.Update(LM, &DirLightShadowShader);
+                profiler.Count("Casters SpotLight 0", SA.ServeSpotLightCasters(0));
+            });
+
+        // Opaque Submission Order, shared by the Pre-Pass and the Geometry
+        if (front_to_back)
+            ms.Sort(camera.Position);
+        else
+            ms.Unsort();
+        // depth_only fetches the Models' packed Position Streams
+        auto draw_opaque = [&](Shader *shader, bool depth_only) {
+            if (front_to_back)
+            {
+                Pier.DrawSorted(shader, model, camera.Position, depth_only);
+                Floor.DrawSorted(shader, model, camera.Position, depth_only);
+            }
+            else if (depth_only)
+            {
+                Pier.DrawDepth();
+                Floor.DrawDepth();
+            }
+            else
+            {
+                Pier.Draw(shader);
+                Floor.Draw(shader);
+            }
+        };
+
+        // Depth Pre-Pass <Position only, Color Writes off>
+        if (depth_prepass)
+            graph.AddPass("Depth Pre-Pass",
+                [&](PassBuilder &pass) {
+                    PassState state{true, false, false};
+                    state.color_write = false;
+                    pass.Write(gbuffer);
+                    pass.State(state);
+                },
+                [&](RenderGraph &) {
+                    glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+                    profiler.BeginSamples("Depth Pre-Pass Fragments");
+                    if(batched)
+                    {
+                        DepthPrepassBatchedShader.Use();
+                        ms.DrawDepth();
+                    }
+                    else
+                    {
+                        DepthPrepassShader.Use();
+                        draw_opaque(&DepthPrepassShader, true);
+                    }
+                    profiler.EndSamples();
+                });
+
+        // GeometryPass <Blend off: the Alpha of gAlbedoSpec is the Specular Factor, not a Coverage>
+        // With the Pre-Pass only the visible Fragment of each Pixel passes GL_EQUAL and gets shaded
+        graph.AddPass("Geometry",
+            [&](PassBuilder &pass) {
+                PassState state{true, false, true};
+                if (depth_prepass)
+                {
+                    state.depth_func = GL_EQUAL;
+                    state.depth_write = false;
+                }
+                // Geometry marks the Stencil so Lighting skips the Sky
+                state.stencil_ref = LIGHT_VOLUME_STENCIL;
+                state.stencil_pass = GL_REPLACE;
+                pass.Write(gbuffer);
+                pass.State(state);
+            },
+            [&](RenderGraph &) {
+                glClearColor(0.0, 0.0, 0.0, 1.0);
+                glClear(depth_prepass ? GL_COLOR_BUFFER_BIT : GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+                GeoPassgfb.fb.MRTRenderConfig();
+                profiler.BeginSamples("Geometry Fragments");
+                if(batched)
+                {
+                    GeoPassBatchedShader.Use();
+                    ms.Draw();
+                }
+                else
+                {
+                    GeoPassShader.Use();
+                    draw_opaque(&GeoPassShader, false);
+                }
+                profiler.EndSamples();
+            });
 
         // SSAO Pass
-        SSAOPassShader.Use();
-        st.Draw();
-
-        // when Blend is on Opengl can't pass a color which has aphla that > 1.0
-        glEnable(GL_BLEND);
-
-        // LightingPass
-        glBindFramebuffer(GL_FRAMEBUFFER, LightingPassfb.ID);
-        glDisable(GL_DEPTH_TEST);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glClearColor(0.0, 0.0, 0.0, 1.0);
-
-        LightingPassfb.MRTRenderConfig();
-
-        LightingPassShader.Use();
-        GeoPassgfb.Deferred_Rendering_Config(&LightingPassShader);
-        // SSAO Vars by Gui used for LightingPass
-        st.LightingPass_Shader_Config(&LightingPassShader, SSAOBlur);
-        LightingPassShader.setBool("ssao_compoent.apply_SSAO", SSAO);
-
-        LightingPassfb.Draw();
-
-        // Use Depth Data from Geometry_Pass as a Mask for Forward_Rendering after LightingPass
-        glBlitNamedFramebuffer(GeoPassgfb.fb.ID, LightingPassfb.ID, 0, 0, GeoPassgfb.SCRWidth, GeoPassgfb.SCRHeight, 0, 0, LightingPassfb.ScreenWidth, LightingPassfb.ScreenHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-        glEnable(GL_DEPTH_TEST);
-
-        // // Light Cube
-        LightCubeShader.Use();
-        Cube.Draw(&LightCubeShader);
-
-        // Bloom
-        if(bloom)
-            bt.ApplyBloom(bloomloop);
+        graph.AddPass("SSAO",
+            [&](PassBuilder &pass) { pass.Read(gbuffer); pass.Write(ssao_raw); },
+            [&](RenderGraph &g) {
+                SSAOPassShader.Use();
+                st.Occlusion(g.Target(ssao_raw));
+            });
+        graph.AddPass("SSAO Blur",
+            [&](PassBuilder &pass) { pass.Read(ssao_raw); pass.Write(ssao_blurred); },
+            [&](RenderGraph &g) { st.Blur(g.Target(ssao_raw), g.Target(ssao_blurred)); });
+
+        // GTAO: half Resolution Horizons, accumulated in the History and upsampled along the G-Buffer's Edges
+        graph.AddPass("AO Downsample",
+            [&](PassBuilder &pass) { pass.Read(gbuffer); pass.Write(ao_depth_normal); },
+            [&](RenderGraph &g) {
+                st.GTAOFrame(view, projection, RenderWidth, RenderHeight);
+                st.GTAODownsample(g.Target(ao_depth_normal));
+            });
+        graph.AddPass("GTAO Horizons",
+            [&](PassBuilder &pass) { pass.Read(ao_depth_normal); pass.Write(ao_half); },
+            [&](RenderGraph &g) { st.GTAOHorizons(g.Target(ao_depth_normal), g.Target(ao_half)); });
+        graph.AddPass("GTAO Temporal",
+            [&](PassBuilder &pass) { pass.Read(ao_depth_normal); pass.Read(ao_half); pass.Write(ao_history); },
+            [&](RenderGraph &g) { st.GTAOTemporal(g.Target(ao_depth_normal), g.Target(ao_half)); });
+        graph.AddPass("GTAO Upsample",
+            [&](PassBuilder &pass) { pass.Read(gbuffer); pass.Read(ao_depth_normal); pass.Read(ao_history); pass.Write(ao_upsampled); },
+            [&](RenderGraph &g) { st.GTAOUpsample(g.Target(ao_depth_normal), g.Target(ao_upsampled)); });
+
+        // LightingPass <when Blend is on Opengl can't pass a color which has aphla that > 1.0>
+        graph.AddPass("Lighting",
+            [&](PassBuilder &pass) {
+                pass.Read(gbuffer);
+                pass.Read(cascades);
+                pass.Read(point_shadows);
+                pass.Read(spot_shadows);
+                if (evsm_enabled)
+                    pass.Read(evsm_moments);
+                if (SSAO)
+                    pass.Read(ssao_result);
+                pass.Write(lighting);
+                // Full-Screen Pass over Geometry Pixels only
+                PassState state{false, true, true};
+                state.stencil_func = GL_EQUAL;
+                state.stencil_ref = LIGHT_VOLUME_STENCIL;
+                state.stencil_write = 0x00;
+                pass.State(state);
+            },
+            [&](RenderGraph &g) {
+                glClearColor(0.0, 0.0, 0.0, 1.0);
+                glClear(GL_COLOR_BUFFER_BIT);
+                LightingPassfb.MRTRenderConfig();
+
+                // Use Depth and Stencil Data from Geometry_Pass as a Mask for the Light Volumes and Forward_Rendering after LightingPass
+                glBlitNamedFramebuffer(GeoPassgfb.fb.ID, LightingPassfb.ID, 0, 0, GeoPassgfb.SCRWidth, GeoPassgfb.SCRHeight, 0, 0, LightingPassfb.ScreenWidth, LightingPassfb.ScreenHeight, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+
+                // Lights Buffer <only changed Slots are uploaded> and the Clusters of this View
+                LM.ShaderConfig(&LightingPassShader);
+                CSM.ShaderConfig(&LightingPassShader, 0);
+                evsm.ShaderConfig(&LightingPassShader, evsm_enabled);
+                PS.ShaderConfig(&LightingPassShader);
+                ltc.ShaderConfig(&LightingPassShader);
+                if(!light_volumes)
+                {
+                    LC.Build(LM, view, camera.Fov, (float)ScreenWidth / (float)ScreenHeight, camera.Znear, camera.Zfar, RenderWidth, RenderHeight);
+                    LC.Bind();
+                }
+                GeoPassgfb.Deferred_Rendering_Config(&LightingPassShader);
+                // SSAO Vars by Gui used for LightingPass
+                st.LightingPass_Shader_Config(&LightingPassShader, g.Texture(ssao_result));
+                LightingPassShader.setBool("ssao_compoent.apply_SSAO", SSAO);
+                LightingPassShader.setBool("light_volumes", light_volumes);
+
+                LightingPassfb.Draw();
+            });
+
+        // Light Volumes add the unshadowed Point and Spot Lights where they reach
+        if(light_volumes)
+            graph.AddPass("Light Volumes",
+                [&](PassBuilder &pass) {
+                    pass.Read(gbuffer);
+                    if (SSAO)
+                        pass.Read(ssao_result);
+                    pass.Read(lighting);
+                    pass.Write(lighting);
+                    pass.State({false, true, false});
+                },
+                [&](RenderGraph &g) {
+                    LightVolumeShader.Use();
+                    GeoPassgfb.Deferred_Rendering_Config(&LightVolumeShader);
+                    st.LightingPass_Shader_Config(&LightVolumeShader, g.Texture(ssao_result));
+                    LightVolumeShader.setBool("ssao_compoent.apply_SSAO", SSAO);
+                    LV.Draw(LM, &LightVolumeShader, camera.Zfar);
+                });
+
+        // Light Cube
+        graph.AddPass("Light Cubes",
+            [&](PassBuilder &pass) { pass.Read(lighting); pass.Write(lighting); pass.State({true, true, false}); },
+            [&](RenderGraph &) {
+                LightCubeShader.Use();
+                Cube.Draw(&LightCubeShader);
+            });
+
+        // Bloom <culled unless the Post Effects read it>
+        graph.AddPass("Bloom",
+            [&](PassBuilder &pass) {
+                pass.Read(lighting);
+                for (int level : bloom_levels)
+                    pass.Write(level);
+            },
+            [&](RenderGraph &g) {
+                std::vector<RenderTarget *> targets;
+                for (int level : bloom_levels)
+                    targets.push_back(g.Target(level));
+                bt.ApplyBloom(targets, RenderWidth, RenderHeight);
+            });
 
         // PostEffect
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glDisable(GL_DEPTH_TEST);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glClearColor(0.3, 0.3, 0.3, 1.0);
-
-        // Imgui Post Effects Dynamics
-        PostEffectsShader.Use();
-        PostEffectsShader.setBool("Grayscale", grayscale);
-        PostEffectsShader.setBool("Inversion", inversion);
-        PostEffectsShader.setInt("KernelIndex", kernel);
-        PostEffectsShader.setBool("GammaCorrection", gammacorrection);
-        PostEffectsShader.setFloat("exposure", exposure);
-
-        PostEffectsShader.Use();
-        LightingPassfb.Draw(bloom ? bt.tex_finished() : LightingPassfb.ServeTextures().at(0));
+        graph.AddPass("Post Effects",
+            [&](PassBuilder &pass) {
+                pass.Read(lighting);
+                if (bloom)
+                    pass.Read(bloom_levels.at(0));
+                pass.Write(upscale ? display : backbuffer);
+                pass.State({false, true, false});
+            },
+            [&](RenderGraph &g) {
+                glClear(GL_COLOR_BUFFER_BIT);
+                glClearColor(0.3, 0.3, 0.3, 1.0);
+
+                // Imgui Post Effects Dynamics
+                unsigned int effects = (bloom ? POST_BLOOM : 0) | (tonemapping ? POST_EXPOSURE : 0) | (inversion ? POST_INVERSION : 0)
+                    | (grayscale ? POST_GRAYSCALE : 0) | (gammacorrection ? POST_GAMMA : 0);
+                Shader *post_shader = post.Use(effects, kernel);
+                post_shader->setFloat("exposure", exposure);
+                // Bloom Level 0 is added here instead of a Mix Pass of its own
+                bt.ToneMapConfig(post_shader, bloom ? g.Texture(bloom_levels.at(0)) : 0);
+                LightingPassfb.Draw(g.Texture(lighting));
+            });
+
+        // Edge adaptive Upscale to the native Size, then a contrast adaptive Sharpen onto the Screen
+        if (upscale)
+        {
+            graph.AddPass("Upscale",
+                [&](PassBuilder &pass) { pass.Read(display); pass.Write(upscaled); },
+                [&](RenderGraph &g) {
+                    UpscaleShader.Use();
+                    UpscaleShader.setIVec2("source_size", glm::ivec2(RenderWidth, RenderHeight));
+                    LightingPassfb.Draw(g.Texture(display));
+                });
+            graph.AddPass("Sharpen",
+                [&](PassBuilder &pass) { pass.Read(upscaled); pass.Write(backbuffer); },
+                [&](RenderGraph &g) {
+                    SharpenShader.Use();
+                    SharpenShader.setFloat("sharpness", sharpness);
+                    LightingPassfb.Draw(g.Texture(upscaled));
+                });
+        }
+
+        graph.Compile();
+        graph.Execute();
 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window);
+        profiler.Collect();
+        pool.EndFrame();
+        dynres.Update(graph.ServeTime());
+        if (depth_prepass)
+            prepass_geometry_ms = profiler.ServeTime("Depth Pre-Pass") + profiler.ServeTime("Geometry");
+        else
+            geometry_ms = profiler.ServeTime("Geometry");
     }
 
     ImGui_ImplGlfw_Shutdown();
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
@@ -12,7 +13,10 @@
 class Shader {
 public:
 	unsigned int ID;
-	Shader(const GLchar* vertexpath, const GLchar* fragmentpath) {
+	Shader(const GLchar* vertexpath, const GLchar* fragmentpath) : Shader(vertexpath, fragmentpath, std::vector<std::string>()) {}
+
+	// Variant of the Fragment Shader: every Define lands right below its #version Line <"NAME" or "NAME VALUE">
+	Shader(const GLchar* vertexpath, const GLchar* fragmentpath, const std::vector<std::string>& defines) {
 		//Reading Shaders from File
 		std::ifstream vShaderFile;
 		std::ifstream fShaderFile;
@@ -39,6 +43,15 @@ public:
 			std::cout << "ERROR::SHADER::FILE_READ_FAILED" << std::endl;
 		}
 
+		if (!defines.empty()) {
+			std::string block;
+			for (const std::string& define : defines)
+				block += "#define " + define + "\n";
+			size_t version = fragmentCode.find("#version");
+			size_t line_end = version == std::string::npos ? std::string::npos : fragmentCode.find('\n', version);
+			fragmentCode.insert(line_end == std::string::npos ? 0 : line_end + 1, block);
+		}
+
 		const char* vShaderCode = vertexCode.c_str();
 		const char* fShaderCode = fragmentCode.c_str();
 
@@ -212,10 +225,18 @@ public:
 		glUniform2fv(glGetUniformLocation(this->ID, name.c_str()), 1, glm::value_ptr(value));
 	}
 
+	void setIVec2(std::string name, glm::ivec2 value) const {
+		glUniform2iv(glGetUniformLocation(this->ID, name.c_str()), 1, glm::value_ptr(value));
+	}
+
 	void setVec3(std::string name, glm::vec3 value) const {
 		glUniform3fv(glGetUniformLocation(this->ID, name.c_str()), 1, glm::value_ptr(value));
 	}
 
+	void setVec4(std::string name, glm::vec4 value) const {
+		glUniform4fv(glGetUniformLocation(this->ID, name.c_str()), 1, glm::value_ptr(value));
+	}
+
 	void setMat4(std::string name, glm::mat4 value) const {
 		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
 	}
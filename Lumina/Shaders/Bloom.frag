@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 
 // MRT
 layout (location = 0) out vec4 FragColor;
@@ -28,14 +28,15 @@ struct Attenuation {
 
 struct Dirlight {
     vec3 direction;
-    sampler2D shadowmap;
+    int shadow;
+    vec4 atlas;     // Shadow Atlas Region <offset, scale>
 
     LightAttrib attrib;
 };
 
 struct PointLight {
     vec3 position;
-    samplerCube shadowmap;
+    int shadow;
     float far;
 
     LightAttrib attrib;
@@ -53,7 +54,7 @@ struct SpotLight {
     float outer_cutoff;
 };
 
-const int POINT_LIGHTS_LIMITATION = 8;
+const int POINT_SHADOWS_LIMITATION = 8;
 const int OTHER_LIMITATION = 2;
 
 in VS_OUT {
@@ -77,9 +78,31 @@ uniform Material material;
 
 const float shininess = 32.0;
 
-uniform Dirlight dirlights[OTHER_LIMITATION];
-uniform PointLight pointlights[POINT_LIGHTS_LIMITATION];
-uniform SpotLight spotlights[OTHER_LIMITATION];
+uniform sampler2D dirlight_shadowmaps[OTHER_LIMITATION];
+uniform samplerCube pointlight_shadowmaps[POINT_SHADOWS_LIMITATION];
+
+// Light Storage <std430, packed by LightManager>
+struct Light {
+    vec4 position;      // xyz position, w far plane <point> or cos(outer_cutoff) <spot> | Shadow Atlas Region <dir>
+    vec4 direction;     // xyz direction, w shadow map slot <-1 without>
+    vec4 ambient;       // a: attenuation constant
+    vec4 diffuse;       // a: attenuation linear
+    vec4 specular;      // a: cos(cutoff)
+};
+
+layout (std430, binding = 3) readonly buffer Lights {
+    int num_dirlight;
+    int num_pointlight;
+    int num_spotlight;
+    int num_pointshadow;
+    mat4 DirLight_Transform[OTHER_LIMITATION];
+    int shadow_pointlights[POINT_SHADOWS_LIMITATION];   // PointLight index of each Cube Shadow slot
+    Light lights[];     // DirLights, then PointLights, then SpotLights
+};
+
+Dirlight GetDirLight(int i);
+PointLight GetPointLight(int i);
+SpotLight GetSpotLight(int i);
 
 vec2 ParallaxMapping(vec2 coords, vec3 viewdir);    // For ParallaxMapping (of course)
 bool FragmentVisibility(vec2 coords);
@@ -151,7 +174,13 @@ float DepthAdjustment(vec3 lightdir) {
     return standard * (1.0 - abs(dot(norm, normalize(lightdir))));
 }
 
-float findBlocker(sampler2D shadowmap, vec4 light_coord, vec3 lightDir) {
+// Keeps Filter Taps inside the Light's own Region
+vec2 AtlasClamp(sampler2D shadowmap, vec4 atlas, vec2 coords) {
+    vec2 half_texel = 0.5 / textureSize(shadowmap, 0);
+    return clamp(coords, atlas.xy + half_texel, atlas.xy + atlas.zw - half_texel);
+}
+
+float findBlocker(sampler2D shadowmap, vec4 light_coord, vec3 lightDir, vec4 atlas) {
     uniformDiskSamples(light_coord.xy);
 
     float offset = 0.6 / shadowMapRes;
@@ -159,7 +188,7 @@ float findBlocker(sampler2D shadowmap, vec4 light_coord, vec3 lightDir) {
     int num = 0;
 
     for (int i = 0; i < NUM_SAMPLES; ++i) {
-        float blocker_depth = texture(shadowmap, light_coord.xy + poissonDisk[i] * offset).r;
+        float blocker_depth = texture(shadowmap, AtlasClamp(shadowmap, atlas, light_coord.xy + poissonDisk[i] * offset)).r;
         if (blocker_depth + DepthAdjustment(lightDir) < light_coord.z) {
             sum += blocker_depth;
             num++;
@@ -172,7 +201,7 @@ float findBlocker(sampler2D shadowmap, vec4 light_coord, vec3 lightDir) {
     return sum / (float(num) + EPS); // avoid divide by zero
 }
 
-float PCF_adptive(sampler2D shadowmap, vec4 light_coord, vec3 lightDir, float fliter_size) {
+float PCF_adptive(sampler2D shadowmap, vec4 light_coord, vec3 lightDir, float fliter_size, vec4 atlas) {
     poissonDiskSamples(light_coord.xy); // build sampler disk
 
     float shadow_factor = 0.0;
@@ -180,16 +209,101 @@ float PCF_adptive(sampler2D shadowmap, vec4 light_coord, vec3 lightDir, float fl
     float offset = 2.0 / shadowMapRes * fliter_size;
 
     for (int i = 0; i < NUM_SAMPLES; ++i) {
-        float blocker_depth = texture(shadowmap, light_coord.xy + poissonDisk[i] * offset).r;
+        float blocker_depth = texture(shadowmap, AtlasClamp(shadowmap, atlas, light_coord.xy + poissonDisk[i] * offset)).r;
         shadow_factor += ((blocker_depth + DepthAdjustment(lightDir)) < light_coord.z) ? 0.0 : 1.0;
     }
 
     return shadow_factor / float(NUM_SAMPLES);
 }
 
-float PCSS(sampler2D shadowmap, vec4 light_coord, vec3 lightDir) {
+// Accelerated PCSS <SoftShadows: Min/Max Depth Chain of the Light's Region and a precomputed Sample Set>
+// Radii stay in Shadow Map UV with the Sizes above so both Paths give the same Penumbra
+const int PCSS_SAMPLES = 32;
+const int PCSS_SEARCH_SAMPLES = 16;
+const float PCSS_SEARCH_RADIUS = 0.6 / shadowMapRes;
+const float PCSS_FILTER_SCALE = 2.0 / shadowMapRes;
+
+layout (std140) uniform PCSSSamples {
+    vec4 pcss_samples[PCSS_SAMPLES / 2];    // progressive Poisson Disk, two Samples per vec4
+};
+
+uniform sampler2D pcss_minmax;  // Min (r) and Max (g) Depth of the Region, every Level halves it
+uniform sampler2D pcss_noise;   // Blue Noise Rotation
+uniform int pcss_levels;
+uniform bool accelerated_pcss;
+
+vec2 PCSSSample(int i) {
+    vec4 pair = pcss_samples[i / 2];
+    return (i % 2 == 0) ? pair.xy : pair.zw;
+}
+
+// Min and Max Depth inside a Square around local <Region Coordinates>, the Level is picked so the Square spans at most 2x2 Texels
+vec2 RegionMinMax(vec2 local, float radius) {
+    float size0 = float(textureSize(pcss_minmax, 0).x);
+    int level = clamp(int(ceil(log2(max(2.0 * radius * size0, 1.0)))), 0, pcss_levels - 1);
+    ivec2 size = textureSize(pcss_minmax, level);
+
+    ivec2 lo = clamp(ivec2(floor((local - radius) * vec2(size))), ivec2(0), size - 1);
+    ivec2 hi = clamp(ivec2(floor((local + radius) * vec2(size))), ivec2(0), size - 1);
+    vec2 a = texelFetch(pcss_minmax, lo, level).rg;
+    vec2 b = texelFetch(pcss_minmax, ivec2(hi.x, lo.y), level).rg;
+    vec2 c = texelFetch(pcss_minmax, ivec2(lo.x, hi.y), level).rg;
+    vec2 d = texelFetch(pcss_minmax, hi, level).rg;
+
+    return vec2(min(min(a.r, b.r), min(c.r, d.r)), max(max(a.g, b.g), max(c.g, d.g)));
+}
+
+float PCSSAccelerated(sampler2D shadowmap, vec4 light_coord, vec3 lightDir, vec4 atlas) {
+    float receiver = light_coord.z - DepthAdjustment(lightDir);
+    vec2 local = (light_coord.xy - atlas.xy) / atlas.zw;
+
+    // Nothing in the Search Area is nearer to the Light: fully lit
+    vec2 search = RegionMinMax(local, PCSS_SEARCH_RADIUS / atlas.z);
+    if (receiver <= search.r)
+        return 1.0;
+
+    // Everything is nearer, even over the widest Penumbra the nearest Blocker allows: fully shadowed
+    if (receiver > search.g) {
+        float widest = PCSS_FILTER_SCALE * 2.0 * (light_coord.z - search.r) / max(search.r, EPS);
+        if (receiver > RegionMinMax(local, widest / atlas.z).g)
+            return 0.0;
+    }
+
+    // Blue Noise turns the Sample Set per Pixel <Banding becomes fine Noise>
+    float angle = texture(pcss_noise, gl_FragCoord.xy / vec2(textureSize(pcss_noise, 0))).r * PI2;
+    mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+
+    float sum = 0.0;
+    int num = 0;
+    for (int i = 0; i < PCSS_SEARCH_SAMPLES; ++i) {
+        float blocker_depth = texture(shadowmap, AtlasClamp(shadowmap, atlas, light_coord.xy + rotation * PCSSSample(i) * PCSS_SEARCH_RADIUS)).r;
+        if (blocker_depth < receiver) {
+            sum += blocker_depth;
+            num++;
+        }
+    }
+    if (num == 0)
+        return 1.0;
+
+    float avgBlockerDepth = sum / float(num);
+    float radius = PCSS_FILTER_SCALE * 2.0 * (light_coord.z - avgBlockerDepth) / max(avgBlockerDepth, EPS);
+
+    // Sample Count follows the Penumbra Width in Shadow Map Texels <every Prefix of the Set covers the Disk>
+    float texels = radius * float(textureSize(shadowmap, 0).x);
+    int count = clamp(int(ceil(texels * 4.0)), 8, PCSS_SAMPLES);
+
+    float shadow_factor = 0.0;
+    for (int i = 0; i < count; ++i) {
+        float blocker_depth = texture(shadowmap, AtlasClamp(shadowmap, atlas, light_coord.xy + rotation * PCSSSample(i) * radius)).r;
+        shadow_factor += blocker_depth < receiver ? 0.0 : 1.0;
+    }
+
+    return shadow_factor / float(count);
+}
+
+float PCSS(sampler2D shadowmap, vec4 light_coord, vec3 lightDir, vec4 atlas) {
     // avgBlockerDepth
-    float avgBlockerDepth = findBlocker(shadowmap, light_coord, lightDir);
+    float avgBlockerDepth = findBlocker(shadowmap, light_coord, lightDir, atlas);
     if (avgBlockerDepth < EPS)
         return 1.0;
     
@@ -197,7 +311,7 @@ float PCSS(sampler2D shadowmap, vec4 light_coord, vec3 lightDir) {
     float fliter_size = 2.0 * (light_coord.z - avgBlockerDepth) / avgBlockerDepth;
 
     // PCF_adptive
-    return PCF_adptive(shadowmap, light_coord, lightDir, fliter_size);
+    return PCF_adptive(shadowmap, light_coord, lightDir, fliter_size, atlas);
 }
 
 void main() {
@@ -214,16 +328,21 @@ void main() {
     vec4 light_coord = fs_in.dirlight_fragPos[0];
     // remap to [0, 1]
     light_coord = light_coord / light_coord.w * 0.5 + 0.5;
-    float imp = PCSS(dirlights[0].shadowmap, light_coord, -dirlights[0].direction) * 0.95 + 0.05;
+    // into the Light's Shadow Atlas Region
+    light_coord.xy = GetDirLight(0).atlas.xy + light_coord.xy * GetDirLight(0).atlas.zw;
+    Dirlight sun = GetDirLight(0);
+    float imp = accelerated_pcss ? PCSSAccelerated(dirlight_shadowmaps[sun.shadow], light_coord, -sun.direction, sun.atlas)
+                                 : PCSS(dirlight_shadowmaps[sun.shadow], light_coord, -sun.direction, sun.atlas);
+    imp = imp * 0.95 + 0.05;
 
-    // float imp = dot(normalize(-dirlights[0].direction), world_norm) > 0 ? 1.0: 0.2;
+    // float imp = dot(normalize(-GetDirLight(0).direction), world_norm) > 0 ? 1.0: 0.2;
 
     result += vec3(imp * texture(material.texture_diffuse1, coord));
 
     FragColor = vec4(result, 1.0);
 
     // visualize blocker depth
-    // float BlockerDep = findBlocker(dirlights[0].shadowmap, light_coord, -dirlights[0].direction);
+    // float BlockerDep = findBlocker(dirlight_shadowmaps[GetDirLight(0).shadow], light_coord, -GetDirLight(0).direction, GetDirLight(0).atlas);
     // FragColor = vec4(vec3(BlockerDep, BlockerDep, BlockerDep), 1.0);
     
     // Brightness for Bloom
@@ -282,4 +401,21 @@ bool IsBright(vec3 lightdir, vec3 norm) {
 
 float Brightness(PointLight light, vec3 frag2light) {
     return light.attrib.diffuse.r / (1.0 + light.attenuation.constant + light.attenuation.linear * length(frag2light));
+}
+
+Dirlight GetDirLight(int i) {
+    Light light = lights[i];
+    return Dirlight(light.direction.xyz, int(light.direction.w), light.position, LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb));
+}
+
+PointLight GetPointLight(int i) {
+    Light light = lights[num_dirlight + i];
+    return PointLight(light.position.xyz, int(light.direction.w), light.position.w,
+                      LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb), Attenuation(light.ambient.a, light.diffuse.a));
+}
+
+SpotLight GetSpotLight(int i) {
+    Light light = lights[num_dirlight + num_pointlight + i];
+    return SpotLight(light.position.xyz, light.direction.xyz, LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb),
+                     Attenuation(light.ambient.a, light.diffuse.a), light.specular.a, light.position.w);
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+#version 330 core
+
+// 13 Tap Downsample of the Bloom Chain: 4 overlapping 2 * 2 Boxes around the Center and one at it, read with 13
+// bilinear Taps. On the first Level every Box is weighted by its inverse Luma <Karis Average> against Fireflies
+
+out vec4 FragColor;
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+uniform sampler2D image;
+uniform vec2 texel_size;    // of the Source
+uniform vec2 source_max;    // last Texel Center of the Source's Region
+uniform bool karis;
+
+vec3 Tap(float x, float y) {
+    return texture(image, min(fs_in.texCoords + vec2(x, y) * texel_size, source_max)).rgb;
+}
+
+float KarisWeight(vec3 box) {
+    return 1.0 / (1.0 + dot(box, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+void main() {
+    vec3 a = Tap(-2.0, 2.0);
+    vec3 b = Tap(0.0, 2.0);
+    vec3 c = Tap(2.0, 2.0);
+    vec3 d = Tap(-2.0, 0.0);
+    vec3 e = Tap(0.0, 0.0);
+    vec3 f = Tap(2.0, 0.0);
+    vec3 g = Tap(-2.0, -2.0);
+    vec3 h = Tap(0.0, -2.0);
+    vec3 i = Tap(2.0, -2.0);
+    vec3 j = Tap(-1.0, 1.0);
+    vec3 k = Tap(1.0, 1.0);
+    vec3 l = Tap(-1.0, -1.0);
+    vec3 m = Tap(1.0, -1.0);
+
+    vec3 result;
+    if (karis)
+    {
+        vec3 boxes[5] = vec3[] ((j + k + l + m) * 0.25, (a + b + d + e) * 0.25, (b + c + e + f) * 0.25, (d + e + g + h) * 0.25, (e + f + h + i) * 0.25);
+        float weights[5] = float[] (0.5, 0.125, 0.125, 0.125, 0.125);
+        result = vec3(0.0);
+        float total = 0.0;
+        for (int n = 0; n < 5; ++n)
+        {
+            float weight = weights[n] * KarisWeight(boxes[n]);
+            result += boxes[n] * weight;
+            total += weight;
+        }
+        result /= total;
+    }
+    else
+        result = e * 0.125 + (a + c + g + i) * 0.03125 + (b + d + f + h) * 0.0625 + (j + k + l + m) * 0.125;
+
+    FragColor = vec4(result, 1.0);
+}
@@ -7,7 +7,10 @@ out VS_OUT {
     vec2 texCoords;
 } vs_out;
 
+// Dynamic Resolution: the Image fills only this Fraction of its Texture <1.0 draws the whole Texture>
+uniform vec2 viewport_scale = vec2(1.0);
+
 void main() {
     gl_Position = vec4(aPosition, 0.0, 1.0);
-    vs_out.texCoords = atexCoords;
+    vs_out.texCoords = atexCoords * viewport_scale;
 }
\ No newline at end of file
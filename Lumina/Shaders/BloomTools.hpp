@@ -1,85 +1,139 @@
+// Bloom on a Mip Chain: the bright Attachment is filtered down through half sized Levels with a 13 Tap Downsample and
+// back up with a 3 * 3 Tent, every Level adding onto the one above it. The Level Count sets the Radius, the Result
+// <Level 0, half the Source's Size> is added by the Tone Map Pass instead of a Mix Pass of its own
 #pragma once
 
 #include <vector>
+#include <algorithm>
 
 #include"../Shader.hpp"
 #include "./FrameBuffer.hpp"
+#include "./RenderTargetPool.hpp"
+
+const int BLOOM_MAX_LEVELS = 8;
 
 class BloomTool
 {
 public:
-    BloomTool(FrameBuffer *_origin_fb, Shader *_blur_shader, Shader *_mix_shader)
-    {
-        blur_shader = _blur_shader;
-        mix_shader = _mix_shader;
-        origin_color = _origin_fb->ServeTextures().at(0);
-        origin_bright = _origin_fb->ServeTextures().at(1);
+    float strength = 0.35f;     // of the Level Sum, shared out over the Levels
 
-        blur_fbs.push_back(FrameBuffer(_origin_fb->ScreenWidth, _origin_fb->ScreenHeight, _origin_fb->Samples));
-        blur_fbs.push_back(FrameBuffer(_origin_fb->ScreenWidth, _origin_fb->ScreenHeight, _origin_fb->Samples));
+    // Level Targets come from the Pool while Bloom runs <single sampled, the Sources are resolved anyway>
+    // the Source's Attachments are fetched on every ApplyBloom so a multisampled Source gets resolved after its Writes
+    BloomTool(FrameBuffer *_origin_fb, Shader *_downsample_shader, Shader *_upsample_shader, RenderTargetPool *_pool)
+    {
+        downsample_shader = _downsample_shader;
+        upsample_shader = _upsample_shader;
+        pool = _pool;
+        origin_fb = _origin_fb;
     }
 
-    void ApplyBloom(int loop)
+    // Level 0 is half of the Source, every further Level half of the one before <never below 1 Pixel>
+    static glm::ivec2 LevelSize(int width, int height, int level)
     {
-        Bloom(loop);
-        Mix();
+        int divisor = 2 << level;
+        return glm::max(glm::ivec2((width + divisor - 1) / divisor, (height + divisor - 1) / divisor), glm::ivec2(1));
     }
 
-    unsigned int tex_finished()
+    void ApplyBloom(int levels)
     {
-        return blur_fbs.at(0).ServeTextures().at(0);
-    }
+        Release();
+        levels = std::clamp(levels, 1, BLOOM_MAX_LEVELS);
+        // the Source's current Size <it may have been resized>
+        for (int i = 0; i < levels; ++i)
+        {
+            glm::ivec2 size = LevelSize(origin_fb->ScreenWidth, origin_fb->ScreenHeight, i);
+            chain.push_back(pool->Acquire(size.x, size.y, GL_RGB16F));
+        }
 
-private:
-    std::vector<FrameBuffer> blur_fbs;
-    unsigned int origin_color;
-    unsigned int origin_bright;
-    Shader *blur_shader;
-    Shader *mix_shader;
+        ApplyBloom(chain, origin_fb->ScreenWidth, origin_fb->ScreenHeight);
 
-    void Bloom(int loop)
+        // only Level 0 lives on
+        for (size_t i = 1; i < chain.size(); ++i)
+            pool->Release(chain[i]);
+        chain.resize(1);
+    }
+
+    // Targets owned by the Caller <RGB16F, Level i at LevelSize of the Source>, the Source is read in its lower left
+    // region_width * region_height <Dynamic Resolution> and the Levels are drawn in the matching Fractions
+    void ApplyBloom(const std::vector<RenderTarget *> &levels, int region_width, int region_height)
     {
-        bool enter = true;
-        blur_shader->Use();
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+
+        // the Source is resolved once per Frame, and only the Attachment read here
+        unsigned int source = origin_fb->ServeTexture(1);
+        glm::ivec2 source_size(origin_fb->ScreenWidth, origin_fb->ScreenHeight);
+        glm::ivec2 source_region(region_width, region_height);
+
+        downsample_shader->Use();
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            glm::ivec2 region = LevelSize(region_width, region_height, i);
+            // Karis Average on the first Level keeps single bright Pixels from flickering
+            downsample_shader->setBool("karis", i == 0);
+            draw(downsample_shader, source, source_size, source_region, levels[i], region);
+            source = levels[i]->texture;
+            source_size = glm::ivec2(levels[i]->width, levels[i]->height);
+            source_region = region;
+        }
 
-        for (int i = 0; i < loop; ++i)
+        upsample_shader->Use();
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (int i = (int)levels.size() - 2; i >= 0; --i)
         {
-            // Horizontal
-            glBindFramebuffer(GL_FRAMEBUFFER, blur_fbs.at(0).ID);
-            glDisable(GL_DEPTH_TEST);   // When Using FrameBuffers Remind Yourself to Disable Depth_Test otherwise the Screen will be Invisible
-            glClear(GL_COLOR_BUFFER_BIT);
-            blur_shader->setBool("horizontal", true);
-            blur_fbs.at(0).Draw(enter ? origin_bright : blur_fbs.at(1).ServeTextures().at(0));
-
-            enter = false;
-
-            // Vertical
-            glBindFramebuffer(GL_FRAMEBUFFER, blur_fbs.at(1).ID);
-            glClear(GL_COLOR_BUFFER_BIT);
-            blur_shader->setBool("horizontal", false);
-            blur_fbs.at(1).Draw(blur_fbs.at(0).ServeTextures().at(0));
+            glm::ivec2 size(levels[i + 1]->width, levels[i + 1]->height);
+            draw(upsample_shader, levels[i + 1]->texture, size, LevelSize(region_width, region_height, i + 1), levels[i], LevelSize(region_width, region_height, i));
         }
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_BLEND);
+
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        applied_levels = levels.size();
     }
 
-    void Mix()
+    // Tone Map Shader <HDR.frag, PostCompositor.frag> adds Level 0 on GL_TEXTURE1, 0 turns Bloom off
+    void ToneMapConfig(Shader *_tonemap_shader, unsigned int _bloom_texture)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, blur_fbs.at(0).ID);
-        glDisable(GL_DEPTH_TEST);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        mix_shader->Use();
+        _tonemap_shader->setBool("Bloom", _bloom_texture != 0);
+        _tonemap_shader->setFloat("bloom_strength", strength / std::max(applied_levels, 1));
+        _tonemap_shader->setInt("bloomblur", 1);
         glActiveTexture(GL_TEXTURE1);
-        mix_shader->setInt("color", 1);
-        glBindTexture(GL_TEXTURE_2D, origin_color);
+        glBindTexture(GL_TEXTURE_2D, _bloom_texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
 
-        glActiveTexture(GL_TEXTURE2);
-        mix_shader->setInt("bloomblur", 2);
-        glBindTexture(GL_TEXTURE_2D, blur_fbs.at(1).ServeTextures().at(0));
+    unsigned int tex_finished()
+    {
+        return chain.empty() ? 0 : chain[0]->texture;
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-        blur_fbs.at(0).Draw(0);
+    // Once tex_finished has been drawn <otherwise the next ApplyBloom releases it>
+    void Release()
+    {
+        for (RenderTarget *target : chain)
+            pool->Release(target);
+        chain.clear();
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+private:
+    std::vector<RenderTarget *> chain;
+    int applied_levels = 0;
+    RenderTargetPool *pool;
+    FrameBuffer *origin_fb;
+    Shader *downsample_shader;
+    Shader *upsample_shader;
+
+    // Taps stay inside the Source's Region, the Texels past it hold stale Data
+    void draw(Shader *shader, unsigned int source, glm::ivec2 source_size, glm::ivec2 source_region, RenderTarget *target, glm::ivec2 region)
+    {
+        glm::vec2 size(source_size);
+        shader->setVec2("viewport_scale", glm::vec2(source_region) / size);
+        shader->setVec2("texel_size", 1.0f / size);
+        shader->setVec2("source_max", (glm::vec2(source_region) - 0.5f) / size);
+
+        pool->Bind(target);
+        glViewport(0, 0, region.x, region.y);
+        pool->Draw(source);
     }
-};
\ No newline at end of file
+};
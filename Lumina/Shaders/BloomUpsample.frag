@@ -0,0 +1,25 @@
+#version 330 core
+
+// 3 * 3 Tent over the smaller Level of the Bloom Chain, added onto the larger one by the Blend State
+
+out vec4 FragColor;
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+uniform sampler2D image;
+uniform vec2 texel_size;    // of the Source
+uniform vec2 source_max;    // last Texel Center of the Source's Region
+
+vec3 Tap(float x, float y) {
+    return texture(image, min(fs_in.texCoords + vec2(x, y) * texel_size, source_max)).rgb;
+}
+
+void main() {
+    vec3 result = Tap(0.0, 0.0) * 4.0;
+    result += (Tap(0.0, 1.0) + Tap(-1.0, 0.0) + Tap(1.0, 0.0) + Tap(0.0, -1.0)) * 2.0;
+    result += Tap(-1.0, 1.0) + Tap(1.0, 1.0) + Tap(-1.0, -1.0) + Tap(1.0, -1.0);
+
+    FragColor = vec4(result / 16.0, 1.0);
+}
@@ -0,0 +1,5 @@
+#version 330 core
+
+// Depth only <Color Writes are masked off>
+void main() {
+}
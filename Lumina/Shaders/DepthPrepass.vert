@@ -0,0 +1,20 @@
+#version 330 core
+// Position only, the Geometry Pass then shades with GL_EQUAL against this Depth
+layout(location = 0) in vec3 aPosition;
+
+uniform mat4 model;
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+// Same Expression as the shading Pass so both land on bit-identical Depth
+invariant gl_Position;
+
+void main() {
+    vec4 temp = model * vec4(aPosition, 1.0);
+    temp = view * temp;
+    gl_Position = projection * temp;
+}
@@ -0,0 +1,28 @@
+#version 460 core
+// Position only, the Geometry Pass then shades with GL_EQUAL against this Depth
+layout(location = 0) in vec3 aPosition;
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+// One Entry per glMultiDrawElementsIndirect Command <MaterialSystem.hpp>
+struct DrawData {
+    mat4 model;
+    uint material;
+};
+
+layout (std430, binding = 1) readonly buffer Draws {
+    DrawData draws[];
+};
+
+// Same Expression as GeometryPassBatched.vert so both land on bit-identical Depth
+invariant gl_Position;
+
+void main() {
+    vec4 temp = draws[gl_DrawID].model * vec4(aPosition, 1.0);
+    temp = view * temp;
+    gl_Position = projection * temp;
+}
@@ -0,0 +1,92 @@
+// Internal Resolution driven by the measured GPU Frame Time: Targets stay at the native Size and the Scene
+// draws into a scaled lower left Region, the Upscale Pass brings it back to the native Resolution
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#include "../imgui/imgui.h"
+
+// Profiler Results trail the Frame by a few Frames, Changes wait for them to catch up
+const int DYNAMIC_RESOLUTION_SETTLE_FRAMES = 8;
+
+class DynamicResolution
+{
+public:
+    bool enabled;
+    float target_ms;    // GPU Time per Frame to hold
+    float min_scale;    // per Axis
+    float max_scale;
+    float headroom;     // Fraction around target_ms that leaves the Scale alone
+
+    DynamicResolution(float target_ms = 16.0f, float min_scale = 0.5f, float max_scale = 1.0f)
+    {
+        enabled = true;
+        this->target_ms = target_ms;
+        this->min_scale = min_scale;
+        this->max_scale = max_scale;
+        headroom = 0.05f;
+        scale = max_scale;
+        settle = 0;
+        last_ms = 0.0;
+    }
+
+    // Once per Frame with the GPU Time of the last measured Frame
+    void Update(double gpu_ms)
+    {
+        last_ms = gpu_ms;
+        if (!enabled)
+        {
+            scale = max_scale;
+            return;
+        }
+        if (settle > 0)
+        {
+            --settle;
+            return;
+        }
+        if (gpu_ms <= 0.0 || std::abs(gpu_ms / target_ms - 1.0) < headroom)
+            return;
+
+        // Pixel Cost scales with the Area, so each Axis with the Square Root, damped and limited per Step
+        float wanted = scale * (float)std::sqrt(target_ms / gpu_ms);
+        wanted = scale + 0.5f * (wanted - scale);
+        wanted = std::clamp(wanted, scale - 0.1f, scale + 0.05f);
+        wanted = std::clamp(wanted, min_scale, max_scale);
+        if (std::abs(wanted - scale) < 0.01f)
+            return;
+
+        scale = wanted;
+        settle = DYNAMIC_RESOLUTION_SETTLE_FRAMES;
+    }
+
+    // Internal Width or Height for a native one, rounded up to 8 Pixels
+    int ServeSize(int native)
+    {
+        if (scale >= 1.0f)
+            return native;
+        int size = ((int)std::ceil(native * scale) + 7) / 8 * 8;
+        return std::min(std::max(size, 8), native);
+    }
+
+    float ServeScale()
+    {
+        return scale;
+    }
+
+    void ImGuiStatus(int native_width, int native_height)
+    {
+        ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Dynamic Resolution:");
+        ImGui::Checkbox("Dynamic Resolution", &enabled);
+        ImGui::SliderFloat("Target GPU Time", &target_ms, 2.0f, 50.0f, "%.1fms");
+        ImGui::SliderFloat("Min Scale", &min_scale, 0.25f, 1.0f, "%.2f");
+        max_scale = std::max(max_scale, min_scale);
+        ImGui::BulletText("Scale:%.2f Internal:%d * %d Native:%d * %d", scale, ServeSize(native_width), ServeSize(native_height), native_width, native_height);
+        ImGui::BulletText("GPU Frame:%.2fms", last_ms);
+    }
+
+private:
+    float scale;
+    int settle;
+    double last_ms;
+};
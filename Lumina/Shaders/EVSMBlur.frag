@@ -0,0 +1,25 @@
+#version 430 core
+// One Direction of the separable Gaussian over the Moments
+
+layout (location = 0) out vec4 Moments;
+
+uniform sampler2D image;
+uniform bool horizontal;
+uniform int radius;
+
+void main() {
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(image, 0);
+    ivec2 direction = horizontal ? ivec2(1, 0) : ivec2(0, 1);
+    float sigma = max(float(radius) * 0.5, 0.5);
+
+    vec4 sum = vec4(0.0);
+    float total = 0.0;
+    for (int i = -radius; i <= radius; ++i) {
+        float weight = exp(-float(i * i) / (2.0 * sigma * sigma));
+        sum += weight * texelFetch(image, clamp(coord + i * direction, ivec2(0), size - 1), 0);
+        total += weight;
+    }
+
+    Moments = sum / total;
+}
\ No newline at end of file
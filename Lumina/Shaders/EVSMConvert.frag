@@ -0,0 +1,32 @@
+#version 430 core
+// Depth to Exponential Variance Moments, averaging ratio * ratio Depth Texels into each Texel
+
+layout (location = 0) out vec4 Moments;
+
+uniform sampler2D depth_single;
+uniform sampler2DArray depth_array;
+uniform bool array_source;
+uniform int layer;
+uniform int ratio;
+uniform vec2 exponents;     // positive, negative
+
+vec2 Warp(float depth) {
+    depth = 2.0 * depth - 1.0;
+    return vec2(exp(exponents.x * depth), -exp(-exponents.y * depth));
+}
+
+void main() {
+    ivec2 base = ratio * ivec2(gl_FragCoord.xy);
+
+    vec4 sum = vec4(0.0);
+    for (int y = 0; y < ratio; ++y) {
+        for (int x = 0; x < ratio; ++x) {
+            float depth = array_source ? texelFetch(depth_array, ivec3(base + ivec2(x, y), layer), 0).r
+                                       : texelFetch(depth_single, base + ivec2(x, y), 0).r;
+            vec2 warped = Warp(depth);
+            sum += vec4(warped.x, warped.x * warped.x, warped.y, warped.y * warped.y);
+        }
+    }
+
+    Moments = sum / float(ratio * ratio);
+}
\ No newline at end of file
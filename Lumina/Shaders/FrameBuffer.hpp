@@ -47,6 +47,8 @@ public:
             build();
             Check();
         }
+        dirty.assign(texturelayers, true);
+        resolves = 0;
 
 #ifdef _FRAMEBUFFER_DEBUG
         if (!no_init) {
@@ -72,27 +74,79 @@ public:
 
     void Delete()
     {
-        glDeleteFramebuffers(1, &ID);
-        glDeleteBuffers(1, &VAO);
+        release();
+        glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
+    }
 
-        if (Samples > 1)
-            glDeleteFramebuffers(1, &tmpfbo);
+    // Reallocates every Attachment at the new Size <Texture IDs change, Pointers to this FrameBuffer stay valid>
+    // noInit FrameBuffers are resized by their Owner <GBuffer::Resize>
+    void Resize(int width, int height)
+    {
+        if (width == ScreenWidth && height == ScreenHeight)
+            return;
+
+        ScreenWidth = width;
+        ScreenHeight = height;
+        if (!noInit)
+        {
+            release();
+            build();
+            Check();
+        }
+        MarkDirty();
     }
 
+    // Binds for Drawing, the resolved Copies are stale from here on
+    void Bind()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, ID);
+        MarkDirty();
+    }
+
+    // for Writes that don't go through Bind <Blits, Compute, direct glBindFramebuffer>
+    void MarkDirty()
+    {
+        dirty.assign(texturelayers, true);
+        resolves = 0;
+    }
+
+    // Every Attachment resolved, each at most once after the last Write
     std::vector<unsigned int> ServeTextures()
     {
         if(Samples > 1)
         {
-            glBlitNamedFramebuffer(ID, tmpfbo, 0, 0, ScreenWidth, ScreenHeight, 0, 0, ScreenWidth, ScreenHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
+            for (int i = 0; i < texturelayers; ++i)
+                resolve(i);
             return tmp_texture_attachments;
         }
         else
             return texture_attachments;
     }
 
+    // Only the Attachment being read is resolved
+    unsigned int ServeTexture(int slot)
+    {
+        if (Samples > 1)
+        {
+            resolve(slot);
+            return tmp_texture_attachments.at(slot);
+        }
+        return texture_attachments.at(slot);
+    }
+
+    // the Attachments as drawn, never resolves <Multisampled Textures when Samples > 1>
+    const std::vector<unsigned int> &ServeAttachments()
+    {
+        return texture_attachments;
+    }
+
+    // Blits since the last Bind or MarkDirty <at most one per Attachment>
+    int ServeResolves()
+    {
+        return resolves;
+    }
+
     void MRTRenderConfig()
     {
         std::vector<unsigned int> attachments;
@@ -137,6 +191,44 @@ private:
     std::vector<unsigned int> tmp_texture_attachments;
     unsigned int tmp_render_buffer;
 
+    // Attachments written since their last Resolve
+    std::vector<bool> dirty;
+    int resolves;
+
+    // GL Objects behind the Attachments <the Screen Quad stays>
+    void release()
+    {
+        if (noInit)
+            return;
+
+        glDeleteFramebuffers(1, &ID);
+        glDeleteTextures((GLsizei)texture_attachments.size(), texture_attachments.data());
+        glDeleteRenderbuffers(1, &renderbuffer);
+        texture_attachments.clear();
+
+        if (Samples > 1)
+        {
+            glDeleteFramebuffers(1, &tmpfbo);
+            glDeleteTextures((GLsizei)tmp_texture_attachments.size(), tmp_texture_attachments.data());
+            glDeleteRenderbuffers(1, &tmp_render_buffer);
+            tmp_texture_attachments.clear();
+        }
+    }
+
+    void resolve(int slot)
+    {
+        if (!dirty.at(slot))
+            return;
+
+        glNamedFramebufferReadBuffer(ID, GL_COLOR_ATTACHMENT0 + slot);
+        glNamedFramebufferDrawBuffer(tmpfbo, GL_COLOR_ATTACHMENT0 + slot);
+        glBlitNamedFramebuffer(ID, tmpfbo, 0, 0, ScreenWidth, ScreenHeight, 0, 0, ScreenWidth, ScreenHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glNamedFramebufferReadBuffer(ID, GL_COLOR_ATTACHMENT0);
+
+        dirty[slot] = false;
+        ++resolves;
+    }
+
     void build()
     {
         glGenFramebuffers(1, &ID);
@@ -0,0 +1,7 @@
+#version 430 core
+// One Triangle covering the Target <no Vertex Buffer needed>
+
+void main() {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
@@ -4,99 +4,103 @@
 #include "FrameBuffer.hpp"
 #include "../Shader.hpp"
 
-const int texture_layers = 5;
-
 class GBuffer
 {
 public:
     FrameBuffer fb;
     int SCRWidth;
     int SCRHeight;
-    unsigned int gPosition_World;
-    unsigned int gPosition_View;
-    unsigned int gNormal_World;
-    unsigned int gNormal_View;
+    unsigned int gDepth;
+    unsigned int gNormal;
     unsigned int gAlbedoSpec;
+    unsigned int gMaterial;     // 0 without the Material Layer
 
-    /* 
+    /*
     texture_attachment layout:
-    0||gPostion_World(RGB)linearized_depth(A)   ||RBGA16F
-    1||gPosition_View(RGB)linearized_depth(A)   ||RGBA16F
-    2||gNormal_World                            ||RGBA16F
-    3||gNormal_View                             ||RGBA16F
-    4||gAlbedo(RGB)Specular(A)                  ||RGBA
+    0||gNormal_World <octahedral>               ||RG16
+    1||gAlbedo(RGB)Specular(A)                  ||RGBA8
+    2||gRoughness(R)Metallic(G) <optional>      ||RG8
+    depth_stencil||gDepth <sampleable>          ||DEPTH24_STENCIL8
+    Positions are rebuilt from gDepth and the Projection, View Space Normals through the View Matrix
+    Lighting reads Roughness and Metallic from gMaterial, without the Layer it falls back to Shininess 32 and no Metal
     */
 
-    GBuffer(int width, int height) : fb(width, height, 1, texture_layers, true)
+    GBuffer(int width, int height, bool material_layer = false) : fb(width, height, 1, material_layer ? 3 : 2, true)
     {
         SCRWidth = width;
         SCRHeight = height;
+        build();
+    }
 
-        glGenFramebuffers(1, &fb.ID);
-        glBindFramebuffer(GL_FRAMEBUFFER, fb.ID);
+    void Delete()
+    {
+        release();
+        fb.Delete();
+    }
 
-        // gPosition_World
-        glGenTextures(1, &gPosition_World);
-        glBindTexture(GL_TEXTURE_2D, gPosition_World);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCRWidth, SCRHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glBindTexture(GL_TEXTURE_2D,0);
+    // New Textures at the new Size <Window Resizes>, Pointers to the GBuffer stay valid
+    void Resize(int width, int height)
+    {
+        if (width == SCRWidth && height == SCRHeight)
+            return;
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition_World, 0);
-        fb.texture_attachments.push_back(gPosition_World);
+        release();
+        SCRWidth = width;
+        SCRHeight = height;
+        fb.Resize(width, height);
+        build();
+    }
 
-        // gPosition_View
-        glGenTextures(1, &gPosition_View);
-        glBindTexture(GL_TEXTURE_2D, gPosition_View);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCRWidth, SCRHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glBindTexture(GL_TEXTURE_2D,0);
+    // GL_TEXTURE1 ~ 6 Reserved for Deferred Rendering
+    void Deferred_Rendering_Config(Shader* _lighting_pass_shader)
+    {
+        _lighting_pass_shader->setInt("gbuffertex.gDepth", 1);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, gDepth);
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + 1, GL_TEXTURE_2D, gPosition_View, 0);
-        fb.texture_attachments.push_back(gPosition_View);
+        _lighting_pass_shader->setInt("gbuffertex.gNormal", 2);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, gNormal);
 
-        // gNormal_World
-        glGenTextures(1, &gNormal_World);
-        glBindTexture(GL_TEXTURE_2D, gNormal_World);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCRWidth, SCRHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        _lighting_pass_shader->setInt("gbuffertex.gAlbedoSpec", 3);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + 2, GL_TEXTURE_2D, gNormal_World, 0);
-        fb.texture_attachments.push_back(gNormal_World);
+        _lighting_pass_shader->setInt("gbuffertex.gMaterial", 4);
+        _lighting_pass_shader->setBool("gbuffertex.material_layer", gMaterial != 0);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, gMaterial);
 
-        // gNormal_View
-        glGenTextures(1, &gNormal_View);
-        glBindTexture(GL_TEXTURE_2D, gNormal_View);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCRWidth, SCRHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, 0);
+    }
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + 3, GL_TEXTURE_2D, gNormal_View, 0);
-        fb.texture_attachments.push_back(gNormal_View);
+    // Bytes per Pixel written by the Geometry Pass and read back by Lighting
+    int ServePixelBytes()
+    {
+        return 4 + 4 + (gMaterial ? 2 : 0) + 4;
+    }
 
-        // gAlbedoSpec
-        glGenTextures(1, &gAlbedoSpec);
-        glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCRWidth, SCRHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glBindTexture(GL_TEXTURE_2D,0);
+private:
+    void build()
+    {
+        glGenFramebuffers(1, &fb.ID);
+        glBindFramebuffer(GL_FRAMEBUFFER, fb.ID);
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + 4, GL_TEXTURE_2D, gAlbedoSpec, 0);
-        fb.texture_attachments.push_back(gAlbedoSpec);
+        // gNormal
+        gNormal = attachment(GL_RG16, GL_COLOR_ATTACHMENT0);
+
+        // gAlbedoSpec
+        gAlbedoSpec = attachment(GL_RGBA8, GL_COLOR_ATTACHMENT0 + 1);
 
-        //RBO Config
-        glGenRenderbuffers(1, &fb.renderbuffer);
-        glBindRenderbuffer(GL_RENDERBUFFER, fb.renderbuffer);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCRWidth, SCRHeight);
-        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        // gMaterial
+        gMaterial = 0;
+        if (fb.texturelayers == 3)
+            gMaterial = attachment(GL_RG8, GL_COLOR_ATTACHMENT0 + 2);
 
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, fb.renderbuffer);
+        // gDepth <replaces the RenderBuffer so Lighting and SSAO can read it>
+        gDepth = attachment(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL_ATTACHMENT);
+        fb.renderbuffer = 0;
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -113,33 +117,35 @@ public:
         std::cout << "\tTextures: " << std::endl;
         for (int i = 0; i < fb.texture_attachments.size(); ++i)
             std::cout << "\tSlot: " << i << " || " << fb.texture_attachments.at(i) << std::endl;
+        std::cout << "\tDepth: " << gDepth << std::endl;
 #endif
     }
 
-    // GL_TEXTURE1 ~ 6 Reserved for Deferred Rendering
-    void Deferred_Rendering_Config(Shader* _lighting_pass_shader)
+    void release()
     {
-        _lighting_pass_shader->setInt("gbuffertex.gPosition_World", 1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, gPosition_World);
-
-        _lighting_pass_shader->setInt("gbuffertex.gPosition_View", 2);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gPosition_View);
-
-        _lighting_pass_shader->setInt("gbuffertex.gNormal_World", 3);
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, gNormal_World);
-
-        _lighting_pass_shader->setInt("gbuffertex.gNormal_View", 4);
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, gNormal_View);
-
-        _lighting_pass_shader->setInt("gbuffertex.gAlbedoSpec", 5);
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
+        glDeleteFramebuffers(1, &fb.ID);
+        unsigned int textures[] = {gNormal, gAlbedoSpec, gDepth};
+        glDeleteTextures(3, textures);
+        if (gMaterial)
+            glDeleteTextures(1, &gMaterial);
+        fb.texture_attachments.clear();
+    }
 
-        glActiveTexture(GL_TEXTURE0);
+    unsigned int attachment(GLenum format, GLenum slot)
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, format, SCRWidth, SCRHeight);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glBindTexture(GL_TEXTURE_2D, 0);
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, slot, GL_TEXTURE_2D, texture, 0);
+        if (slot != GL_DEPTH_STENCIL_ATTACHMENT)
+            fb.texture_attachments.push_back(texture);
+        return texture;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,126 @@
+#version 330 core
+
+// Horizon based Ambient Occlusion <GTAO> at half Resolution: every Pixel searches the Horizons of a few Slices around
+// the View Vector and integrates the cosine weighted Visibility between them. Slice Angles and Step Offsets follow an
+// interleaved Gradient Noise that moves every Frame, the Temporal Pass averages the Pattern out
+
+const int GTAO_SLICES = 2;
+const int GTAO_STEPS = 4;               // per Side of a Slice
+const float GTAO_MAX_PIXELS = 48.0;     // Screen Radius Limit at half Resolution <close ups stay cheap>
+const float PI = 3.14159265359;
+const float HALF_PI = 1.57079632679;
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+out float FragColor;    // Visibility, 1.0 is unoccluded
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+uniform sampler2D depth_normal;     // GTAODownsample.frag
+uniform ivec2 render_size;          // full internal Resolution
+uniform float radius;               // World Units
+uniform int frame;
+
+vec3 ViewPosition(vec2 uv, float linear_depth);
+vec3 HalfPosition(ivec2 texel, ivec2 half_size);
+float InterleavedGradientNoise(vec2 pixel);
+vec3 DecodeNormal(vec2 encoded);
+
+void main() {
+    ivec2 half_size = (render_size + 1) / 2;
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 center = texelFetch(depth_normal, texel, 0);
+    vec3 position = HalfPosition(texel, half_size);
+    vec3 normal = DecodeNormal(center.gb);
+    vec3 viewvec = normalize(-position);
+
+    // Radius projected into half Resolution Pixels
+    float pixels = radius * projection[1][1] * 0.5 * float(half_size.y) / center.r;
+    if (pixels < 1.0) {
+        FragColor = 1.0;
+        return;
+    }
+    float stride = min(pixels, GTAO_MAX_PIXELS) / float(GTAO_STEPS);
+
+    // 6 Frames of Rotation before the Pattern repeats <the Temporal Pass keeps up to 16>
+    float offset = float(frame % 6);
+    float rotation = InterleavedGradientNoise(gl_FragCoord.xy + 5.588238 * offset);
+    float jitter = InterleavedGradientNoise(gl_FragCoord.yx + 7.123456 * offset);
+
+    float visibility = 0.0;
+    for (int slice = 0; slice < GTAO_SLICES; ++slice) {
+        // gl_FragCoord and View Space share their Axes, a Pixel Direction is a View Direction
+        float phi = (float(slice) + rotation) * PI / float(GTAO_SLICES);
+        vec2 direction = vec2(cos(phi), sin(phi));
+        vec3 direction3 = vec3(direction, 0.0);
+        vec3 ortho = direction3 - dot(direction3, viewvec) * viewvec;
+        vec3 axis = normalize(cross(ortho, viewvec));
+
+        // Normal projected into the Slice Plane and its Angle to the View Vector
+        vec3 projected = normal - axis * dot(normal, axis);
+        float projected_length = length(projected);
+        float cos_n = clamp(dot(projected, viewvec) / max(projected_length, 1e-4), 0.0, 1.0);
+        float n = sign(dot(ortho, projected)) * acos(cos_n);
+
+        // Horizons start below the Normal's Hemisphere, Samples past the Radius fade back to it
+        float low0 = cos(n + HALF_PI);
+        float low1 = cos(n - HALF_PI);
+        float horizon0 = low0;
+        float horizon1 = low1;
+        for (int i = 0; i < GTAO_STEPS; ++i) {
+            vec2 march = direction * max((float(i) + jitter) * stride, 1.0);
+
+            vec3 delta = HalfPosition(texel + ivec2(round(march)), half_size) - position;
+            float len2 = dot(delta, delta);
+            float falloff = clamp(1.0 - len2 / (radius * radius), 0.0, 1.0);
+            horizon0 = max(horizon0, mix(low0, dot(delta, viewvec) * inversesqrt(len2 + 1e-6), falloff));
+
+            delta = HalfPosition(texel - ivec2(round(march)), half_size) - position;
+            len2 = dot(delta, delta);
+            falloff = clamp(1.0 - len2 / (radius * radius), 0.0, 1.0);
+            horizon1 = max(horizon1, mix(low1, dot(delta, viewvec) * inversesqrt(len2 + 1e-6), falloff));
+        }
+
+        // cosine weighted Visibility of the Arc between both Horizons, clamped to the Normal's Hemisphere
+        float h0 = -acos(clamp(horizon1, -1.0, 1.0));
+        float h1 = acos(clamp(horizon0, -1.0, 1.0));
+        h0 = n + max(h0 - n, -HALF_PI);
+        h1 = n + min(h1 - n, HALF_PI);
+        float arc0 = (cos_n + 2.0 * h0 * sin(n) - cos(2.0 * h0 - n)) * 0.25;
+        float arc1 = (cos_n + 2.0 * h1 * sin(n) - cos(2.0 * h1 - n)) * 0.25;
+        visibility += projected_length * (arc0 + arc1);
+    }
+
+    FragColor = clamp(visibility / float(GTAO_SLICES), 0.0, 1.0);
+}
+
+vec3 ViewPosition(vec2 uv, float linear_depth) {
+    vec2 ndc = uv * 2.0 - 1.0;
+    vec2 xy = linear_depth * (ndc + vec2(projection[2][0], projection[2][1])) / vec2(projection[0][0], projection[1][1]);
+    return vec3(xy, -linear_depth);
+}
+
+// a half Resolution Texel sits on the lower left full Resolution Texel of its Block
+vec3 HalfPosition(ivec2 texel, ivec2 half_size) {
+    texel = clamp(texel, ivec2(0), half_size - 1);
+    vec2 uv = (vec2(min(texel * 2, render_size - 1)) + 0.5) / vec2(render_size);
+    return ViewPosition(uv, texelFetch(depth_normal, texel, 0).r);
+}
+
+float InterleavedGradientNoise(vec2 pixel) {
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+vec3 DecodeNormal(vec2 encoded) {
+    encoded = encoded * 2.0 - 1.0;
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
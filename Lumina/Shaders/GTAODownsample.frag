@@ -0,0 +1,48 @@
+#version 330 core
+
+// Half Resolution Depth and Normal for GTAO: the lower left Texel of every 2 * 2 Block, so Positions rebuilt from it stay exact
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+out vec3 FragColor;     // linear View Depth(R) octahedral View Space Normal(GB) <RGB16F, the Key of Bloom Level 0>
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;      // octahedral World Normal
+uniform ivec2 render_size;      // full internal Resolution <Dynamic Resolution>
+
+float LinearDepth(float depth);
+vec3 DecodeNormal(vec2 encoded);
+vec2 EncodeNormal(vec3 n);
+
+void main() {
+    ivec2 texel = min(ivec2(gl_FragCoord.xy) * 2, render_size - 1);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    vec3 normal = normalize(mat3(view) * DecodeNormal(texelFetch(gNormal, texel, 0).rg));
+    FragColor = vec3(LinearDepth(depth), EncodeNormal(normal));
+}
+
+float LinearDepth(float depth) {
+    return projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+}
+
+vec3 DecodeNormal(vec2 encoded) {
+    encoded = encoded * 2.0 - 1.0;
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec2 EncodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return (n.z >= 0.0 ? n.xy : folded) * 0.5 + 0.5;
+}
@@ -0,0 +1,57 @@
+#version 330 core
+
+// Accumulates the rotating GTAO Pattern over Frames: every half Resolution Texel is reprojected into last Frame's
+// History and blended with it, unless the Depth found there belongs to another Surface <Disocclusion>
+
+const float GTAO_MAX_FRAMES = 16.0;
+const float GTAO_DEPTH_TOLERANCE = 0.05;    // relative
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+out vec4 FragColor;     // Visibility(R) linear View Depth(G) accumulated Frames(B)
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+uniform sampler2D depth_normal;     // GTAODownsample.frag
+uniform sampler2D raw_ao;           // GTAO.frag
+uniform sampler2D history;          // last Frame's Output
+uniform bool history_valid;
+uniform ivec2 render_size;
+uniform ivec2 previous_render_size;
+uniform mat4 previous_view_projection;
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float linear_depth = texelFetch(depth_normal, texel, 0).r;
+    float visibility = texelFetch(raw_ao, texel, 0).r;
+
+    // View Position of the Texel <HalfPosition in GTAO.frag> back to World Space
+    vec2 uv = (vec2(min(texel * 2, render_size - 1)) + 0.5) / vec2(render_size);
+    vec2 ndc = uv * 2.0 - 1.0;
+    vec3 position = vec3(linear_depth * (ndc + vec2(projection[2][0], projection[2][1])) / vec2(projection[0][0], projection[1][1]), -linear_depth);
+    vec3 world = transpose(mat3(view)) * (position - vec3(view[3]));
+
+    vec4 clip = previous_view_projection * vec4(world, 1.0);
+    vec2 previous_uv = clip.xy / clip.w * 0.5 + 0.5;
+
+    float frames = 0.0;
+    float previous = visibility;
+    if (history_valid && clip.w > 0.0 && all(greaterThanEqual(previous_uv, vec2(0.0))) && all(lessThan(previous_uv, vec2(1.0)))) {
+        ivec2 previous_texel = ivec2(previous_uv * vec2(previous_render_size) * 0.5);
+        vec4 last = texelFetch(history, min(previous_texel, (previous_render_size + 1) / 2 - 1), 0);
+        // clip.w is the linear Depth this Point had last Frame
+        if (abs(last.g - clip.w) < GTAO_DEPTH_TOLERANCE * clip.w) {
+            frames = last.b;
+            previous = last.r;
+        }
+    }
+
+    frames = min(frames + 1.0, GTAO_MAX_FRAMES);
+    FragColor = vec4(mix(previous, visibility, 1.0 / frames), linear_depth, frames, 1.0);
+}
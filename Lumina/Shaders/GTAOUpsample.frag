@@ -0,0 +1,76 @@
+#version 330 core
+
+// Depth aware bilateral Upsample of the accumulated GTAO: the 4 nearest half Resolution Texels are weighted bilinearly
+// and by how well their Depth and Normal match the full Resolution Pixel, so Occlusion doesn't bleed across Edges
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+out float FragColor;    // Visibility <same Meaning as SSAO.frag>
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;          // octahedral World Normal
+uniform sampler2D depth_normal;     // GTAODownsample.frag
+uniform sampler2D history;          // GTAOTemporal.frag
+uniform ivec2 render_size;
+
+float LinearDepth(float depth);
+vec3 DecodeNormal(vec2 encoded);
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float linear_depth = LinearDepth(texelFetch(gDepth, texel, 0).r);
+    vec3 normal = normalize(mat3(view) * DecodeNormal(texelFetch(gNormal, texel, 0).rg));
+
+    // half Texel p sits on full Texel 2p
+    ivec2 half_size = (render_size + 1) / 2;
+    vec2 coords = (gl_FragCoord.xy - 0.5) * 0.5;
+    ivec2 base = ivec2(floor(coords));
+    vec2 f = coords - vec2(base);
+
+    float result = 0.0;
+    float weights = 0.0;
+    float nearest = 1.0;
+    float nearest_difference = 1e20;
+    for (int i = 0; i < 4; ++i) {
+        ivec2 corner = ivec2(i & 1, i >> 1);
+        ivec2 tap = clamp(base + corner, ivec2(0), half_size - 1);
+        vec4 sample_depth_normal = texelFetch(depth_normal, tap, 0);
+        float visibility = texelFetch(history, tap, 0).r;
+
+        vec2 bilinear = mix(1.0 - f, f, vec2(corner));
+        float difference = abs(sample_depth_normal.r - linear_depth) / linear_depth;
+        float weight = bilinear.x * bilinear.y;
+        weight *= 1.0 / (1.0 + difference * 100.0);
+        weight *= pow(max(dot(DecodeNormal(sample_depth_normal.gb), normal), 0.0), 8.0);
+
+        result += visibility * weight;
+        weights += weight;
+        if (difference < nearest_difference) {
+            nearest_difference = difference;
+            nearest = visibility;
+        }
+    }
+
+    // every Tap lies on another Surface: the closest Depth wins
+    FragColor = weights > 1e-4 ? result / weights : nearest;
+}
+
+float LinearDepth(float depth) {
+    return projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+}
+
+vec3 DecodeNormal(vec2 encoded) {
+    encoded = encoded * 2.0 - 1.0;
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
@@ -1,11 +1,9 @@
 #version 330 core
 
-layout (location = 0) out vec4 gPosition_World;
-layout (location = 1) out vec4 gPosition_View;
-// gPosition = (x, y, z, linearized_depth)
-layout (location = 2) out vec4 gNormal_World;
-layout (location = 3) out vec4 gNormal_View;
-layout (location = 4) out vec4 gAlbedoSpec;
+// Positions come back from the Depth Buffer, the World Normal is octahedral in [0, 1]
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+layout (location = 2) out vec2 gMaterial;   // Roughness, Metallic <only kept with the Material Layer>
 
 in VS_OUT {
     vec3 fragpos_world;
@@ -23,20 +21,18 @@ struct Material {
 };
 
 uniform Material material;
-uniform float z_near;
-uniform float z_far;
 
-float linearize_depth(float depth) {
-    depth = depth * 2.0 - 1.0;
-    return (2.0 * z_far * z_near) / (z_far + z_near - depth * (z_far - z_near));
+vec2 EncodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return (n.z >= 0.0 ? n.xy : folded) * 0.5 + 0.5;
 }
 
 void main() {
-    gPosition_World = vec4(fs_in.fragpos_world, linearize_depth(gl_FragCoord.z));
-    gPosition_View = vec4(fs_in.fragpos_view, linearize_depth(gl_FragCoord.z));
-    gNormal_World = vec4(normalize(fs_in.normal), 1.0);
-    gNormal_View = vec4(normalize(fs_in.normal_view), 1.0);
+    gNormal = EncodeNormal(normalize(fs_in.normal));
     gAlbedoSpec.rgb = texture(material.texture_diffuse1, fs_in.texCoords).rgb;
     // gAlbedoSpec.a = texture(material.texture_specular1, fs_in.texCoords).r;
     gAlbedoSpec.a = 1.0;
+    // Roughness of the fixed Blinn-Phong Exponent 32 <DEFAULT_ROUGHNESS in LightingPass.frag>, not metallic
+    gMaterial = vec2(0.4926, 0.0);
 }
\ No newline at end of file
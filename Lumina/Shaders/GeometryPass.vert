@@ -21,6 +21,9 @@ out VS_OUT {
     vec2 texCoords;
 } vs_out;
 
+// the Depth Pre-Pass must produce the same Depth <GL_EQUAL>
+invariant gl_Position;
+
 void main() {
     vec4 temp = model * vec4(aPosition, 1.0);
     vs_out.fragpos_world = vec3(temp);
@@ -0,0 +1,57 @@
+#version 460 core
+
+// Positions come back from the Depth Buffer, the World Normal is octahedral in [0, 1]
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+layout (location = 2) out vec2 gMaterial;   // Roughness, Metallic <only kept with the Material Layer>
+
+in VS_OUT {
+    vec3 fragpos_world;
+    vec3 fragpos_view;
+    vec3 normal;
+    vec3 normal_view;
+    vec2 texCoords;
+    flat uint material;
+} fs_in;
+
+const int MATERIAL_ARRAYS_LIMITATION = 8;
+
+// (array, layer) pairs are -1 when the Mesh has no such Texture
+struct MaterialData {
+    ivec2 diffuse;
+    ivec2 specular;
+    ivec2 normal;
+    float metallic;
+    float roughness;
+    float ao;
+};
+
+layout (std430, binding = 2) readonly buffer Materials {
+    MaterialData materials[];
+};
+
+// GL_TEXTURE17 ~ 24
+// the Index is constant within a Draw
+uniform sampler2DArray material_arrays[MATERIAL_ARRAYS_LIMITATION];
+
+vec2 EncodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return (n.z >= 0.0 ? n.xy : folded) * 0.5 + 0.5;
+}
+
+vec4 sampleMaterial(ivec2 slot, vec4 fallback) {
+    if (slot.x < 0)
+        return fallback;
+    return texture(material_arrays[slot.x], vec3(fs_in.texCoords, float(slot.y)));
+}
+
+void main() {
+    MaterialData material = materials[fs_in.material];
+
+    gNormal = EncodeNormal(normalize(fs_in.normal));
+    gAlbedoSpec.rgb = sampleMaterial(material.diffuse, vec4(1.0)).rgb;
+    // gAlbedoSpec.a = sampleMaterial(material.specular, vec4(1.0)).r;
+    gAlbedoSpec.a = 1.0;
+    gMaterial = vec2(material.roughness, material.metallic);
+}
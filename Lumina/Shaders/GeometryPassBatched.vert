@@ -0,0 +1,51 @@
+#version 460 core
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+layout(location = 3) in vec3 aTangent;
+layout(location = 4) in vec3 aBiTangent;
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+// One Entry per glMultiDrawElementsIndirect Command <MaterialSystem.hpp>
+struct DrawData {
+    mat4 model;
+    uint material;
+};
+
+layout (std430, binding = 1) readonly buffer Draws {
+    DrawData draws[];
+};
+
+out VS_OUT {
+    vec3 fragpos_world;
+    vec3 fragpos_view;
+    vec3 normal;
+    vec3 normal_view;
+    vec2 texCoords;
+    flat uint material;
+} vs_out;
+
+// the Depth Pre-Pass must produce the same Depth <GL_EQUAL>
+invariant gl_Position;
+
+void main() {
+    mat4 model = draws[gl_DrawID].model;
+
+    vec4 temp = model * vec4(aPosition, 1.0);
+    vs_out.fragpos_world = vec3(temp);
+    temp = view * temp;
+    vs_out.fragpos_view = vec3(temp);
+
+    vs_out.normal = mat3(transpose(inverse(model))) * aNormal;
+    vs_out.normal_view = mat3(transpose(inverse(view * model))) * aNormal;
+
+    vs_out.texCoords = aTexCoords;
+    vs_out.material = draws[gl_DrawID].material;
+
+    gl_Position = projection * temp;
+}
@@ -14,6 +14,11 @@ uniform int KernelIndex;
 
 uniform float exposure;
 
+// Mip Chain Bloom <BloomTools.hpp> added before Exposure
+uniform sampler2D bloomblur;
+uniform bool Bloom;
+uniform float bloom_strength;
+
 vec4 inversion(vec4 color) {
     vec3 temp = color.rgb;
     return vec4(1.0 - temp, 1.0);
@@ -100,6 +105,9 @@ void main() {
     for(int i = 0; i < 9; ++i)
         color += kernel[i] * vec3(texture(ScreenTexture, fs_in.texCoords + offsets[i]));
 
+    if(Bloom)
+        color += bloom_strength * texture(bloomblur, fs_in.texCoords).rgb;
+
     vec4 result = vec4(ExposureFactor(color, exposure), 1.0);
 
     if(Inversion)
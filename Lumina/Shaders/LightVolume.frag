@@ -0,0 +1,116 @@
+#version 430 core
+
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 BrightColor;
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+const int POINT_SHADOWS_LIMITATION = 8;
+const int OTHER_LIMITATION = 2;
+
+// Light Storage <std430, packed by LightManager>
+struct Light {
+    vec4 position;      // xyz position, w far plane <point> or cos(outer_cutoff) <spot>
+    vec4 direction;     // xyz direction, w shadow map slot <-1 without>
+    vec4 ambient;       // a: attenuation constant
+    vec4 diffuse;       // a: attenuation linear
+    vec4 specular;      // a: cos(cutoff)
+};
+
+layout (std430, binding = 3) readonly buffer Lights {
+    int num_dirlight;
+    int num_pointlight;
+    int num_spotlight;
+    int num_pointshadow;
+    mat4 DirLight_Transform[OTHER_LIMITATION];
+    int shadow_pointlights[POINT_SHADOWS_LIMITATION];   // PointLight index of each Cube Shadow slot
+    Light lights[];     // DirLights, then PointLights, then SpotLights
+};
+
+const float LIGHT_CLUSTER_CUTOFF = 1.0 / 256.0;
+// Blinn-Phong Exponent without the Material Layer <as in LightingPass.frag>
+const float shininess = 32.0;
+const float DEFAULT_ROUGHNESS = sqrt(sqrt(2.0 / (shininess + 2.0)));
+
+struct GBufferTex {
+    sampler2D gDepth;           // layer 1
+    sampler2D gNormal;          // layer 2 <octahedral World Normal>
+    sampler2D gAlbedoSpec;      // layer 3
+    sampler2D gMaterial;        // layer 4 <Roughness, Metallic>
+    bool material_layer;        // gMaterial is only sampled with the Layer
+};
+
+struct SSAO_Compoent {
+    bool apply_SSAO;
+    sampler2D SSAOTexture;      // layer 6
+};
+
+uniform GBufferTex gbuffertex;
+uniform SSAO_Compoent ssao_compoent;
+// Dynamic Resolution: the G-Buffer is drawn into this Fraction of its Textures
+uniform vec2 viewport_scale = vec2(1.0);
+
+flat in int light_index;
+
+vec3 ViewPosition(vec2 uv, float depth);
+vec3 DecodeNormal(vec2 encoded);
+
+// One Light per Fragment, the Blend adds the Volumes up <same Blinn-Phong as LightingPass.frag>
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 uv = gl_FragCoord.xy / (vec2(textureSize(gbuffertex.gDepth, 0)) * viewport_scale);
+    vec3 fragpos = viewpos + transpose(mat3(view)) * ViewPosition(uv, texelFetch(gbuffertex.gDepth, texel, 0).r);
+    vec3 norm = DecodeNormal(texelFetch(gbuffertex.gNormal, texel, 0).rg);
+    vec4 albedospec = texelFetch(gbuffertex.gAlbedoSpec, texel, 0);
+    vec2 material = gbuffertex.material_layer ? texelFetch(gbuffertex.gMaterial, texel, 0).rg : vec2(DEFAULT_ROUGHNESS, 0.0);
+    float exponent = clamp(2.0 / max(pow(material.r, 4.0), 1e-4) - 2.0, 1.0, 2048.0);
+    float ambient_occlusion = ssao_compoent.apply_SSAO ? texture(ssao_compoent.SSAOTexture, gl_FragCoord.xy / textureSize(ssao_compoent.SSAOTexture, 0)).r : 1.0;
+
+    Light light = lights[light_index];
+
+    vec3 Frag2Light = light.position.xyz - fragpos;
+    vec3 lightDir = normalize(Frag2Light);
+    float attenuation = 1.0 / (light.ambient.a + light.diffuse.a * length(Frag2Light));
+    if (attenuation * max(light.diffuse.r, max(light.diffuse.g, light.diffuse.b)) < LIGHT_CLUSTER_CUTOFF)
+        discard;
+
+    float intensity = 1.0;
+    if (light_index >= num_dirlight + num_pointlight) {
+        float theta = dot(normalize(light.direction.xyz), -lightDir);
+        intensity = clamp((theta - light.position.w) / max(light.specular.a - light.position.w, 1e-4), 0.0, 1.0);
+    }
+
+    vec3 viewDir = normalize(viewpos - fragpos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    float spec = pow(max(dot(norm, normalize(lightDir + viewDir)), 0.0), exponent);
+
+    vec3 ambient = light.ambient.rgb * albedospec.rgb * ambient_occlusion;
+    vec3 diffuse = light.diffuse.rgb * diff * albedospec.rgb * (1.0 - material.g);
+    vec3 specular = light.specular.rgb * spec * mix(vec3(albedospec.a), albedospec.rgb, material.g);
+
+    FragColor = vec4(attenuation * (ambient + intensity * (diffuse + specular)), 1.0);
+
+    // Per Light Threshold, the Sum of several dim Volumes does not reach the Bloom
+    float bright = dot(FragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
+    BrightColor = bright > 1.0 ? FragColor : vec4(0.0);
+}
+
+// same Reconstruction as LightingPass.frag
+vec3 ViewPosition(vec2 uv, float depth) {
+    vec3 ndc = vec3(uv, depth) * 2.0 - 1.0;
+    float z = -projection[3][2] / (ndc.z + projection[2][2]);
+    vec2 xy = -z * (ndc.xy + vec2(projection[2][0], projection[2][1])) / vec2(projection[0][0], projection[1][1]);
+    return vec3(xy, z);
+}
+
+vec3 DecodeNormal(vec2 encoded) {
+    encoded = encoded * 2.0 - 1.0;
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
@@ -0,0 +1,79 @@
+#version 430 core
+
+layout (location = 0) in vec3 aPosition;
+
+layout (std140) uniform Matrices {
+    mat4 view;
+    mat4 projection;
+    vec3 viewpos;
+};
+
+const int POINT_SHADOWS_LIMITATION = 8;
+const int OTHER_LIMITATION = 2;
+
+// Light Storage <std430, packed by LightManager>
+struct Light {
+    vec4 position;      // xyz position, w far plane <point> or cos(outer_cutoff) <spot>
+    vec4 direction;     // xyz direction, w shadow map slot <-1 without>
+    vec4 ambient;       // a: attenuation constant
+    vec4 diffuse;       // a: attenuation linear
+    vec4 specular;      // a: cos(cutoff)
+};
+
+layout (std430, binding = 3) readonly buffer Lights {
+    int num_dirlight;
+    int num_pointlight;
+    int num_spotlight;
+    int num_pointshadow;
+    mat4 DirLight_Transform[OTHER_LIMITATION];
+    int shadow_pointlights[POINT_SHADOWS_LIMITATION];   // PointLight index of each Cube Shadow slot
+    Light lights[];     // DirLights, then PointLights, then SpotLights
+};
+
+const float LIGHT_CLUSTER_CUTOFF = 1.0 / 256.0;
+// Spot Lights wider than 80 degrees use the Sphere, a Cone that wide is mostly Base
+const float WIDE_SPOT = 0.173648;
+
+uniform int first_light;
+uniform int volume_type;    // 0 Sphere, 1 Cone
+uniform float max_range;
+
+flat out int light_index;
+
+void main() {
+    int index = first_light + gl_InstanceID;
+    Light light = lights[index];
+
+    bool spot = index >= num_dirlight + num_pointlight;
+    bool wide = spot && light.position.w < WIDE_SPOT;
+
+    // Shadowed Lights stay in the full-screen Pass, each other Spot Light goes through exactly one Volume
+    bool skip = light.direction.w >= 0.0 || (volume_type == 0 ? spot && !wide : wide);
+    if (skip) {
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        light_index = -1;
+        return;
+    }
+
+    // Same Range as LightClusters::Range
+    float brightest = max(light.diffuse.r, max(light.diffuse.g, light.diffuse.b));
+    float range = light.diffuse.a > 0.0 ? max((brightest / LIGHT_CLUSTER_CUTOFF - light.ambient.a) / light.diffuse.a, 0.0) : max_range;
+    range = min(range, max_range);
+
+    vec3 world;
+    if (volume_type == 0) {
+        world = light.position.xyz + aPosition * range;
+    }
+    else {
+        vec3 axis = normalize(light.direction.xyz);
+        vec3 up = abs(axis.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+        vec3 tangent = normalize(cross(up, axis));
+        vec3 bitangent = cross(axis, tangent);
+        float cos_outer = light.position.w;
+        float radius = range * sqrt(1.0 - cos_outer * cos_outer) / cos_outer;
+        world = light.position.xyz + (tangent * aPosition.x + bitangent * aPosition.y) * radius + axis * aPosition.z * range;
+    }
+
+    gl_Position = projection * view * vec4(world, 1.0);
+    light_index = index;
+}
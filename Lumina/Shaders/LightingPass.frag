@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 
 layout (location = 0) out vec4 FragColor;
 layout (location = 1) out vec4 BrightColor;
@@ -13,18 +13,11 @@ layout (std140) uniform Matrices {
     vec3 viewpos;
 };
 
-const int POINT_LIGHTS_LIMITATION = 8;
+const int POINT_SHADOWS_LIMITATION = 8;
 const int OTHER_LIMITATION = 2;
-
-struct LightInfo {
-    // Amounts
-    int num_dirlight;
-    int num_pointlight;
-    int num_spotlight;
-
-    // Transform Matrices
-    mat4 DirLight_Transform[OTHER_LIMITATION];
-};
+const int CASCADE_LIMITATION = 4;
+const int POINT_SHADOW_TIERS = 3;
+const int SPOT_SHADOWS_LIMITATION = 4;
 
 struct LightAttrib {
     vec3 ambient;
@@ -39,15 +32,18 @@ struct Attenuation {
 
 struct Dirlight {
     vec3 direction;
-    sampler2D shadowmap;
+    int shadow;
+    vec4 atlas;     // Shadow Atlas Region <offset, scale>
 
     LightAttrib attrib;
 };
 
 struct PointLight {
     vec3 position;
-    samplerCube shadowmap;
+    int shadow;
     float far;
+    int tier;       // Cube Map Array of the Shadow
+    int layer;      // Cube in that Array
 
     LightAttrib attrib;
     Attenuation attenuation;
@@ -56,6 +52,7 @@ struct PointLight {
 struct SpotLight {
     vec3 position;
     vec3 direction;
+    int shadow;     // Slot in the spotshadow Uniforms, -1 without
 
     LightAttrib attrib;
     Attenuation attenuation;
@@ -64,22 +61,152 @@ struct SpotLight {
     float outer_cutoff;
 };
 
-uniform Dirlight dirlights[OTHER_LIMITATION];
-uniform PointLight pointlights[POINT_LIGHTS_LIMITATION];
-uniform SpotLight spotlights[OTHER_LIMITATION];
+uniform sampler2D dirlight_shadowmaps[OTHER_LIMITATION];
+// Point Light Shadows <one Cube Map Array per Resolution Tier, set by PointShadows::ShaderConfig>
+uniform samplerCubeArray pointshadow_arrays[POINT_SHADOW_TIERS];
+// Spot Light Shadows <Regions of one Atlas, set by LightManager::ShaderConfig>
+uniform sampler2D spotlight_shadowmap;
+uniform int spotshadow_count;
+uniform int spotshadow_lights[SPOT_SHADOWS_LIMITATION];     // SpotLight index of each Slot
+uniform mat4 spotshadow_transforms[SPOT_SHADOWS_LIMITATION];
+uniform vec4 spotshadow_atlas[SPOT_SHADOWS_LIMITATION];     // Region <offset, scale>
+
+// Cascaded Shadow Maps <set by CascadedShadowMap::ShaderConfig>
+uniform sampler2DArray cascade_shadowmap;
+uniform int cascade_dirlight;       // DirLight index shadowed by the Cascades
+uniform int cascade_count;          // 0 without Cascades
+uniform mat4 cascade_transforms[CASCADE_LIMITATION];
+uniform float cascade_splits[CASCADE_LIMITATION];   // far View Depth of each Cascade
+uniform float cascade_texels[CASCADE_LIMITATION];   // World Size of one Texel
+uniform float cascade_blend;        // Fraction of each Cascade faded into the next
+
+// Exponential Variance Shadow Maps of the Cascades <set by EVSMShadows::ShaderConfig>
+struct EVSM {
+    bool enabled;
+    vec2 exponents;             // positive, negative
+    float bleeding_reduction;
+    float min_variance;
+};
+uniform EVSM evsm;
+uniform sampler2DArray evsm_moments;
+
+// Light Storage <std430, packed by LightManager>
+struct Light {
+    vec4 position;      // xyz position, w far plane <point> or cos(outer_cutoff) <spot> | Shadow Atlas Region <dir>
+    vec4 direction;     // xyz direction, w shadow map slot <-1 without>
+    vec4 ambient;       // a: attenuation constant
+    vec4 diffuse;       // a: attenuation linear
+    vec4 specular;      // a: cos(cutoff)
+};
+
+layout (std430, binding = 3) readonly buffer Lights {
+    int num_dirlight;
+    int num_pointlight;
+    int num_spotlight;
+    int num_pointshadow;
+    mat4 DirLight_Transform[OTHER_LIMITATION];
+    int shadow_pointlights[POINT_SHADOWS_LIMITATION];   // PointLight index of each Cube Shadow slot
+    Light lights[];     // DirLights, then PointLights, then SpotLights
+};
+
+// Clustered Culling <built by LightClusters, Indices point into lights[]>
+layout (std430, binding = 4) readonly buffer LightGrid {
+    uvec4 cluster_dims;
+    vec4 cluster_params;    // log-Depth Scale and Bias, Tile Size in Pixels
+    uvec2 clusters[];       // Offset and Count into light_indices
+};
+
+layout (std430, binding = 5) readonly buffer LightIndices {
+    uint light_indices[];
+};
+
+const float LIGHT_CLUSTER_CUTOFF = 1.0 / 256.0;
+
+// Area Lights <packed by LightManager, every Pixel evaluates each of them once>
+const int AREA_RECT = 0;
+const int AREA_DISK = 1;
+
+struct AreaLight {
+    vec4 position;      // w: shape
+    vec4 right;         // xyz half extent, w: two sided
+    vec4 up;            // xyz half extent, the Light shines along cross(right, up)
+    vec4 ambient;
+    vec4 diffuse;       // Radiance
+    vec4 specular;
+};
+
+layout (std430, binding = 6) readonly buffer AreaLights {
+    int num_arealight;
+    AreaLight area_lights[];
+};
+
+// Linearly Transformed Cosine Tables <set by LTCTables::ShaderConfig, uv = (roughness, sqrt(1 - cos(theta)))>
+uniform sampler2D ltc_matrix;
+uniform sampler2D ltc_amplitude;
+
+// Unshadowed Point and Spot Lights drawn as Light Volumes afterwards instead of through the Clusters
+uniform bool light_volumes;
+
+uint ClusterIndex(vec2 fragcoord, float depth);
+
+Dirlight GetDirLight(int i);
+PointLight GetPointLight(int i);
+SpotLight GetSpotLight(int i);
+
+// Blinn-Phong Exponent without the Material Layer, and the GGX Roughness matching it
+// <alpha = sqrt(2 / (n + 2)), the LTC Tables are indexed by sqrt(alpha)>
+const float shininess = 32.0;
+const float DEFAULT_ROUGHNESS = sqrt(sqrt(2.0 / (shininess + 2.0)));
+
+struct Surface {
+    vec3 fragpos;
+    vec3 norm;
+    vec3 viewDir;
+    vec3 albedo;
+    float specular;
+    float roughness;
+    float metallic;
+    float shininess;    // Blinn-Phong Exponent of the Roughness
+    float ambient_occlusion;
+    float depth;        // View Space Depth
+    vec3 dpdx;          // Screen Derivatives of fragpos <Mip Selection inside non-uniform Branches>
+    vec3 dpdy;
+};
+
+vec3 BlinnPhong(LightAttrib attrib, vec3 lightDir, Surface surface, float visibility);
+vec3 CalculateDirLight(Dirlight light, int index, Surface surface);
+vec3 CalculatePointLight(PointLight light, Surface surface);
+vec3 CalculateSpotLight(SpotLight light, Surface surface);
 
 bool IsBright(vec3 lightdir, vec3 norm);
 float DepthAdjustment(vec3 lightdir, vec3 norm);
 float ShadowFactor(Dirlight light, vec4 light_frag_pos, vec3 norm);
+vec2 AtlasClamp(Dirlight light, vec2 coords);
 float ShadowFactor(PointLight light, vec3 fragpos, vec3 norm);
+float ShadowFactor(SpotLight light, vec3 fragpos, vec3 norm);
+float CascadeShadow(Dirlight light, Surface surface);
+float CascadeFactor(Dirlight light, int cascade, Surface surface);
+float EVSMFactor(int cascade, vec3 projCoords, Surface surface);
 float Brightness(PointLight light, vec3 frag2light);
 
+vec3 CalculateAreaLight(AreaLight light, Surface surface);
+float LTCEvaluate(AreaLight light, Surface surface, mat3 Minv);
+float LTCRect(vec3 center, vec3 right, vec3 up, mat3 Minv);
+float LTCDisk(vec3 center, vec3 right, vec3 up, mat3 Minv);
+vec3 IntegrateEdge(vec3 v1, vec3 v2);
+float ClippedSphere(vec3 form_factor);
+vec3 SolveCubic(vec4 coefficients);
+vec2 LTCCoords(vec2 uv);
+
+vec3 ViewPosition(vec2 uv, float depth);
+vec3 DecodeNormal(vec2 encoded);
+
 struct GBufferTex {
-    sampler2D gPosition_World;  // layer 1
-    sampler2D gPosition_View;   // layer 2
-    sampler2D gNormal_World;    // layer 3
-    sampler2D gNormal_View;     // layer 4
-    sampler2D gAlbedoSpec;      // layer 5
+    sampler2D gDepth;           // layer 1
+    sampler2D gNormal;          // layer 2 <octahedral World Normal>
+    sampler2D gAlbedoSpec;      // layer 3
+    sampler2D gMaterial;        // layer 4 <Roughness, Metallic>
+    bool material_layer;        // gMaterial is only sampled with the Layer
 };
 
 struct SSAO_Compoent {
@@ -89,34 +216,50 @@ struct SSAO_Compoent {
 
 uniform GBufferTex gbuffertex;
 uniform SSAO_Compoent ssao_compoent;
+uniform vec2 viewport_scale = vec2(1.0);    // texCoords arrive scaled <LightingPass.vert>
 
 void main() {
-    vec3 fragpos = texture(gbuffertex.gPosition_World, fs_in.texCoords).rgb;
-    vec3 normal = texture(gbuffertex.gNormal_World, fs_in.texCoords).rgb;
-    vec3 albedo = texture(gbuffertex.gAlbedoSpec, fs_in.texCoords).rgb;
-    float specular = texture(gbuffertex.gAlbedoSpec, fs_in.texCoords).a;
-
-    vec3 viewDir = normalize(viewpos - fragpos);
-    vec3 norm = normalize(normal);
+    Surface surface;
+    vec3 fragpos_view = ViewPosition(fs_in.texCoords / viewport_scale, texture(gbuffertex.gDepth, fs_in.texCoords).r);
+    surface.fragpos = viewpos + transpose(mat3(view)) * fragpos_view;
+    surface.norm = DecodeNormal(texture(gbuffertex.gNormal, fs_in.texCoords).rg);
+    surface.viewDir = normalize(viewpos - surface.fragpos);
+    vec4 albedospec = texture(gbuffertex.gAlbedoSpec, fs_in.texCoords);
+    surface.albedo = albedospec.rgb;
+    surface.specular = albedospec.a;
+    vec2 material = gbuffertex.material_layer ? texture(gbuffertex.gMaterial, fs_in.texCoords).rg : vec2(DEFAULT_ROUGHNESS, 0.0);
+    surface.roughness = material.r;
+    surface.metallic = material.g;
+    surface.shininess = clamp(2.0 / max(pow(material.r, 4.0), 1e-4) - 2.0, 1.0, 2048.0);
+    surface.ambient_occlusion = ssao_compoent.apply_SSAO ? texture(ssao_compoent.SSAOTexture, fs_in.texCoords).r : 1.0;
+    surface.depth = -fragpos_view.z;
+    surface.dpdx = dFdx(surface.fragpos);
+    surface.dpdy = dFdy(surface.fragpos);
 
     vec3 result = vec3(0.0, 0.0, 0.0);
 
-    // for (int i = 0; i < lightinfo.num_dirlight; ++i)
-    // {
-    //     dirlight_fragPos[i] = lightinfo.DirLight_Transform[i] * vec4(fragpos, 1.0);
-    // }
-    vec4 dirlight_fragPos = lightinfo.DirLight_Transform * vec4(fragpos, 1.0);
+    // DirLights and shadowed PointLights reach everywhere <uniform Loops keep the Shadow Sampler Indices uniform>
+    for (int i = 0; i < num_dirlight; ++i)
+        result += CalculateDirLight(GetDirLight(i), i, surface);
+
+    for (int i = 0; i < num_pointshadow; ++i)
+        result += CalculatePointLight(GetPointLight(shadow_pointlights[i]), surface);
 
-    float imp = IsBright(-dirlights[0].direction, norm) ? ShadowFactor(dirlights[0], dirlight_fragPos, norm) : 0.0;
-    // float imp = IsBright(-dirlights[0].direction, norm) ? ShadowFactor(dirlights[0], dirlight_fragPos[0], norm) : 0.0;
-    // float imp_diff = IsBright(pointlights[0].position - fragpos, norm) ? ShadowFactor(pointlights[0], fragpos, norm) : 0.0;
-    // float ambient_occlusion = texture(ssao_compoent.SSAOTexture, fs_in.texCoords).r;
-    // float imp_ambi = 1.0 * (ssao_compoent.apply_SSAO ? ambient_occlusion : 1.0);
-    // float imp = imp_diff * Brightness(pointlights[0], (fragpos - pointlights[0].position)) * 0 + imp_ambi;
-    // float imp = imp_diff * Brightness(pointlights[0], (fragpos - pointlights[0].position)) * 0.75 + imp_ambi * 0.25;
-    // float imp = imp_diff;
+    for (int i = 0; i < spotshadow_count; ++i)
+        result += CalculateSpotLight(GetSpotLight(spotshadow_lights[i]), surface);
 
-    result += imp * albedo;
+    for (int i = 0; i < num_arealight; ++i)
+        result += CalculateAreaLight(area_lights[i], surface);
+
+    // the Rest only through this Fragment's Cluster
+    uvec2 cluster = light_volumes ? uvec2(0u) : clusters[ClusterIndex(gl_FragCoord.xy, surface.depth)];
+    for (uint i = 0u; i < cluster.y; ++i) {
+        int index = int(light_indices[cluster.x + i]);
+        if (index < num_dirlight + num_pointlight)
+            result += CalculatePointLight(GetPointLight(index - num_dirlight), surface);
+        else
+            result += CalculateSpotLight(GetSpotLight(index - num_dirlight - num_pointlight), surface);
+    }
 
     FragColor = vec4(result, 1.0);
 
@@ -127,6 +270,60 @@ void main() {
         BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
 }
 
+vec3 BlinnPhong(LightAttrib attrib, vec3 lightDir, Surface surface, float visibility) {
+    float diff = max(dot(surface.norm, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + surface.viewDir);
+    float spec = pow(max(dot(surface.norm, halfwayDir), 0.0), surface.shininess);
+
+    // Metals lose their Diffuse and tint the Highlight with the Albedo
+    vec3 ambient = attrib.ambient * surface.albedo * surface.ambient_occlusion;
+    vec3 diffuse = attrib.diffuse * diff * surface.albedo * (1.0 - surface.metallic);
+    vec3 specular = attrib.specular * spec * mix(vec3(surface.specular), surface.albedo, surface.metallic);
+
+    return ambient + visibility * (diffuse + specular);
+}
+
+vec3 CalculateDirLight(Dirlight light, int index, Surface surface) {
+    vec3 lightDir = normalize(-light.direction);
+
+    float visibility = 1.0;
+    if (cascade_count > 0 && index == cascade_dirlight)
+        visibility = IsBright(lightDir, surface.norm) ? CascadeShadow(light, surface) : 0.0;
+    else if (light.shadow >= 0)
+        visibility = IsBright(lightDir, surface.norm) ? ShadowFactor(light, DirLight_Transform[index] * vec4(surface.fragpos, 1.0), surface.norm) : 0.0;
+
+    return BlinnPhong(light.attrib, lightDir, surface, visibility);
+}
+
+vec3 CalculatePointLight(PointLight light, Surface surface) {
+    vec3 lightDir = normalize(light.position - surface.fragpos);
+    float distance = length(light.position - surface.fragpos);
+    float attenuation = 1.0 / (light.attenuation.constant + light.attenuation.linear * distance);
+    if (attenuation * max(light.attrib.diffuse.r, max(light.attrib.diffuse.g, light.attrib.diffuse.b)) < LIGHT_CLUSTER_CUTOFF)
+        return vec3(0.0);
+
+    float visibility = 1.0;
+    if (light.shadow >= 0)
+        visibility = IsBright(lightDir, surface.norm) ? ShadowFactor(light, surface.fragpos, surface.norm) : 0.0;
+
+    return attenuation * BlinnPhong(light.attrib, lightDir, surface, visibility);
+}
+
+vec3 CalculateSpotLight(SpotLight light, Surface surface) {
+    vec3 lightDir = normalize(light.position - surface.fragpos);
+    float distance = length(light.position - surface.fragpos);
+    float attenuation = 1.0 / (light.attenuation.constant + light.attenuation.linear * distance);
+    if (attenuation * max(light.attrib.diffuse.r, max(light.attrib.diffuse.g, light.attrib.diffuse.b)) < LIGHT_CLUSTER_CUTOFF)
+        return vec3(0.0);
+
+    float theta = dot(normalize(light.direction), -lightDir);
+    float intensity = clamp((theta - light.outer_cutoff) / max(light.cutoff - light.outer_cutoff, 1e-4), 0.0, 1.0);
+    if (light.shadow >= 0 && intensity > 0.0)
+        intensity *= IsBright(lightDir, surface.norm) ? ShadowFactor(light, surface.fragpos, surface.norm) : 0.0;
+
+    return attenuation * BlinnPhong(light.attrib, lightDir, surface, intensity);
+}
+
 bool IsBright(vec3 lightdir, vec3 norm) {
     vec3 dir = normalize(lightdir);
     return dot(norm, dir) > 0;
@@ -141,6 +338,9 @@ float ShadowFactor(Dirlight light, vec4 light_frag_pos, vec3 norm) {
     vec3 projCoords = light_frag_pos.xyz / light_frag_pos.w;
     // Depth start from 0 to 1
     projCoords = projCoords * 0.5 + 0.5;
+    // Outside the Light's Region counts as lit <the Atlas has no Border of its own>
+    if (projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
+        return 1.0;
 
     // Refinements
     float adjust = DepthAdjustment(-light.direction, norm);
@@ -149,10 +349,11 @@ float ShadowFactor(Dirlight light, vec4 light_frag_pos, vec3 norm) {
     float shadow = 0.0;
 
     // 25 * Multi Sampling
-    vec2 pixeloffset = 0.3 / textureSize(light.shadowmap, 0);
+    vec2 pixeloffset = 0.3 / textureSize(dirlight_shadowmaps[light.shadow], 0);
+    vec2 center = light.atlas.xy + projCoords.xy * light.atlas.zw;
     for (int x = -2; x <= 2; ++x) {
         for (int y = -2; y <= 2; ++y) {
-            float subdepth = texture(light.shadowmap, projCoords.xy + pixeloffset * vec2(x, y)).r;
+            float subdepth = texture(dirlight_shadowmaps[light.shadow], AtlasClamp(light, center + pixeloffset * vec2(x, y))).r;
             shadow += CurrentDepth > subdepth + adjust ? 1.0 : 0.0;
         }
     }
@@ -165,14 +366,87 @@ float ShadowFactor(Dirlight light, vec4 light_frag_pos, vec3 norm) {
     return 1.0 - shadow;
 }
 
+// Picks the Cascade by View Depth and fades into the next one near its far End
+float CascadeShadow(Dirlight light, Surface surface) {
+    int cascade = 0;
+    while (cascade < cascade_count - 1 && surface.depth > cascade_splits[cascade])
+        ++cascade;
+    if (surface.depth > cascade_splits[cascade])
+        return 1.0;
+
+    float shadow = CascadeFactor(light, cascade, surface);
+
+    if (cascade_blend > 0.0 && cascade < cascade_count - 1) {
+        float start = cascade == 0 ? 0.0 : cascade_splits[cascade - 1];
+        float fade = (cascade_splits[cascade] - surface.depth) / ((cascade_splits[cascade] - start) * cascade_blend);
+        if (fade < 1.0)
+            shadow = mix(CascadeFactor(light, cascade + 1, surface), shadow, fade);
+    }
+
+    return shadow;
+}
+
+float CascadeFactor(Dirlight light, int cascade, Surface surface) {
+    // Normal Offset by the Cascade's Texel Size keeps the Bias the same in every Cascade
+    vec3 offset_pos = surface.fragpos + surface.norm * cascade_texels[cascade] * 1.5;
+    vec4 light_frag_pos = cascade_transforms[cascade] * vec4(offset_pos, 1.0);
+    vec3 projCoords = light_frag_pos.xyz / light_frag_pos.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 1.0;
+    if (evsm.enabled)
+        return EVSMFactor(cascade, projCoords, surface);
+
+    // Depth Range of every Cascade spans all its Casters, so only a small constant Bias is left
+    float adjust = 0.0005;
+
+    // 9 * Multi Sampling
+    vec2 texel = 1.0 / vec2(textureSize(cascade_shadowmap, 0).xy);
+    float shadow = 0.0;
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            float subdepth = texture(cascade_shadowmap, vec3(projCoords.xy + texel * vec2(x, y), cascade)).r;
+            shadow += projCoords.z > subdepth + adjust ? 1.0 : 0.0;
+        }
+    }
+
+    return 1.0 - shadow / 9.0;
+}
+
+// One trilinear Fetch of the prefiltered Moments, Chebyshev's Bound for both Warps
+float EVSMFactor(int cascade, vec3 projCoords, Surface surface) {
+    // the Cascades are orthographic: Texture Gradients are the projected Position Gradients
+    vec2 gradx = 0.5 * (mat3(cascade_transforms[cascade]) * surface.dpdx).xy;
+    vec2 grady = 0.5 * (mat3(cascade_transforms[cascade]) * surface.dpdy).xy;
+    vec4 moments = textureGrad(evsm_moments, vec3(projCoords.xy, cascade), gradx, grady);
+
+    float depth = 2.0 * projCoords.z - 1.0;
+    vec2 warped = vec2(exp(evsm.exponents.x * depth), -exp(-evsm.exponents.y * depth));
+    // the Derivative of each Warp scales the minimum Variance into its Range
+    vec2 depth_scale = evsm.min_variance * evsm.exponents * warped;
+    vec2 min_variance = depth_scale * depth_scale;
+
+    float visibility = 1.0;
+    for (int i = 0; i < 2; ++i) {
+        vec2 moment = i == 0 ? moments.xy : moments.zw;
+        float variance = max(moment.y - moment.x * moment.x, min_variance[i]);
+        float d = warped[i] - moment.x;
+        float p_max = d <= 0.0 ? 1.0 : variance / (variance + d * d);
+        // Light Bleeding Reduction: the lowest Part of the Bound counts as fully shadowed
+        p_max = clamp((p_max - evsm.bleeding_reduction) / (1.0 - evsm.bleeding_reduction), 0.0, 1.0);
+        visibility = min(visibility, p_max);
+    }
+
+    return visibility;
+}
+
 float ShadowFactor(PointLight light, vec3 fragpos, vec3 norm) {
-    vec3 Light2Frag = light.position - fragpos;
+    vec3 Light2Frag = fragpos - light.position;
 
     vec3 FragDir = normalize(Light2Frag);
 
     float CurrentDepth = length(Light2Frag);
 
-    float adjust = DepthAdjustment(Light2Frag, norm);
+    float adjust = DepthAdjustment(-Light2Frag, norm);
 
     const int samples = 20;
 
@@ -190,7 +464,7 @@ float ShadowFactor(PointLight light, vec3 fragpos, vec3 norm) {
     float shadow = 0.0;
 
     for (int i = 0; i < samples; ++i) {
-        float subStoppingDepth = texture(light.shadowmap, FragDir + offsets[i] * bias).r;
+        float subStoppingDepth = texture(pointshadow_arrays[light.tier], vec4(FragDir + offsets[i] * bias, light.layer)).r;
         subStoppingDepth *= light.far;
         shadow += CurrentDepth > subStoppingDepth + adjust ? 1.0 : 0.0;
     }
@@ -203,6 +477,269 @@ float ShadowFactor(PointLight light, vec3 fragpos, vec3 norm) {
     return 1.0 - shadow;
 }
 
+float ShadowFactor(SpotLight light, vec3 fragpos, vec3 norm) {
+    // Normal Offset by one Texel at the Fragment's Distance <the Texels grow with it under the Perspective>
+    vec4 atlas = spotshadow_atlas[light.shadow];
+    float tan_outer = sqrt(1.0 - light.outer_cutoff * light.outer_cutoff) / light.outer_cutoff;
+    float texel = 2.0 * tan_outer * length(fragpos - light.position) / (textureSize(spotlight_shadowmap, 0).x * atlas.z);
+    vec4 light_frag_pos = spotshadow_transforms[light.shadow] * vec4(fragpos + norm * texel * 1.5, 1.0);
+    vec3 projCoords = light_frag_pos.xyz / light_frag_pos.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 1.0;
+
+    // 9 * Multi Sampling inside the Light's Region
+    vec2 size = vec2(textureSize(spotlight_shadowmap, 0));
+    vec2 center = atlas.xy + projCoords.xy * atlas.zw;
+    vec2 half_texel = 0.5 / size;
+    float shadow = 0.0;
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            vec2 coords = clamp(center + vec2(x, y) / size, atlas.xy + half_texel, atlas.xy + atlas.zw - half_texel);
+            float subdepth = texture(spotlight_shadowmap, coords).r;
+            shadow += projCoords.z > subdepth + 0.0002 ? 1.0 : 0.0;
+        }
+    }
+
+    return 1.0 - shadow / 9.0;
+}
+
+vec3 CalculateAreaLight(AreaLight light, Surface surface) {
+    float NoV = clamp(dot(surface.norm, surface.viewDir), 0.0, 1.0);
+    vec2 uv = LTCCoords(vec2(surface.roughness, sqrt(1.0 - NoV)));
+    vec4 t1 = texture(ltc_matrix, uv);
+    vec4 t2 = texture(ltc_amplitude, uv);
+
+    mat3 Minv = mat3(vec3(t1.x, 0.0, t1.y), vec3(0.0, 1.0, 0.0), vec3(t1.z, 0.0, t1.w));
+    // the Specular Map works as F0, tinted by the Albedo for Metals <Norm and Fresnel Integral of the BRDF>
+    vec3 f0 = mix(vec3(surface.specular), surface.albedo, surface.metallic);
+    vec3 spec = LTCEvaluate(light, surface, Minv) * (f0 * t2.x + (1.0 - f0) * t2.y);
+    float diff = LTCEvaluate(light, surface, mat3(1.0));
+
+    vec3 ambient = light.ambient.rgb * surface.albedo * surface.ambient_occlusion;
+    return ambient + light.diffuse.rgb * diff * surface.albedo * (1.0 - surface.metallic) + light.specular.rgb * spec;
+}
+
+// Form Factor of the Light under the Cosine Distribution Minv turns the BRDF Lobe into
+float LTCEvaluate(AreaLight light, Surface surface, mat3 Minv) {
+    vec3 normal = cross(light.right.xyz, light.up.xyz);
+    if (light.right.w == 0.0 && dot(surface.fragpos - light.position.xyz, normal) <= 0.0)
+        return 0.0;
+
+    // Tangent Frame around the Normal with the View in the xz Plane
+    vec3 N = surface.norm;
+    vec3 T1 = surface.viewDir - N * dot(surface.viewDir, N);
+    T1 = dot(T1, T1) > 1e-8 ? normalize(T1) : normalize(abs(N.z) < 0.999 ? cross(N, vec3(0.0, 0.0, 1.0)) : vec3(1.0, 0.0, 0.0));
+    vec3 T2 = cross(N, T1);
+    Minv = Minv * transpose(mat3(T1, T2, N));
+
+    vec3 center = light.position.xyz - surface.fragpos;
+    if (int(light.position.w) == AREA_DISK)
+        return LTCDisk(center, light.right.xyz, light.up.xyz, Minv);
+    return LTCRect(center, light.right.xyz, light.up.xyz, Minv);
+}
+
+// Vector Form Factor of the transformed Polygon, clipped to the Horizon through the Sphere Table
+float LTCRect(vec3 center, vec3 right, vec3 up, mat3 Minv) {
+    vec3 L0 = normalize(Minv * (center - right - up));
+    vec3 L1 = normalize(Minv * (center + right - up));
+    vec3 L2 = normalize(Minv * (center + right + up));
+    vec3 L3 = normalize(Minv * (center - right + up));
+
+    vec3 form_factor = IntegrateEdge(L0, L1) + IntegrateEdge(L1, L2) + IntegrateEdge(L2, L3) + IntegrateEdge(L3, L0);
+    // the Winding is clockwise seen from the lit Side, either Side may be lit when two sided
+    if (dot(form_factor, Minv * center) < 0.0)
+        form_factor = -form_factor;
+    return ClippedSphere(form_factor);
+}
+
+// the transformed Disk is an Ellipse: its Form Factor and mean Direction come from the Eigen System of its Cone
+float LTCDisk(vec3 center, vec3 right, vec3 up, mat3 Minv) {
+    vec3 C = Minv * center;
+    vec3 V1 = Minv * right;
+    vec3 V2 = Minv * up;
+
+    float a, b;
+    float d11 = dot(V1, V1);
+    float d22 = dot(V2, V2);
+    float d12 = dot(V1, V2);
+    if (abs(d12) / sqrt(d11 * d22) > 0.0001) {
+        float tr = d11 + d22;
+        float det = sqrt(-d12 * d12 + d11 * d22);
+        float u = 0.5 * sqrt(tr - 2.0 * det);
+        float v = 0.5 * sqrt(tr + 2.0 * det);
+        float e_max = (u + v) * (u + v);
+        float e_min = (u - v) * (u - v);
+
+        vec3 V1_, V2_;
+        if (d11 > d22) {
+            V1_ = d12 * V1 + (e_max - d11) * V2;
+            V2_ = d12 * V1 + (e_min - d11) * V2;
+        }
+        else {
+            V1_ = d12 * V2 + (e_max - d22) * V1;
+            V2_ = d12 * V2 + (e_min - d22) * V1;
+        }
+        a = 1.0 / e_max;
+        b = 1.0 / e_min;
+        V1 = normalize(V1_);
+        V2 = normalize(V2_);
+    }
+    else {
+        a = 1.0 / d11;
+        b = 1.0 / d22;
+        V1 *= sqrt(a);
+        V2 *= sqrt(b);
+    }
+
+    vec3 V3 = cross(V1, V2);
+    if (dot(C, V3) < 0.0)
+        V3 = -V3;
+
+    float L = dot(V3, C);
+    float x0 = dot(V1, C) / L;
+    float y0 = dot(V2, C) / L;
+    a *= L * L;
+    b *= L * L;
+
+    float c0 = a * b;
+    float c1 = a * b * (1.0 + x0 * x0 + y0 * y0) - a - b;
+    float c2 = 1.0 - a * (1.0 + x0 * x0) - b * (1.0 + y0 * y0);
+    vec3 roots = SolveCubic(vec4(c0, c1, c2, 1.0));
+    float e1 = roots.x;
+    float e2 = roots.y;
+    float e3 = roots.z;
+
+    vec3 direction = normalize(mat3(V1, V2, V3) * vec3(a * x0 / (a - e2), b * y0 / (b - e2), 1.0));
+    float L1 = sqrt(-e2 / e3);
+    float L2 = sqrt(-e2 / e1);
+    float form_factor = L1 * L2 * inversesqrt((1.0 + L1 * L1) * (1.0 + L2 * L2));
+
+    return ClippedSphere(direction * form_factor);
+}
+
+// Edge Integral with a fitted theta / sin(theta) <already divided by 2 pi>
+vec3 IntegrateEdge(vec3 v1, vec3 v2) {
+    float x = dot(v1, v2);
+    float y = abs(x);
+    float a = 0.8543985 + (0.4965155 + 0.0145206 * y) * y;
+    float b = 3.4175940 + (4.1616724 + y) * y;
+    float v = a / b;
+    float theta_sintheta = x > 0.0 ? v : 0.5 * inversesqrt(max(1.0 - x * x, 1e-7)) - v;
+    return cross(v1, v2) * theta_sintheta;
+}
+
+// Horizon Clipping of the Sphere with the same Vector Form Factor
+float ClippedSphere(vec3 form_factor) {
+    float len = length(form_factor);
+    if (len <= 0.0)
+        return 0.0;
+    float z = form_factor.z / len;
+    return len * texture(ltc_amplitude, LTCCoords(vec2(z * 0.5 + 0.5, len))).w;
+}
+
+// Real Roots of c.w x^3 + c.z x^2 + c.y x + c.x, sorted as middle, smallest, largest <Blinn 2007>
+vec3 SolveCubic(vec4 coefficients) {
+    const float pi = 3.14159265;
+
+    coefficients.xyz /= coefficients.w;
+    coefficients.yz /= 3.0;
+
+    float A = coefficients.w;
+    float B = coefficients.z;
+    float C = coefficients.y;
+    float D = coefficients.x;
+
+    vec3 delta = vec3(
+        -coefficients.z * coefficients.z + coefficients.y,
+        -coefficients.y * coefficients.z + coefficients.x,
+        dot(vec2(coefficients.z, -coefficients.y), coefficients.xy)
+    );
+    float discriminant = dot(vec2(4.0 * delta.x, -delta.y), delta.zy);
+
+    vec2 xlc, xsc;
+    {
+        float C_a = delta.x;
+        float D_a = -2.0 * B * delta.x + delta.y;
+        float theta = atan(sqrt(discriminant), -D_a) / 3.0;
+        float x_1a = 2.0 * sqrt(-C_a) * cos(theta);
+        float x_3a = 2.0 * sqrt(-C_a) * cos(theta + (2.0 / 3.0) * pi);
+        float xl = (x_1a + x_3a) > 2.0 * B ? x_1a : x_3a;
+        xlc = vec2(xl - B, A);
+    }
+    {
+        float C_d = delta.z;
+        float D_d = -D * delta.y + 2.0 * C * delta.z;
+        float theta = atan(D * sqrt(discriminant), -D_d) / 3.0;
+        float x_1d = 2.0 * sqrt(-C_d) * cos(theta);
+        float x_3d = 2.0 * sqrt(-C_d) * cos(theta + (2.0 / 3.0) * pi);
+        float xs = x_1d + x_3d < 2.0 * C ? x_1d : x_3d;
+        xsc = vec2(-D, xs + C);
+    }
+
+    float E = xlc.y * xsc.y;
+    float F = -xlc.x * xsc.y - xlc.y * xsc.x;
+    float G = xlc.x * xsc.x;
+    vec2 xmc = vec2(C * F - B * G, -B * F + C * E);
+
+    vec3 root = vec3(xsc.x / xsc.y, xmc.x / xmc.y, xlc.x / xlc.y);
+    if (root.x < root.y && root.x < root.z)
+        root.xyz = root.yxz;
+    else if (root.z < root.x && root.z < root.y)
+        root.xyz = root.xzy;
+    return root;
+}
+
+// View Space Position from the Depth Buffer through the perspective Projection <no Inverse needed>
+vec3 ViewPosition(vec2 uv, float depth) {
+    vec3 ndc = vec3(uv, depth) * 2.0 - 1.0;
+    float z = -projection[3][2] / (ndc.z + projection[2][2]);
+    vec2 xy = -z * (ndc.xy + vec2(projection[2][0], projection[2][1])) / vec2(projection[0][0], projection[1][1]);
+    return vec3(xy, z);
+}
+
+vec3 DecodeNormal(vec2 encoded) {
+    encoded = encoded * 2.0 - 1.0;
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+// Texel Centers of the Tables
+vec2 LTCCoords(vec2 uv) {
+    vec2 size = vec2(textureSize(ltc_matrix, 0));
+    return uv * (size - 1.0) / size + 0.5 / size;
+}
+
 float Brightness(PointLight light, vec3 frag2light) {
     return light.attrib.diffuse.r / (light.attenuation.constant + light.attenuation.linear * length(frag2light));
+}
+
+Dirlight GetDirLight(int i) {
+    Light light = lights[i];
+    return Dirlight(light.direction.xyz, int(light.direction.w), light.position, LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb));
+}
+
+PointLight GetPointLight(int i) {
+    Light light = lights[num_dirlight + i];
+    return PointLight(light.position.xyz, int(light.direction.w), light.position.w, int(light.direction.x), int(light.direction.y),
+                      LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb), Attenuation(light.ambient.a, light.diffuse.a));
+}
+
+SpotLight GetSpotLight(int i) {
+    Light light = lights[num_dirlight + num_pointlight + i];
+    return SpotLight(light.position.xyz, light.direction.xyz, int(light.direction.w), LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb),
+                     Attenuation(light.ambient.a, light.diffuse.a), light.specular.a, light.position.w);
+}
+
+uint ClusterIndex(vec2 fragcoord, float depth) {
+    uint slice = uint(clamp(log(max(depth, 1e-4)) * cluster_params.x + cluster_params.y, 0.0, float(cluster_dims.z - 1u)));
+    uvec2 tile = min(uvec2(fragcoord / cluster_params.zw), cluster_dims.xy - 1u);
+    return (slice * cluster_dims.y + tile.y) * cluster_dims.x + tile.x;
+}
+
+// Keeps Filter Taps inside the Light's own Region
+vec2 AtlasClamp(Dirlight light, vec2 coords) {
+    vec2 half_texel = 0.5 / textureSize(dirlight_shadowmaps[light.shadow], 0);
+    return clamp(coords, light.atlas.xy + half_texel, light.atlas.xy + light.atlas.zw - half_texel);
 }
\ No newline at end of file
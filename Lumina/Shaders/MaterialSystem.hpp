@@ -0,0 +1,505 @@
+// Materials in Texture Arrays + Material SSBO: every registered Mesh is drawn by one glMultiDrawElementsIndirect
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include "../Shader.hpp"
+#include "Model.hpp"
+#include "TextureResidency.hpp"
+
+// Must match GeometryPassBatched.vert/.frag
+const int MATERIAL_ARRAYS_LIMITATION = 8;
+const int DRAWS_SSBO_BINDING = 1;
+const int MATERIALS_SSBO_BINDING = 2;
+
+class MaterialSystem
+{
+public:
+    MaterialSystem()
+    {
+        VAO = 0;
+        DepthVAO = 0;
+        built = false;
+    }
+
+    // Meshes keep their own first diffuse/specular/normal Textures as the Material
+    void AddModel(Model *model, glm::mat4 transform, float metallic = 0.0f, float roughness = 0.5f, float ao = 1.0f)
+    {
+        Source source;
+        source.model = model;
+        source.transform = transform;
+        source.metallic = metallic;
+        source.roughness = roughness;
+        source.ao = ao;
+        sources.push_back(source);
+    }
+
+    // Call once after every Model is added <and after residency->Track, so the Arrays stream through it>
+    // The Arrays take over the Texels of the Mesh Textures, which become Views of their Layer
+    void Build(TextureResidency *residency = nullptr)
+    {
+        buildArrays(residency);
+        buildMaterialsAndGeometry();
+        buildBuffers();
+        built = true;
+
+#ifdef _MODEL_DEBUG
+        std::cout << std::endl;
+        std::cout << "MANUAL_DEBUG::MATERIAL_SYSTEM" << std::endl;
+        std::cout << "Texture Arrays: " << arrays.size() << std::endl;
+        for (int i = 0; i < (int)arrays.size(); ++i)
+            std::cout << "\tSlot: " << i << " || " << arrays[i].width << " * " << arrays[i].height << " * " << arrays[i].layers.size() << std::endl;
+        std::cout << "Materials: " << materials.size() << std::endl;
+        std::cout << "Draws: " << commands.size() << std::endl;
+#endif
+    }
+
+    // GL_TEXTURE17 ~ 17 + MATERIAL_ARRAYS_LIMITATION used for Material Arrays
+    void ShaderConfig(Shader *shader)
+    {
+        shader->Use();
+        for (int i = 0; i < MATERIAL_ARRAYS_LIMITATION; ++i)
+            shader->setInt("material_arrays[" + std::to_string(i) + "]", 17 + i);
+    }
+
+    void SetFactors(Model *model, float metallic, float roughness, float ao)
+    {
+        for (int i = 0; i < (int)materials.size(); ++i)
+            if (material_owner[i] == model)
+            {
+                materials[i].metallic = metallic;
+                materials[i].roughness = roughness;
+                materials[i].ao = ao;
+            }
+        glNamedBufferSubData(MaterialSSBO, 0, materials.size() * sizeof(MaterialData), materials.data());
+    }
+
+    // Zero Rebinds between Materials
+    void Draw()
+    {
+        if (!built || commands.empty())
+            return;
+
+        for (int i = 0; i < (int)arrays.size(); ++i)
+        {
+            glActiveTexture(GL_TEXTURE17 + i);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[i].ID);
+        }
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAWS_SSBO_BINDING, DrawSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_SSBO_BINDING, MaterialSSBO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+        glBindVertexArray(VAO);
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)commands.size(), 0);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Position only, no Textures or Materials <Depth Pre-Pass, any Shader reading the Draws SSBO>
+    // Fetches the packed Position Stream, same Indices and Commands as Draw
+    void DrawDepth()
+    {
+        if (!built || commands.empty())
+            return;
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAWS_SSBO_BINDING, DrawSSBO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+        glBindVertexArray(DepthVAO);
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)commands.size(), 0);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // Commands and Draws front to back from the Eye, uploaded only when the Order changes
+    // <gl_DrawID indexes the Draws SSBO, so both are permuted together>
+    void Sort(glm::vec3 eye)
+    {
+        if (!built || commands.empty())
+            return;
+
+        std::vector<int> sorted(commands.size());
+        std::vector<float> distances(commands.size());
+        for (int i = 0; i < (int)commands.size(); ++i)
+        {
+            glm::vec3 offset = centers[i] - eye;
+            distances[i] = glm::dot(offset, offset);
+            sorted[i] = i;
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [&](int a, int b) { return distances[a] < distances[b]; });
+        if (sorted == order)
+            return;
+        upload(sorted);
+    }
+
+    // Back to the Order the Models were added in
+    void Unsort()
+    {
+        if (!built || commands.empty())
+            return;
+
+        std::vector<int> identity(commands.size());
+        for (int i = 0; i < (int)identity.size(); ++i)
+            identity[i] = i;
+        if (identity != order)
+            upload(identity);
+    }
+
+    int ArrayCount() { return (int)arrays.size(); }
+    int MaterialCount() { return (int)materials.size(); }
+    int DrawCount() { return (int)commands.size(); }
+
+private:
+    struct Source
+    {
+        Model *model;
+        glm::mat4 transform;
+        float metallic;
+        float roughness;
+        float ao;
+    };
+
+    struct TextureArray
+    {
+        unsigned int ID;
+        GLenum internalformat;
+        int width;
+        int height;
+        int levels;
+        std::vector<unsigned int> layers; // Texture Meshes draw each Layer with <the Source, a View once built>
+    };
+
+    // std430 Layouts
+    struct MaterialData
+    {
+        int diffuse[2];  // (array, layer) <-1 when absent>
+        int specular[2];
+        int normal[2];
+        float metallic;
+        float roughness;
+        float ao;
+        float padding;
+    };
+
+    struct DrawData
+    {
+        glm::mat4 model;
+        unsigned int material;
+        unsigned int padding[3];
+    };
+
+    struct DrawElementsIndirectCommand
+    {
+        unsigned int count;
+        unsigned int instanceCount;
+        unsigned int firstIndex;
+        int baseVertex;
+        unsigned int baseInstance;
+    };
+
+    std::vector<Source> sources;
+    std::vector<TextureArray> arrays;
+    std::vector<MaterialData> materials;
+    std::vector<Model *> material_owner;
+    std::vector<DrawData> draws;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<glm::vec3> centers;     // World Space Bounds Center of each Command
+    std::vector<int> order;             // Command uploaded at each Slot
+    std::vector<Mesh *> merged;         // each Mesh's Geometry is in the Buffers once, merged[i] starts at commands[merged_command[i]]
+    std::vector<int> merged_command;
+    std::vector<Vertex> vertices;       // only until buildBuffers uploads them
+    std::vector<unsigned int> indices;
+
+    unsigned int VAO;
+    unsigned int VBO;
+    unsigned int EBO;
+    unsigned int DepthVAO;
+    unsigned int PositionVBO;
+    unsigned int IndirectBuffer;
+    unsigned int DrawSSBO;
+    unsigned int MaterialSSBO;
+    bool built;
+
+    // glTexStorage3D needs sized Formats
+    static GLenum sizedFormat(GLint internalformat)
+    {
+        switch (internalformat)
+        {
+        case GL_RED: return GL_R8;
+        case GL_RGB: return GL_RGB8;
+        case GL_RGBA: return GL_RGBA8;
+        case GL_SRGB: return GL_SRGB8;
+        case GL_SRGB_ALPHA: return GL_SRGB8_ALPHA8;
+        default: return (GLenum)internalformat;
+        }
+    }
+
+    // Mips the Source really has <Atlas Pages stop at their safe Level, coarser ones would mix Rects>
+    static int sourceLevels(unsigned int id, int width, int height)
+    {
+        int max_level = 1000;
+        glBindTexture(GL_TEXTURE_2D, id);
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &max_level);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return std::min(1 + (int)std::floor(std::log2((float)std::max(width, height))), max_level + 1);
+    }
+
+    // Same Format, Size and Mip Count share one GL_TEXTURE_2D_ARRAY
+    void buildArrays(TextureResidency *residency)
+    {
+        for (Source &source : sources)
+            for (Mesh &amesh : source.model->ServeMeshes())
+                for (Texture &atexture : amesh.textures)
+                {
+                    if (locate(atexture.id)[0] >= 0)
+                        continue;
+
+                    int width, height, internalformat;
+                    glBindTexture(GL_TEXTURE_2D, atexture.id);
+                    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+                    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+                    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalformat);
+                    glBindTexture(GL_TEXTURE_2D, 0);
+
+                    GLenum format = sizedFormat(internalformat);
+                    int levels = sourceLevels(atexture.id, width, height);
+                    int slot = -1;
+                    for (int i = 0; i < (int)arrays.size(); ++i)
+                        if (arrays[i].internalformat == format && arrays[i].width == width && arrays[i].height == height && arrays[i].levels == levels)
+                            slot = i;
+
+                    if (slot < 0)
+                    {
+                        if ((int)arrays.size() == MATERIAL_ARRAYS_LIMITATION)
+                        {
+                            std::cout << "ERROR::MATERIAL_SYSTEM:: Too many Texture Formats, Texture " << atexture.path.C_Str() << " is Skipped." << std::endl;
+                            continue;
+                        }
+                        TextureArray array;
+                        array.internalformat = format;
+                        array.width = width;
+                        array.height = height;
+                        array.levels = levels;
+                        arrays.push_back(array);
+                        slot = (int)arrays.size() - 1;
+                    }
+                    arrays[slot].layers.push_back(atexture.id);
+                }
+
+        for (TextureArray &array : arrays)
+        {
+            glGenTextures(1, &array.ID);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.ID);
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, array.levels, array.internalformat, array.width, array.height, (GLsizei)array.layers.size());
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+            // GPU side Copy of every existing Mip, no Round Trip through the CPU and no Filter over Atlas Pages
+            std::vector<unsigned int> originals = array.layers;
+            for (int layer = 0; layer < (int)array.layers.size(); ++layer)
+                for (int level = 0; level < array.levels; ++level)
+                    glCopyImageSubData(originals[layer], GL_TEXTURE_2D, level, 0, 0, 0, array.ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+                                       std::max(array.width >> level, 1), std::max(array.height >> level, 1), 1);
+
+            // the Array owns the Texels from here on, unbatched Draws sample their Layer through a View
+            for (int layer = 0; layer < (int)array.layers.size(); ++layer)
+            {
+                array.layers[layer] = layerView(array, layer, originals[layer]);
+                replaceTexture(originals[layer], array.layers[layer]);
+                glDeleteTextures(1, &originals[layer]);
+            }
+
+            if (residency)
+                residency->TrackArray(&array.ID, originals, array.layers, array.levels);
+        }
+    }
+
+    static unsigned int layerView(TextureArray &array, int layer, unsigned int original)
+    {
+        GLint wrap_s, wrap_t;
+        glGetTextureParameteriv(original, GL_TEXTURE_WRAP_S, &wrap_s);
+        glGetTextureParameteriv(original, GL_TEXTURE_WRAP_T, &wrap_t);
+
+        unsigned int view;
+        glGenTextures(1, &view);
+        glTextureView(view, GL_TEXTURE_2D, array.ID, array.internalformat, 0, array.levels, layer, 1);
+        glTextureParameteri(view, GL_TEXTURE_WRAP_S, wrap_s);
+        glTextureParameteri(view, GL_TEXTURE_WRAP_T, wrap_t);
+        glTextureParameteri(view, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(view, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        return view;
+    }
+
+    void replaceTexture(unsigned int original, unsigned int view)
+    {
+        for (Source &source : sources)
+            for (Mesh &amesh : source.model->ServeMeshes())
+                for (Texture &atexture : amesh.textures)
+                    if (atexture.id == original)
+                        atexture.id = view;
+    }
+
+    // (array, layer) of a Mesh Texture
+    std::vector<int> locate(unsigned int id)
+    {
+        for (int i = 0; i < (int)arrays.size(); ++i)
+            for (int layer = 0; layer < (int)arrays[i].layers.size(); ++layer)
+                if (arrays[i].layers[layer] == id)
+                    return {i, layer};
+        return {-1, -1};
+    }
+
+    void buildMaterialsAndGeometry()
+    {
+        for (Source &source : sources)
+            for (Mesh &amesh : source.model->ServeMeshes())
+            {
+                MaterialData material;
+                material.diffuse[0] = material.diffuse[1] = -1;
+                material.specular[0] = material.specular[1] = -1;
+                material.normal[0] = material.normal[1] = -1;
+                material.metallic = source.metallic;
+                material.roughness = source.roughness;
+                material.ao = source.ao;
+                material.padding = 0.0f;
+
+                for (Texture &atexture : amesh.textures)
+                {
+                    std::vector<int> location = locate(atexture.id);
+                    int *target = atexture.type == "texture_diffuse" ? material.diffuse : atexture.type == "texture_specular" ? material.specular : atexture.type == "texture_normal" ? material.normal : nullptr;
+                    if (target && target[0] < 0)
+                    {
+                        target[0] = location[0];
+                        target[1] = location[1];
+                    }
+                }
+
+                // Identical Materials are shared
+                int slot = -1;
+                for (int i = 0; i < (int)materials.size() && slot < 0; ++i)
+                    if (material_owner[i] == source.model && std::memcmp(&materials[i], &material, sizeof(MaterialData)) == 0)
+                        slot = i;
+                if (slot < 0)
+                {
+                    materials.push_back(material);
+                    material_owner.push_back(source.model);
+                    slot = (int)materials.size() - 1;
+                }
+
+                // a Model added twice draws the same Geometry with its second Transform
+                int copy = (int)(std::find(merged.begin(), merged.end(), &amesh) - merged.begin());
+                DrawElementsIndirectCommand command;
+                command.count = (unsigned int)amesh.indices.size();
+                command.instanceCount = 1;
+                command.firstIndex = copy < (int)merged.size() ? commands[merged_command[copy]].firstIndex : (unsigned int)indices.size();
+                command.baseVertex = copy < (int)merged.size() ? commands[merged_command[copy]].baseVertex : (int)vertices.size();
+                command.baseInstance = 0;
+                commands.push_back(command);
+
+                DrawData draw;
+                draw.model = source.transform;
+                draw.material = (unsigned int)slot;
+                draw.padding[0] = draw.padding[1] = draw.padding[2] = 0;
+                draws.push_back(draw);
+                centers.push_back(glm::vec3(source.transform * glm::vec4(0.5f * (amesh.AABB_min + amesh.AABB_max), 1.0f)));
+                order.push_back((int)order.size());
+
+                if (copy < (int)merged.size())
+                    continue;
+                merged.push_back(&amesh);
+                merged_command.push_back((int)commands.size() - 1);
+                vertices.insert(vertices.end(), amesh.vertices.begin(), amesh.vertices.end());
+                indices.insert(indices.end(), amesh.indices.begin(), amesh.indices.end());
+            }
+    }
+
+    void buildBuffers()
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        // Same Layout as Mesh::setpuMesh
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, Texcoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, Tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, BiTangent));
+        glBindVertexArray(0);
+
+        // Packed Positions indexed like the Vertices <baseVertex of the Commands still applies>
+        std::vector<glm::vec3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+            positions[i] = vertices[i].Position;
+
+        glGenVertexArrays(1, &DepthVAO);
+        glGenBuffers(1, &PositionVBO);
+        glBindVertexArray(DepthVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, PositionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+        glBindVertexArray(0);
+
+        // the GPU holds the only merged Copy: the Meshes draw from it too and drop their own Buffers
+        for (int i = 0; i < (int)merged.size(); ++i)
+            merged[i]->ShareBuffers(VBO, EBO, commands[merged_command[i]].baseVertex, commands[merged_command[i]].firstIndex);
+        std::vector<Vertex>().swap(vertices);
+        std::vector<unsigned int>().swap(indices);
+
+        // Rewritten by Sort
+        glGenBuffers(1, &IndirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        glGenBuffers(1, &DrawSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, DrawSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, draws.size() * sizeof(DrawData), draws.data(), GL_DYNAMIC_DRAW);
+
+        glGenBuffers(1, &MaterialSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, MaterialSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(MaterialData), materials.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void upload(const std::vector<int> &sorted)
+    {
+        std::vector<DrawElementsIndirectCommand> sorted_commands;
+        std::vector<DrawData> sorted_draws;
+        sorted_commands.reserve(sorted.size());
+        sorted_draws.reserve(sorted.size());
+        for (int i : sorted)
+        {
+            sorted_commands.push_back(commands[i]);
+            sorted_draws.push_back(draws[i]);
+        }
+        glNamedBufferSubData(IndirectBuffer, 0, sorted_commands.size() * sizeof(DrawElementsIndirectCommand), sorted_commands.data());
+        glNamedBufferSubData(DrawSSBO, 0, sorted_draws.size() * sizeof(DrawData), sorted_draws.data());
+        order = sorted;
+    }
+};
@@ -3,6 +3,7 @@
 #include <assimp/Importer.hpp>
 
 #include <vector>
+#include <utility>
 
 #include "glm/glm.hpp"
 #include "../Shader.hpp"
@@ -27,12 +28,16 @@ public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
+    // Bounds <object space>
+    glm::vec3 AABB_min;
+    glm::vec3 AABB_max;
     // Function
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures) {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
         setpuMesh();
+        setupBounds();
     }
 
     void Draw(Shader *shader) {
@@ -40,7 +45,7 @@ public:
 
         // draw Mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, (void *)index_offset);
 
         // set otherthings back to defaults
         glBindVertexArray(0);
@@ -53,7 +58,7 @@ public:
         glBindVertexArray(VAO);
         // glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, 0);
         // Using Func::glDrawElementsInstanced() for Instance Rendering
-        glDrawElementsInstanced(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, 0, num);
+        glDrawElementsInstanced(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, (void *)index_offset, num);
 
         glBindVertexArray(0);
         glActiveTexture(GL_TEXTURE0);
@@ -64,11 +69,64 @@ public:
         return this->VAO;
     }
 
+    // Re-upload vertices after they were edited on the CPU (e.g. UV remapping)
+    void UpdateVertices() {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, vertex_offset, vertices.size() * sizeof(Vertex), &vertices[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Draw from another Owner's Buffers, where this Mesh starts at base_vertex / first_index <MaterialSystem merges every Mesh>
+    // the Mesh's own Buffers are released, Delete leaves the shared ones to their Owner
+    void ShareBuffers(unsigned int vbo, unsigned int ebo, int base_vertex, unsigned int first_index) {
+        if (owns_buffers) {
+            glDeleteBuffers(1, &VBO);
+            glDeleteBuffers(1, &EBO);
+        }
+        VBO = vbo;
+        EBO = ebo;
+        vertex_offset = (size_t)base_vertex * sizeof(Vertex);
+        index_offset = (size_t)first_index * sizeof(unsigned int);
+        owns_buffers = false;
+
+        // glVertexAttribPointer put Attribute i on Binding i with the Offset on the Binding, so only the Bindings move
+        const size_t offsets[5] = {0, offsetof(Vertex, Normal), offsetof(Vertex, Texcoords), offsetof(Vertex, Tangent), offsetof(Vertex, BiTangent)};
+        for (int i = 0; i < 5; ++i)
+            glVertexArrayVertexBuffer(VAO, i, VBO, (GLintptr)(vertex_offset + offsets[i]), sizeof(Vertex));
+        glVertexArrayElementBuffer(VAO, EBO);
+    }
+
+    void Delete() {
+        glDeleteVertexArrays(1, &VAO);
+        if (owns_buffers) {
+            glDeleteBuffers(1, &VBO);
+            glDeleteBuffers(1, &EBO);
+        }
+    }
+
 private:
     // Render Data
     unsigned int VAO;
     unsigned int VBO;
     unsigned int EBO;
+    size_t vertex_offset = 0;   // where the Mesh starts in VBO / EBO <not 0 once the Buffers are shared>
+    size_t index_offset = 0;
+    bool owns_buffers = true;
+
+    // used by screen-space estimations (texture residency, culling)
+    void setupBounds() {
+        AABB_min = glm::vec3(0.0f);
+        AABB_max = glm::vec3(0.0f);
+        if (vertices.empty())
+            return;
+
+        AABB_min = vertices[0].Position;
+        AABB_max = vertices[0].Position;
+        for (const Vertex &avertex : vertices) {
+            AABB_min = glm::min(AABB_min, avertex.Position);
+            AABB_max = glm::max(AABB_max, avertex.Position);
+        }
+    }
 
     void setpuMesh() {
         glGenVertexArrays(1, &VAO);
@@ -0,0 +1,27 @@
+#version 430 core
+// One Level of the Min/Max Depth Chain: every Texel keeps the nearest and farthest of the 2x2 Texels below it
+
+layout (location = 0) out vec2 MinMax;
+
+uniform sampler2D source;
+uniform bool from_depth;        // first Level reads the Shadow Map itself
+uniform ivec2 source_offset;    // Region Origin in the Shadow Map
+
+void main() {
+    ivec2 base = source_offset + 2 * ivec2(gl_FragCoord.xy);
+
+    vec2 a = texelFetch(source, base, 0).rg;
+    vec2 b = texelFetch(source, base + ivec2(1, 0), 0).rg;
+    vec2 c = texelFetch(source, base + ivec2(0, 1), 0).rg;
+    vec2 d = texelFetch(source, base + ivec2(1, 1), 0).rg;
+
+    // a Depth Texture only has r
+    if (from_depth) {
+        a.g = a.r;
+        b.g = b.r;
+        c.g = c.r;
+        d.g = d.r;
+    }
+
+    MinMax = vec2(min(min(a.r, b.r), min(c.r, d.r)), max(max(a.g, b.g), max(c.g, d.g)));
+}
\ No newline at end of file
@@ -1,10 +1,17 @@
 #include "Model.hpp"
 
+#include <cmath>
+#include <algorithm>
+
 #define STB_IMAGE_STATIC
 #define STB_IMAGE_IMPLEMENTATION
 
 #include "stb_image.h"
 
+// imgui_draw.cpp keeps its own static Copy
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "../imgui/imstb_rectpack.h"
+
 unsigned int TextureFromFile(const char *name, const std::string directory, bool needGammacorrection)
 {
     std::string fileName = std::string(name);
@@ -54,4 +61,102 @@ unsigned int TextureFromFile(const char *name, const std::string directory, bool
     }
 
     return textureID;
-}
\ No newline at end of file
+}
+
+bool TextureLevelsDecode(const char *name, const std::string directory, bool needGammacorrection, int top_level, TextureLevels &levels)
+{
+    std::string fileName = std::string(name);
+    fileName = directory + '/' + fileName;
+
+    int width;
+    int height;
+    int colorChannels;
+    unsigned char *textureData = stbi_load(fileName.c_str(), &width, &height, &colorChannels, 0);
+
+    if (!textureData)
+    {
+        std::cout << "Texture Failed to Stream at Path:" << fileName << std::endl;
+        return false;
+    }
+
+    // 2x2 Box Filter down to the requested Level <the same Filter glGenerateMipmap usually uses>
+    // sRGB Color is averaged in linear Space like glGenerateMipmap does, Alpha and non-Color Data as stored
+    int srgb_channels = needGammacorrection && colorChannels >= 3 ? 3 : 0;
+    float to_linear[256];
+    for (int i = 0; i < 256; ++i)
+    {
+        float c = i / 255.0f;
+        to_linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    std::vector<float> level((size_t)width * height * colorChannels);
+    for (size_t i = 0; i < level.size(); ++i)
+        level[i] = (int)(i % colorChannels) < srgb_channels ? to_linear[textureData[i]] : textureData[i] / 255.0f;
+    stbi_image_free(textureData);
+
+    for (int mip = 0; mip < top_level && (width > 1 || height > 1); ++mip)
+    {
+        int next_width = width > 1 ? width / 2 : 1;
+        int next_height = height > 1 ? height / 2 : 1;
+        std::vector<float> next((size_t)next_width * next_height * colorChannels);
+
+        for (int y = 0; y < next_height; ++y)
+            for (int x = 0; x < next_width; ++x)
+                for (int c = 0; c < colorChannels; ++c)
+                {
+                    int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                    int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+                    float sum = level[((size_t)y0 * width + x0) * colorChannels + c] + level[((size_t)y0 * width + x1) * colorChannels + c] +
+                                level[((size_t)y1 * width + x0) * colorChannels + c] + level[((size_t)y1 * width + x1) * colorChannels + c];
+                    next[((size_t)y * next_width + x) * colorChannels + c] = sum * 0.25f;
+                }
+
+        level.swap(next);
+        width = next_width;
+        height = next_height;
+    }
+
+    levels.width = width;
+    levels.height = height;
+    levels.channels = colorChannels;
+    levels.gamma = needGammacorrection;
+    levels.pixels.resize(level.size());
+    for (size_t i = 0; i < level.size(); ++i)
+    {
+        float c = std::clamp(level[i], 0.0f, 1.0f);
+        if ((int)(i % colorChannels) < srgb_channels)
+            c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        levels.pixels[i] = (unsigned char)(c * 255.0f + 0.5f);
+    }
+
+    return true;
+}
+
+void TextureLevelsUpload(unsigned int textureID, const TextureLevels &levels)
+{
+    GLenum format = levels.channels == 1 ? GL_RED : levels.channels == 3 ? GL_RGB : GL_RGBA;
+    GLenum internalformat;
+    if (levels.channels == 1)
+        internalformat = GL_RED;
+    else if (levels.channels == 3)
+        internalformat = levels.gamma ? GL_SRGB : GL_RGB;
+    else
+        internalformat = levels.gamma ? GL_SRGB_ALPHA : GL_RGBA;
+
+    // Respecifying Level 0 of a mutable Texture releases the old Storage
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalformat, levels.width, levels.height, 0, format, GL_UNSIGNED_BYTE, levels.pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool TextureLevelsFromFile(unsigned int textureID, const char *name, const std::string directory, bool needGammacorrection, int top_level)
+{
+    TextureLevels levels;
+    if (!TextureLevelsDecode(name, directory, needGammacorrection, top_level, levels))
+        return false;
+    TextureLevelsUpload(textureID, levels);
+    return true;
+}
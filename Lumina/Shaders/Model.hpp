@@ -4,41 +4,144 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
 #ifdef _MODEL_DEBUG
 #include <iostream>
 #endif
 
 #include "../Shader.hpp"
 #include "Mesh.hpp"
+#include "TextureAtlas.hpp"
+#include "PMXLoader.hpp"
+#include "TangentSpace.hpp"
 
 unsigned int TextureFromFile(const char *path, const std::string directory, bool needGammacorrection);
+// A Texture's Level top_level and nothing finer, decoded on the CPU
+struct TextureLevels
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    bool gamma = false;
+    std::vector<unsigned char> pixels;
+};
+// Decode Half of Streaming, no GL Calls so it can run on any Thread <used by TextureResidency's Worker>
+bool TextureLevelsDecode(const char *path, const std::string directory, bool needGammacorrection, int top_level, TextureLevels &levels);
+// Upload Half: Level 0 of the Texture becomes the decoded Level, the Chain below is regenerated
+void TextureLevelsUpload(unsigned int textureID, const TextureLevels &levels);
+// Reloads a Texture from disk with its top <top_level> mips dropped <both Halves on the calling Thread>
+bool TextureLevelsFromFile(unsigned int textureID, const char *path, const std::string directory, bool needGammacorrection, int top_level);
+
+// Loading Options
+#define MODEL_NATIVE_PMX 0x1        // .pmx Files skip Assimp <Assimp stays the Fallback>
+#define MODEL_NATIVE_TANGENTS 0x2   // TangentSpace instead of aiProcess_CalcTangentSpace and aiProcess_GenSmoothNormals
+#define MODEL_NATIVE_ALL (MODEL_NATIVE_PMX | MODEL_NATIVE_TANGENTS)
 
 class Model
 {
 public:
-    Model(const char *path)
+    Model(const char *path, unsigned int options = MODEL_NATIVE_ALL)
     {
-        loadModel(path);
+        auto start = std::chrono::high_resolution_clock::now();
+        this->options = options;
+        if (!((options & MODEL_NATIVE_PMX) && isPMX(path) && loadPMX(path)))
+            loadModel(path);
+        uploadStaged();
+        load_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
     }
 
     void Draw(Shader *shader)
     {
-        for (Mesh amesh : meshes)
+        for (Mesh &amesh : meshes)
             amesh.Draw(shader);
     }
 
+    // Depth only Passes <Shadows, Pre-Pass>: 12 Byte Positions instead of the 56 Byte Vertex,
+    // one Index Buffer across every Material so the whole Model is a single Draw
+    void DrawDepth()
+    {
+        glBindVertexArray(DepthVAO);
+        glDrawElements(GL_TRIANGLES, depth_count, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
+    // One Mesh out of the Position Stream <Casters culled per Mesh>
+    void DrawDepth(int mesh)
+    {
+        glBindVertexArray(DepthVAO);
+        glDrawElements(GL_TRIANGLES, depth_ranges[mesh].count, GL_UNSIGNED_INT, (void *)(depth_ranges[mesh].first * sizeof(unsigned int)));
+        glBindVertexArray(0);
+    }
+
+    // Opaque Meshes front to back by their Bounds' Center so early Depth Tests reject the hidden ones
+    void DrawSorted(Shader *shader, const glm::mat4 &transform, glm::vec3 eye, bool depth_only = false)
+    {
+        std::vector<std::pair<float, int>> order;
+        order.reserve(meshes.size());
+        for (int i = 0; i < (int)meshes.size(); ++i)
+        {
+            glm::vec3 center = glm::vec3(transform * glm::vec4(0.5f * (meshes[i].AABB_min + meshes[i].AABB_max), 1.0f));
+            glm::vec3 offset = center - eye;
+            order.push_back({glm::dot(offset, offset), i});
+        }
+        std::sort(order.begin(), order.end());
+
+        for (std::pair<float, int> &entry : order)
+        {
+            if (depth_only)
+                DrawDepth(entry.second);
+            else
+                meshes[entry.second].Draw(shader);
+        }
+    }
+
     void DrawbyInstance(Shader *shader, int num)
     {
-        for (Mesh amesh : meshes)
+        for (Mesh &amesh : meshes)
             amesh.DrawbyInstance(shader, num);
     }
 
     // Used for Instance Rendering
-    std::vector<Mesh> ServeMeshes()
+    std::vector<Mesh> &ServeMeshes()
     {
         return this->meshes;
     }
 
+    // Packs small Textures into shared Atlas Pages so Meshes sharing a Page are drawn in one Batch
+    // Should be called right after Loading
+    void BuildAtlases(int max_texture_size = 256, int atlas_size = 2048)
+    {
+        atlas = TextureAtlas(max_texture_size, atlas_size);
+        atlas.Build(meshes, textures_loaded);
+        // Merged Meshes change the Ranges
+        buildDepthStream();
+    }
+
+    // Vertices in the Position Stream <welded, so usually fewer than the Meshes hold>
+    int ServeDepthVertices()
+    {
+        return this->depth_vertices;
+    }
+
+    // Used for Texture Streaming
+    std::string ServeDirectory()
+    {
+        return this->directory;
+    }
+
+    // Wall Time of the Constructor <Parsing, Texture Decoding and Uploads>
+    double ServeLoadTime()
+    {
+        return this->load_ms;
+    }
+
 private:
     // Optimization
     std::vector<Texture> textures_loaded;
@@ -46,12 +149,42 @@ private:
     // Meshs
     std::vector<Mesh> meshes;
     std::string directory;
+    TextureAtlas atlas;
+    unsigned int options;
+    double load_ms;
+
+    // Position Stream for Depth only Passes
+    struct DepthRange
+    {
+        unsigned int first;
+        unsigned int count;
+    };
+    std::vector<DepthRange> depth_ranges;
+    unsigned int DepthVAO = 0;
+    unsigned int DepthVBO = 0;
+    unsigned int DepthEBO = 0;
+    int depth_count = 0;
+    int depth_vertices = 0;
+
+    // CPU Side of the Meshes until every Tangent Frame is done <GL Objects are created on this Thread afterwards>
+    struct StagedMesh
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<Texture> textures;
+        bool generate_normals;
+        bool generate_tangents;
+    };
+    std::vector<StagedMesh> staged;
 
     // funcs
     void loadModel(std::string path)
     {
         Assimp::Importer importer;
-        const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
+        unsigned int flags = aiProcess_Triangulate | aiProcess_FlipUVs;
+        if (!(options & MODEL_NATIVE_TANGENTS))
+            flags |= aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
+        const aiScene *scene = importer.ReadFile(path, flags);
 
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         {
@@ -63,23 +196,173 @@ private:
         processNode(scene->mRootNode, scene);
     }
 
+    static bool isPMX(std::string path)
+    {
+        std::string extension = path.substr(path.find_last_of('.') + 1);
+        for (char &c : extension)
+            c = (char)std::tolower((unsigned char)c);
+        return extension == "pmx";
+    }
+
+    // One Mesh per PMX Material <only the Vertices a Material references are copied into it>
+    bool loadPMX(std::string path)
+    {
+        PMXModel pmx;
+        if (!LoadPMX(path, pmx))
+            return false;
+        directory = path.substr(0, path.find_last_of('/'));
+
+        std::vector<unsigned int> remap(pmx.vertices.size());
+        std::vector<int> owner(pmx.vertices.size(), -1);
+        for (int m = 0; m < (int)pmx.materials.size(); ++m)
+        {
+            PMXMaterial &material = pmx.materials[m];
+            if (material.index_count == 0)
+                continue;
+
+            StagedMesh amesh;
+            std::vector<Vertex> &vertices = amesh.vertices;
+            std::vector<unsigned int> &indices = amesh.indices;
+            indices.reserve(material.index_count);
+
+            for (unsigned int i = material.first_index; i < material.first_index + material.index_count; ++i)
+            {
+                unsigned int index = pmx.indices[i];
+                if (owner[index] != m)
+                {
+                    owner[index] = m;
+                    remap[index] = (unsigned int)vertices.size();
+                    vertices.push_back(pmx.vertices[index]);
+                }
+                indices.push_back(remap[index]);
+            }
+            // Sphere and Toon Maps stay in PMXMaterial <the Assimp path doesn't bind them either>
+            if (material.texture >= 0 && material.texture < (int)pmx.textures.size())
+            {
+                aiString texturePath;
+                texturePath.Set(pmx.textures[material.texture]);
+                amesh.textures.push_back(loadCachedTexture(texturePath, "texture_diffuse", true));
+            }
+
+            // PMX has no Tangents, its Normals are kept
+            amesh.generate_normals = false;
+            amesh.generate_tangents = true;
+            staged.push_back(std::move(amesh));
+        }
+
+        return true;
+    }
+
+    // Tangent Frames of all Meshes are generated together <parallel over Meshes and Triangle Ranges>
+    void uploadStaged()
+    {
+        std::vector<TangentSpaceInput> inputs;
+        for (StagedMesh &amesh : staged)
+            if (amesh.generate_tangents)
+                inputs.push_back({&amesh.vertices, &amesh.indices, amesh.generate_normals});
+        TangentSpace::Generate(inputs);
+
+        for (StagedMesh &amesh : staged)
+            meshes.push_back(Mesh(std::move(amesh.vertices), std::move(amesh.indices), std::move(amesh.textures)));
+        staged.clear();
+        staged.shrink_to_fit();
+
+        buildDepthStream();
+    }
+
+    // Bit Pattern of a Position, Seams split Vertices by Normal or UV only and weld back together here
+    struct PositionKey
+    {
+        unsigned int bits[3];
+        bool operator==(const PositionKey &other) const
+        {
+            return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+        }
+    };
+
+    struct PositionHash
+    {
+        size_t operator()(const PositionKey &key) const
+        {
+            return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+        }
+    };
+
+    // De-interleaved Positions of every Mesh with one merged Index Buffer, each Mesh keeps its Range in it
+    void buildDepthStream()
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        std::unordered_map<PositionKey, unsigned int, PositionHash> welded;
+        depth_ranges.clear();
+
+        for (Mesh &amesh : meshes)
+        {
+            std::vector<unsigned int> remap(amesh.vertices.size());
+            for (size_t v = 0; v < amesh.vertices.size(); ++v)
+            {
+                PositionKey key;
+                std::memcpy(key.bits, &amesh.vertices[v].Position, sizeof(key.bits));
+                auto found = welded.find(key);
+                if (found == welded.end())
+                {
+                    found = welded.emplace(key, (unsigned int)positions.size()).first;
+                    positions.push_back(amesh.vertices[v].Position);
+                }
+                remap[v] = found->second;
+            }
+
+            DepthRange range;
+            range.first = (unsigned int)indices.size();
+            range.count = (unsigned int)amesh.indices.size();
+            depth_ranges.push_back(range);
+            for (unsigned int index : amesh.indices)
+                indices.push_back(remap[index]);
+        }
+
+        if (DepthVAO)
+        {
+            glDeleteVertexArrays(1, &DepthVAO);
+            glDeleteBuffers(1, &DepthVBO);
+            glDeleteBuffers(1, &DepthEBO);
+        }
+        depth_count = (int)indices.size();
+        depth_vertices = (int)positions.size();
+
+        glGenVertexArrays(1, &DepthVAO);
+        glGenBuffers(1, &DepthVBO);
+        glGenBuffers(1, &DepthEBO);
+
+        glBindVertexArray(DepthVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, DepthVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, DepthEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        // Location 0 like the full Vertex, so every Depth Shader works on both
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+        glBindVertexArray(0);
+    }
+
     void processNode(aiNode *node, const aiScene *scene)
     {
         for (unsigned int i = 0; i < node->mNumMeshes; ++i)
         {
             aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            staged.push_back(processMesh(mesh, scene));
         }
 
         for (unsigned int i = 0; i < node->mNumChildren; ++i)
             processNode(node->mChildren[i], scene);
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    StagedMesh processMesh(aiMesh *mesh, const aiScene *scene)
     {
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
         std::vector<Texture> textures;
+        vertices.reserve(mesh->mNumVertices);
 
         // Vertex
         for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
@@ -108,19 +391,23 @@ private:
                 texcoords.y = mesh->mTextureCoords[0][i].y;
                 vertex.Texcoords = texcoords;
 
-                // Tangent
-                glm::vec3 tangent;
-                tangent.x = mesh->mTangents[i].x;
-                tangent.y = mesh->mTangents[i].y;
-                tangent.z = mesh->mTangents[i].z;
-                vertex.Tangent = tangent;
-
-                //BiTangent
-                glm::vec3 bitangent;
-                bitangent.x = mesh->mBitangents[i].x;
-                bitangent.y = mesh->mBitangents[i].y;
-                bitangent.z = mesh->mBitangents[i].z;
-                vertex.BiTangent = bitangent;
+                // Tangents only come from Assimp without MODEL_NATIVE_TANGENTS
+                if (mesh->mTangents && mesh->mBitangents)
+                {
+                    // Tangent
+                    glm::vec3 tangent;
+                    tangent.x = mesh->mTangents[i].x;
+                    tangent.y = mesh->mTangents[i].y;
+                    tangent.z = mesh->mTangents[i].z;
+                    vertex.Tangent = tangent;
+
+                    //BiTangent
+                    glm::vec3 bitangent;
+                    bitangent.x = mesh->mBitangents[i].x;
+                    bitangent.y = mesh->mBitangents[i].y;
+                    bitangent.z = mesh->mBitangents[i].z;
+                    vertex.BiTangent = bitangent;
+                }
             }
             else
                 vertex.Texcoords = glm::vec2(0.0f, 0.0f);
@@ -163,7 +450,13 @@ private:
         std::cout << std::endl;
 #endif
 
-        return Mesh(vertices, indices, textures);
+        StagedMesh amesh;
+        amesh.vertices = std::move(vertices);
+        amesh.indices = std::move(indices);
+        amesh.textures = std::move(textures);
+        amesh.generate_tangents = (options & MODEL_NATIVE_TANGENTS) != 0;
+        amesh.generate_normals = amesh.generate_tangents && !mesh->HasNormals();
+        return amesh;
     }
 
     std::vector<Texture> loadMaterialTexture(aiMaterial *material, aiTextureType type, std::string typeName, bool needGammacorrection)
@@ -173,29 +466,23 @@ private:
         {
             aiString texturePath;
             material->GetTexture(type, i, &texturePath);
-
-            bool skip = false;
-            for (unsigned int j = 0; j < textures_loaded.size(); ++j)
-            {
-                if (std::strcmp(textures_loaded[j].path.data, texturePath.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true;
-                    break;
-                }
-            }
-
-            if (!skip)
-            {
-                Texture texture;
-                texture.id = TextureFromFile(texturePath.C_Str(), directory, needGammacorrection);
-                texture.type = typeName;
-                texture.path = texturePath;
-                textures.push_back(texture);
-                textures_loaded.push_back(texture); // add the texture in the textures_loaded vector
-            }
+            textures.push_back(loadCachedTexture(texturePath, typeName, needGammacorrection));
         }
 
         return textures;
     }
+
+    Texture loadCachedTexture(aiString texturePath, std::string typeName, bool needGammacorrection)
+    {
+        for (unsigned int j = 0; j < textures_loaded.size(); ++j)
+            if (std::strcmp(textures_loaded[j].path.data, texturePath.C_Str()) == 0)
+                return textures_loaded[j];
+
+        Texture texture;
+        texture.id = TextureFromFile(texturePath.C_Str(), directory, needGammacorrection);
+        texture.type = typeName;
+        texture.path = texturePath;
+        textures_loaded.push_back(texture); // add the texture in the textures_loaded vector
+        return texture;
+    }
 };
\ No newline at end of file
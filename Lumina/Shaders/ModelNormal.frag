@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 
 struct Material {
     sampler2D texture_diffuse1;
@@ -24,14 +24,15 @@ struct Attenuation {
 
 struct Dirlight {
     vec3 direction;
-    sampler2D shadowmap;
+    int shadow;
+    vec4 atlas;     // Shadow Atlas Region <offset, scale>
 
     LightAttrib attrib;
 };
 
 struct PointLight {
     vec3 position;
-    samplerCube shadowmap;
+    int shadow;
     float far;
 
     LightAttrib attrib;
@@ -49,7 +50,7 @@ struct SpotLight {
     float outer_cutoff;
 };
 
-const int POINT_LIGHTS_LIMITATION = 8;
+const int POINT_SHADOWS_LIMITATION = 8;
 const int OTHER_LIMITATION = 2;
 
 in VS_OUT {
@@ -72,14 +73,37 @@ uniform Material material;
 
 const float shininess = 32.0;
 
-uniform Dirlight dirlights[OTHER_LIMITATION];
-uniform PointLight pointlights[POINT_LIGHTS_LIMITATION];
-uniform SpotLight spotlights[OTHER_LIMITATION];
+uniform sampler2D dirlight_shadowmaps[OTHER_LIMITATION];
+uniform samplerCube pointlight_shadowmaps[POINT_SHADOWS_LIMITATION];
+
+// Light Storage <std430, packed by LightManager>
+struct Light {
+    vec4 position;      // xyz position, w far plane <point> or cos(outer_cutoff) <spot> | Shadow Atlas Region <dir>
+    vec4 direction;     // xyz direction, w shadow map slot <-1 without>
+    vec4 ambient;       // a: attenuation constant
+    vec4 diffuse;       // a: attenuation linear
+    vec4 specular;      // a: cos(cutoff)
+};
+
+layout (std430, binding = 3) readonly buffer Lights {
+    int num_dirlight;
+    int num_pointlight;
+    int num_spotlight;
+    int num_pointshadow;
+    mat4 DirLight_Transform[OTHER_LIMITATION];
+    int shadow_pointlights[POINT_SHADOWS_LIMITATION];   // PointLight index of each Cube Shadow slot
+    Light lights[];     // DirLights, then PointLights, then SpotLights
+};
+
+Dirlight GetDirLight(int i);
+PointLight GetPointLight(int i);
+SpotLight GetSpotLight(int i);
 
 bool FragmentVisibility();
 bool IsBright(vec3 lightdir, vec3 norm);
 float DepthAdjustment(vec3 lightdir);
 float ShadowFactor(Dirlight light, vec4 light_frag_pos);
+vec2 AtlasClamp(Dirlight light, vec2 coords);
 float ShadowFactor(PointLight light);
 
 uniform bool GammaCorrection;
@@ -101,10 +125,10 @@ void main() {
     vec3 viewDir = normalize(-fs_in.viewspace_fragPos);
     vec3 result = vec3(0.0, 0.0, 0.0);
 
-    // float imp = IsBright(-dirlights[0].direction, norm) ? ShadowFactor(dirlights[0], fs_in.dirlight_fragPos[0]) : 0.0;
-    float imp = IsBright(pointlights[0].position - fs_in.worldspace_fragpos, norm) ? ShadowFactor(pointlights[0]) : 0.0;
-    // float imp = ShadowFactor(pointlights[0]);
-    // float imp = ShadowFactor(dirlights[0], fs_in.dirlight_fragPos[0]);
+    // float imp = IsBright(-GetDirLight(0).direction, norm) ? ShadowFactor(GetDirLight(0), fs_in.dirlight_fragPos[0]) : 0.0;
+    float imp = IsBright(GetPointLight(0).position - fs_in.worldspace_fragpos, norm) ? ShadowFactor(GetPointLight(0)) : 0.0;
+    // float imp = ShadowFactor(GetPointLight(0));
+    // float imp = ShadowFactor(GetDirLight(0), fs_in.dirlight_fragPos[0]);
     imp = imp * 0.6 + 0.4;
 
     result += vec3(imp * texture(material.texture_diffuse1, fs_in.texCoords));
@@ -133,6 +157,9 @@ float ShadowFactor(Dirlight light, vec4 light_frag_pos) {
     vec3 projCoords = light_frag_pos.xyz / light_frag_pos.w;
     // Depth start from 0 to 1
     projCoords = projCoords * 0.5 + 0.5;
+    // Outside the Light's Region counts as lit <the Atlas has no Border of its own>
+    if (projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
+        return 1.0;
 
     // Refinements
     float adjust = DepthAdjustment(light.direction);
@@ -141,10 +168,11 @@ float ShadowFactor(Dirlight light, vec4 light_frag_pos) {
     float shadow = 0.0;
 
     // 25 * Multi Sampling
-    vec2 pixeloffset = 0.3 / textureSize(light.shadowmap, 0);
+    vec2 pixeloffset = 0.3 / textureSize(dirlight_shadowmaps[light.shadow], 0);
+    vec2 center = light.atlas.xy + projCoords.xy * light.atlas.zw;
     for (int x = -2; x <= 2; ++x) {
         for (int y = -2; y <= 2; ++y) {
-            float subdepth = texture(light.shadowmap, projCoords.xy + pixeloffset * vec2(x, y)).r;
+            float subdepth = texture(dirlight_shadowmaps[light.shadow], AtlasClamp(light, center + pixeloffset * vec2(x, y))).r;
             shadow += CurrentDepth > subdepth + adjust ? 1.0 : 0.0;
         }
     }
@@ -181,7 +209,7 @@ float ShadowFactor(PointLight light) {
     float shadow = 0.0;
 
     for (int i = 0; i < samples; ++i) {
-        float subStoppingDepth = texture(light.shadowmap, FragDir + offsets[i] * bias).r;
+        float subStoppingDepth = texture(pointlight_shadowmaps[light.shadow], FragDir + offsets[i] * bias).r;
         subStoppingDepth *= light.far;
         shadow += CurrentDepth > subStoppingDepth + adjust ? 1.0 : 0.0;
     }
@@ -192,4 +220,27 @@ float ShadowFactor(PointLight light) {
         return 0.0;
     
     return 1.0 - shadow;
+}
+
+Dirlight GetDirLight(int i) {
+    Light light = lights[i];
+    return Dirlight(light.direction.xyz, int(light.direction.w), light.position, LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb));
+}
+
+PointLight GetPointLight(int i) {
+    Light light = lights[num_dirlight + i];
+    return PointLight(light.position.xyz, int(light.direction.w), light.position.w,
+                      LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb), Attenuation(light.ambient.a, light.diffuse.a));
+}
+
+SpotLight GetSpotLight(int i) {
+    Light light = lights[num_dirlight + num_pointlight + i];
+    return SpotLight(light.position.xyz, light.direction.xyz, LightAttrib(light.ambient.rgb, light.diffuse.rgb, light.specular.rgb),
+                     Attenuation(light.ambient.a, light.diffuse.a), light.specular.a, light.position.w);
+}
+
+// Keeps Filter Taps inside the Light's own Region
+vec2 AtlasClamp(Dirlight light, vec2 coords) {
+    vec2 half_texel = 0.5 / textureSize(dirlight_shadowmaps[light.shadow], 0);
+    return clamp(coords, light.atlas.xy + half_texel, light.atlas.xy + light.atlas.zw - half_texel);
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
@@ -13,21 +13,28 @@ layout (std140) uniform Matrices {
 };
 
 // Limitations
-const int POINT_LIGHTS_LIMITATION = 8;
+const int POINT_SHADOWS_LIMITATION = 8;
 const int OTHER_LIMITATION = 2;
 
-struct LightInfo {
-    // Amounts
+// Light Storage <std430, packed by LightManager>
+struct Light {
+    vec4 position;      // xyz position, w far plane <point> or cos(outer_cutoff) <spot>
+    vec4 direction;     // xyz direction, w shadow map slot <-1 without>
+    vec4 ambient;       // a: attenuation constant
+    vec4 diffuse;       // a: attenuation linear
+    vec4 specular;      // a: cos(cutoff)
+};
+
+layout (std430, binding = 3) readonly buffer Lights {
     int num_dirlight;
     int num_pointlight;
     int num_spotlight;
-
-    // Transform Matrices
+    int num_pointshadow;
     mat4 DirLight_Transform[OTHER_LIMITATION];
+    int shadow_pointlights[POINT_SHADOWS_LIMITATION];   // PointLight index of each Cube Shadow slot
+    Light lights[];     // DirLights, then PointLights, then SpotLights
 };
 
-uniform LightInfo lightinfo;
-
 out VS_OUT {
     vec3 normal; // view_space normal
     vec3 viewspace_fragPos;
@@ -48,13 +55,13 @@ void main() {
     vs_out.viewspace_fragPos = vec3(view * model * vec4(aPosition, 1.0));
     vs_out.worldspace_fragpos = vec3(model * vec4(aPosition, 1.0));
 
-    vs_out.num_dirlight = lightinfo.num_dirlight;
-    vs_out.num_pointlight = lightinfo.num_pointlight;
-    vs_out.num_spotlight = lightinfo.num_spotlight;
+    vs_out.num_dirlight = num_dirlight;
+    vs_out.num_pointlight = num_pointlight;
+    vs_out.num_spotlight = num_spotlight;
 
     // DirLights
-    for (int i = 0; i < lightinfo.num_dirlight; ++i)
-        vs_out.dirlight_fragPos[i] = lightinfo.DirLight_Transform[i] * model * vec4(aPosition, 1.0);
+    for (int i = 0; i < num_dirlight; ++i)
+        vs_out.dirlight_fragPos[i] = DirLight_Transform[i] * model * vec4(aPosition, 1.0);
 
     vs_out.texCoords = aTexCoords;
     vs_out.view = view;
@@ -0,0 +1,560 @@
+#include "PMXLoader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Read-only View of the whole File <pages are faulted in as the Parser walks forward>
+    class MappedFile
+    {
+    public:
+        const unsigned char *data = nullptr;
+        size_t size = 0;
+
+        MappedFile(const std::string &path)
+        {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return;
+            LARGE_INTEGER length;
+            if (!GetFileSizeEx(file, &length) || length.QuadPart == 0)
+                return;
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!mapping)
+                return;
+            data = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data)
+                size = (size_t)length.QuadPart;
+#else
+            descriptor = open(path.c_str(), O_RDONLY);
+            if (descriptor < 0)
+                return;
+            struct stat status;
+            if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+                return;
+            void *view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (view == MAP_FAILED)
+                return;
+            madvise(view, (size_t)status.st_size, MADV_SEQUENTIAL);
+            data = (const unsigned char *)view;
+            size = (size_t)status.st_size;
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef _WIN32
+            if (data)
+                UnmapViewOfFile(data);
+            if (mapping)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+#else
+            if (data)
+                munmap((void *)data, size);
+            if (descriptor >= 0)
+                close(descriptor);
+#endif
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+    private:
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#else
+        int descriptor = -1;
+#endif
+    };
+
+    // Little-endian Cursor over the Mapping <a short read flags the File as truncated instead of throwing>
+    class PMXReader
+    {
+    public:
+        bool failed = false;
+
+        PMXReader(const unsigned char *data, size_t size) : cursor(data), end(data + size) {}
+
+        template <typename T>
+        T read()
+        {
+            T value{};
+            if ((size_t)(end - cursor) < sizeof(T))
+            {
+                failed = true;
+                cursor = end;
+                return value;
+            }
+            std::memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return value;
+        }
+
+        glm::vec2 vec2()
+        {
+            glm::vec2 value = glm::vec2(0.0f);
+            bytes(&value, sizeof(value));
+            return value;
+        }
+
+        glm::vec3 vec3()
+        {
+            glm::vec3 value = glm::vec3(0.0f);
+            bytes(&value, sizeof(value));
+            return value;
+        }
+
+        glm::vec4 vec4()
+        {
+            glm::vec4 value = glm::vec4(0.0f);
+            bytes(&value, sizeof(value));
+            return value;
+        }
+
+        void bytes(void *dst, size_t count)
+        {
+            if ((size_t)(end - cursor) < count)
+            {
+                failed = true;
+                cursor = end;
+                return;
+            }
+            std::memcpy(dst, cursor, count);
+            cursor += count;
+        }
+
+        void skip(size_t count)
+        {
+            if ((size_t)(end - cursor) < count)
+            {
+                failed = true;
+                cursor = end;
+                return;
+            }
+            cursor += count;
+        }
+
+        // Vertex indices are unsigned for 1 and 2 Bytes, every other index is signed <-1 means none>
+        int vertexIndex(int size)
+        {
+            if (size == 1)
+                return read<uint8_t>();
+            if (size == 2)
+                return read<uint16_t>();
+            return read<int32_t>();
+        }
+
+        int index(int size)
+        {
+            if (size == 1)
+                return read<int8_t>();
+            if (size == 2)
+                return read<int16_t>();
+            return read<int32_t>();
+        }
+
+        // Every String is returned as UTF-8
+        std::string text(bool utf16)
+        {
+            int32_t length = read<int32_t>();
+            if (length <= 0)
+                return std::string();
+            if ((size_t)(end - cursor) < (size_t)length)
+            {
+                failed = true;
+                cursor = end;
+                return std::string();
+            }
+
+            const unsigned char *source = cursor;
+            cursor += length;
+            if (!utf16)
+                return std::string((const char *)source, (size_t)length);
+
+            std::string result;
+            result.reserve((size_t)length);
+            for (int32_t i = 0; i + 1 < length; i += 2)
+            {
+                uint32_t code = source[i] | (source[i + 1] << 8);
+                if (code >= 0xD800 && code < 0xDC00 && i + 3 < length)
+                {
+                    uint32_t low = source[i + 2] | (source[i + 3] << 8);
+                    if (low >= 0xDC00 && low < 0xE000)
+                    {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i += 2;
+                    }
+                }
+
+                if (code < 0x80)
+                    result += (char)code;
+                else if (code < 0x800)
+                {
+                    result += (char)(0xC0 | (code >> 6));
+                    result += (char)(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    result += (char)(0xE0 | (code >> 12));
+                    result += (char)(0x80 | ((code >> 6) & 0x3F));
+                    result += (char)(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    result += (char)(0xF0 | (code >> 18));
+                    result += (char)(0x80 | ((code >> 12) & 0x3F));
+                    result += (char)(0x80 | ((code >> 6) & 0x3F));
+                    result += (char)(0x80 | (code & 0x3F));
+                }
+            }
+            return result;
+        }
+
+    private:
+        const unsigned char *cursor;
+        const unsigned char *end;
+    };
+
+    struct PMXGlobals
+    {
+        bool utf16;
+        int additional_uvs;
+        int vertex_index;
+        int texture_index;
+        int material_index;
+        int bone_index;
+        int morph_index;
+        int rigidbody_index;
+    };
+
+    // PMX is left-handed <DirectX>, the Engine is right-handed: mirror Z, readIndices flips the Winding back to counter-clockwise
+    glm::vec3 mirror(glm::vec3 v)
+    {
+        return glm::vec3(v.x, v.y, -v.z);
+    }
+
+    void readVertices(PMXReader &reader, PMXGlobals &globals, PMXModel &pmx)
+    {
+        int32_t count = reader.read<int32_t>();
+        if (count < 0)
+        {
+            reader.failed = true;
+            return;
+        }
+        pmx.vertices.resize((size_t)count);
+        pmx.skins.resize((size_t)count);
+
+        for (int32_t i = 0; i < count && !reader.failed; ++i)
+        {
+            Vertex &vertex = pmx.vertices[i];
+            vertex.Position = mirror(reader.vec3());
+            vertex.Normal = mirror(reader.vec3());
+            // UV origin is the top-left Texel, which is also Row 0 of the un-flipped stb_image upload
+            vertex.Texcoords = reader.vec2();
+            vertex.Tangent = glm::vec3(0.0f);
+            vertex.BiTangent = glm::vec3(0.0f);
+            reader.skip(16 * (size_t)globals.additional_uvs);
+
+            PMXSkin &skin = pmx.skins[i];
+            skin.Bones = glm::ivec4(-1);
+            skin.Weights = glm::vec4(0.0f);
+            uint8_t deform = reader.read<uint8_t>();
+            switch (deform)
+            {
+            case 0: // BDEF1
+                skin.Bones.x = reader.index(globals.bone_index);
+                skin.Weights.x = 1.0f;
+                break;
+            case 1: // BDEF2
+            case 3: // SDEF <C, R0, R1 skipped>
+                skin.Bones.x = reader.index(globals.bone_index);
+                skin.Bones.y = reader.index(globals.bone_index);
+                skin.Weights.x = reader.read<float>();
+                skin.Weights.y = 1.0f - skin.Weights.x;
+                if (deform == 3)
+                    reader.skip(36);
+                break;
+            case 2: // BDEF4
+            case 4: // QDEF <2.1>
+                for (int j = 0; j < 4; ++j)
+                    skin.Bones[j] = reader.index(globals.bone_index);
+                skin.Weights = reader.vec4();
+                break;
+            default:
+                reader.failed = true;
+                break;
+            }
+
+            reader.skip(4); // edge scale
+        }
+    }
+
+    void readIndices(PMXReader &reader, PMXGlobals &globals, PMXModel &pmx)
+    {
+        int32_t count = reader.read<int32_t>();
+        if (count < 0)
+        {
+            reader.failed = true;
+            return;
+        }
+        pmx.indices.resize((size_t)count);
+
+        // mirror() turns the Faces clockwise, so the second and third Corner of every Triangle trade Places
+        unsigned int vertices = (unsigned int)pmx.vertices.size();
+        for (int32_t i = 0; i < count && !reader.failed; ++i)
+        {
+            unsigned int index = (unsigned int)reader.vertexIndex(globals.vertex_index);
+            int32_t corner = i % 3;
+            int32_t slot = corner != 0 && i - corner + 2 < count ? i - corner + 3 - corner : i;
+            pmx.indices[slot] = index < vertices ? index : 0;
+        }
+    }
+
+    void readTextures(PMXReader &reader, PMXGlobals &globals, PMXModel &pmx)
+    {
+        int32_t count = reader.read<int32_t>();
+        for (int32_t i = 0; i < count && !reader.failed; ++i)
+        {
+            std::string path = reader.text(globals.utf16);
+            for (char &c : path)
+                if (c == '\\')
+                    c = '/';
+            pmx.textures.push_back(path);
+        }
+    }
+
+    void readMaterials(PMXReader &reader, PMXGlobals &globals, PMXModel &pmx)
+    {
+        int32_t count = reader.read<int32_t>();
+        unsigned int first_index = 0;
+        for (int32_t i = 0; i < count && !reader.failed; ++i)
+        {
+            PMXMaterial material;
+            material.name = reader.text(globals.utf16);
+            reader.text(globals.utf16); // universal name
+            material.diffuse = reader.vec4();
+            material.specular = reader.vec3();
+            material.shininess = reader.read<float>();
+            material.ambient = reader.vec3();
+            material.flags = reader.read<uint8_t>();
+            reader.skip(20); // edge colour and size
+            material.texture = reader.index(globals.texture_index);
+            material.sphere = reader.index(globals.texture_index);
+            material.sphere_mode = reader.read<uint8_t>();
+            material.shared_toon = reader.read<uint8_t>() == 1;
+            material.toon = material.shared_toon ? reader.read<uint8_t>() : reader.index(globals.texture_index);
+            reader.text(globals.utf16); // memo
+
+            int32_t index_count = reader.read<int32_t>();
+            material.first_index = first_index;
+            material.index_count = index_count > 0 ? (unsigned int)index_count : 0;
+            if (material.first_index + material.index_count > pmx.indices.size())
+                material.index_count = (unsigned int)pmx.indices.size() - std::min(material.first_index, (unsigned int)pmx.indices.size());
+            first_index += material.index_count;
+
+            pmx.materials.push_back(material);
+        }
+    }
+
+    void readBones(PMXReader &reader, PMXGlobals &globals, PMXModel &pmx)
+    {
+        int32_t count = reader.read<int32_t>();
+        for (int32_t i = 0; i < count && !reader.failed; ++i)
+        {
+            PMXBone bone;
+            bone.name = reader.text(globals.utf16);
+            reader.text(globals.utf16);
+            bone.position = mirror(reader.vec3());
+            bone.parent = reader.index(globals.bone_index);
+            bone.layer = reader.read<int32_t>();
+            bone.flags = reader.read<uint16_t>();
+            bone.inherit_parent = -1;
+            bone.inherit_weight = 0.0f;
+            bone.ik_target = -1;
+
+            if (bone.flags & 0x0001)
+                reader.index(globals.bone_index); // tail bone
+            else
+                reader.skip(12); // tail offset
+            if (bone.flags & (0x0100 | 0x0200))
+            {
+                bone.inherit_parent = reader.index(globals.bone_index);
+                bone.inherit_weight = reader.read<float>();
+            }
+            if (bone.flags & 0x0400)
+                reader.skip(12); // fixed axis
+            if (bone.flags & 0x0800)
+                reader.skip(24); // local X and Z axis
+            if (bone.flags & 0x2000)
+                reader.skip(4); // external parent key
+            if (bone.flags & 0x0020)
+            {
+                bone.ik_target = reader.index(globals.bone_index);
+                reader.skip(8); // loop count and limit angle
+                int32_t links = reader.read<int32_t>();
+                for (int32_t j = 0; j < links && !reader.failed; ++j)
+                {
+                    bone.ik_links.push_back(reader.index(globals.bone_index));
+                    if (reader.read<uint8_t>() == 1)
+                        reader.skip(24); // angle limits
+                }
+            }
+
+            pmx.bones.push_back(bone);
+        }
+    }
+
+    void readMorphs(PMXReader &reader, PMXGlobals &globals, PMXModel &pmx)
+    {
+        int32_t count = reader.read<int32_t>();
+        for (int32_t i = 0; i < count && !reader.failed; ++i)
+        {
+            PMXMorph morph;
+            morph.name = reader.text(globals.utf16);
+            reader.text(globals.utf16);
+            morph.panel = reader.read<uint8_t>();
+            morph.type = reader.read<uint8_t>();
+
+            int32_t offsets = reader.read<int32_t>();
+            if (offsets > 0)
+                morph.offsets.reserve((size_t)offsets);
+            for (int32_t j = 0; j < offsets && !reader.failed; ++j)
+            {
+                PMXMorphOffset offset;
+                offset.a = glm::vec4(0.0f);
+                offset.b = glm::vec4(0.0f);
+                switch (morph.type)
+                {
+                case 0: // group
+                case 9: // flip
+                    offset.index = reader.index(globals.morph_index);
+                    offset.a.x = reader.read<float>();
+                    break;
+                case 1: // vertex
+                    offset.index = reader.vertexIndex(globals.vertex_index);
+                    offset.a = glm::vec4(mirror(reader.vec3()), 0.0f);
+                    break;
+                case 2: // bone <mirroring Z negates the X and Y parts of the Rotation>
+                    offset.index = reader.index(globals.bone_index);
+                    offset.a = glm::vec4(mirror(reader.vec3()), 0.0f);
+                    offset.b = reader.vec4();
+                    offset.b.x = -offset.b.x;
+                    offset.b.y = -offset.b.y;
+                    break;
+                case 3:
+                case 4:
+                case 5:
+                case 6:
+                case 7: // uv and additional uv
+                    offset.index = reader.vertexIndex(globals.vertex_index);
+                    offset.a = reader.vec4();
+                    break;
+                case 8: // material <operation byte stored in b.x>
+                    offset.index = reader.index(globals.material_index);
+                    offset.b.x = reader.read<uint8_t>();
+                    offset.a = reader.vec4();
+                    reader.skip(96); // specular, ambient, edge and texture tints
+                    break;
+                case 10: // impulse <2.1>
+                    offset.index = reader.index(globals.rigidbody_index);
+                    reader.skip(1); // local flag
+                    offset.a = glm::vec4(reader.vec3(), 0.0f);
+                    offset.b = glm::vec4(reader.vec3(), 0.0f);
+                    break;
+                default:
+                    reader.failed = true;
+                    break;
+                }
+                morph.offsets.push_back(offset);
+            }
+
+            pmx.morphs.push_back(morph);
+        }
+    }
+}
+
+bool LoadPMX(const std::string &path, PMXModel &pmx)
+{
+    MappedFile file(path);
+    if (!file.data)
+    {
+        std::cout << "ERROR::PMX::FILE_NOT_MAPPED::" << path << std::endl;
+        return false;
+    }
+
+    PMXReader reader(file.data, file.size);
+
+    char magic[4];
+    reader.bytes(magic, 4);
+    pmx.version = reader.read<float>();
+    if (reader.failed || std::memcmp(magic, "PMX ", 4) != 0 || (pmx.version != 2.0f && pmx.version != 2.1f))
+    {
+        std::cout << "ERROR::PMX::UNSUPPORTED_HEADER::" << path << std::endl;
+        return false;
+    }
+
+    uint8_t global_count = reader.read<uint8_t>();
+    uint8_t globals_raw[8] = {0, 0, 4, 4, 4, 4, 4, 4};
+    for (int i = 0; i < global_count; ++i)
+    {
+        uint8_t value = reader.read<uint8_t>();
+        if (i < 8)
+            globals_raw[i] = value;
+    }
+
+    PMXGlobals globals;
+    globals.utf16 = globals_raw[0] == 0;
+    globals.additional_uvs = std::min((int)globals_raw[1], 4);
+    globals.vertex_index = globals_raw[2];
+    globals.texture_index = globals_raw[3];
+    globals.material_index = globals_raw[4];
+    globals.bone_index = globals_raw[5];
+    globals.morph_index = globals_raw[6];
+    globals.rigidbody_index = globals_raw[7];
+
+    pmx.name = reader.text(globals.utf16);
+    reader.text(globals.utf16); // universal name
+    reader.text(globals.utf16); // comments
+    reader.text(globals.utf16);
+
+    readVertices(reader, globals, pmx);
+    readIndices(reader, globals, pmx);
+    readTextures(reader, globals, pmx);
+    readMaterials(reader, globals, pmx);
+    readBones(reader, globals, pmx);
+    readMorphs(reader, globals, pmx);
+
+    if (reader.failed)
+    {
+        std::cout << "ERROR::PMX::TRUNCATED_OR_CORRUPTED::" << path << std::endl;
+        return false;
+    }
+
+#ifdef _MODEL_DEBUG
+    std::cout << std::endl;
+    std::cout << "MANUAL_DEBUG::PMX_DATA" << std::endl;
+    std::cout << "Version: " << pmx.version << (globals.utf16 ? " (UTF-16)" : " (UTF-8)") << std::endl;
+    std::cout << pmx.vertices.size() << " Vertices, " << pmx.indices.size() << " Indices, " << pmx.materials.size() << " Materials" << std::endl;
+    std::cout << pmx.bones.size() << " Bones, " << pmx.morphs.size() << " Morphs" << std::endl;
+#endif
+
+    return true;
+}
@@ -0,0 +1,81 @@
+// Native PMX 2.0/2.1 Loader: decodes a memory-mapped File straight into the Engine's Vertex Layout
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "Mesh.hpp"
+
+// Bone Weights of one Vertex <SDEF and QDEF are kept as their linear Blend>
+struct PMXSkin
+{
+    glm::ivec4 Bones;
+    glm::vec4 Weights;
+};
+
+struct PMXMaterial
+{
+    std::string name;
+    glm::vec4 diffuse;
+    glm::vec3 specular;
+    float shininess;
+    glm::vec3 ambient;
+    unsigned char flags;    // 0x01 double sided, 0x02 ground shadow, 0x04 casts, 0x08 receives, 0x10 edge
+    int texture;            // indices into PMXModel::textures <-1 for none>
+    int sphere;
+    unsigned char sphere_mode;  // 0 off, 1 multiply, 2 add, 3 sub texture
+    bool shared_toon;       // toon is one of the built-in toon01~10 Ramps instead of a Texture index
+    int toon;
+    unsigned int first_index;
+    unsigned int index_count;
+};
+
+struct PMXBone
+{
+    std::string name;
+    glm::vec3 position;
+    int parent;
+    int layer;
+    unsigned short flags;
+    int inherit_parent;     // -1 without inherited Rotation / Translation
+    float inherit_weight;
+    int ik_target;          // -1 for non-IK Bones
+    std::vector<int> ik_links;
+};
+
+// Meaning of the Payload depends on the Morph type
+// <vertex: a.xyz offset | uv: a | bone: a.xyz translation, b rotation | group, flip: a.x weight | material: a diffuse | impulse: a.xyz velocity, b.xyz torque>
+struct PMXMorphOffset
+{
+    int index;
+    glm::vec4 a;
+    glm::vec4 b;
+};
+
+struct PMXMorph
+{
+    std::string name;
+    int panel;
+    int type;   // 0 group, 1 vertex, 2 bone, 3 uv, 4~7 additional uv, 8 material, 9 flip, 10 impulse
+    std::vector<PMXMorphOffset> offsets;
+};
+
+struct PMXModel
+{
+    float version;
+    std::string name;
+
+    // Engine Layout <Z mirrored to the right-handed Frame, Tangents left to the Caller>
+    std::vector<Vertex> vertices;
+    std::vector<PMXSkin> skins;
+    std::vector<unsigned int> indices;
+
+    std::vector<std::string> textures;  // relative to the Model directory, '/' separated
+    std::vector<PMXMaterial> materials;
+    std::vector<PMXBone> bones;
+    std::vector<PMXMorph> morphs;
+};
+
+// Display Frames, Rigid Bodies and Joints after the Morphs are not read
+bool LoadPMX(const std::string &path, PMXModel &pmx);
@@ -0,0 +1,13 @@
+#version 330 core
+// One Cube Face per Draw <Casters are culled per Face on the CPU instead of amplified by CubeDepth.geom>
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 Face_Matrix;
+
+out vec4 FragPos;
+
+void main() {
+    FragPos = model * vec4(aPos, 1.0);
+    gl_Position = Face_Matrix * FragPos;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#version 330 core
+
+// Post Effects in one Pass. PostCompositor.hpp defines the enabled Effects below the #version Line, every Combination
+// is its own Variant without runtime Branches:
+// POST_KERNEL (with POST_KERNEL_WEIGHTS) POST_BLOOM POST_EXPOSURE POST_INVERSION POST_GRAYSCALE POST_GAMMA
+
+out vec4 FragColor;
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+uniform sampler2D ScreenTexture;
+
+#ifdef POST_BLOOM
+uniform sampler2D bloomblur;    // Level 0 of the Bloom Chain <BloomTools.hpp>
+uniform float bloom_strength;
+#endif
+
+#ifdef POST_EXPOSURE
+uniform float exposure;
+#endif
+
+const float Gamma = 2.2;
+
+void main() {
+    // the Center Tap is fetched once and shared by the Kernel and the Effects reading the Pixel itself
+    vec3 center = texture(ScreenTexture, fs_in.texCoords).rgb;
+
+#ifdef POST_KERNEL
+    // 3 * 3 Neighbourhood, Taps whose baked Weight is 0 are folded away by the Compiler
+    const float weights[9] = float[] (POST_KERNEL_WEIGHTS);
+    vec2 texel = 1.0 / vec2(textureSize(ScreenTexture, 0));
+    vec3 color = center * weights[4];
+    for (int i = 0; i < 9; ++i) {
+        if (i == 4 || weights[i] == 0.0)
+            continue;
+        vec2 offset = vec2(float(i / 3 - 1), float(i % 3 - 1)) * texel;
+        color += weights[i] * texture(ScreenTexture, fs_in.texCoords + offset).rgb;
+    }
+#else
+    vec3 color = center;
+#endif
+
+#ifdef POST_BLOOM
+    color += bloom_strength * texture(bloomblur, fs_in.texCoords).rgb;
+#endif
+
+#ifdef POST_EXPOSURE
+    color = vec3(1.0) - exp(-color * exposure);
+#endif
+
+#ifdef POST_INVERSION
+    color = 1.0 - color;
+#endif
+
+#ifdef POST_GRAYSCALE
+    color = vec3((0.2162 * color.r + 0.7152 * color.g + 0.0772 * color.b) / 3.0);
+#endif
+
+#ifdef POST_GAMMA
+    color = pow(color, vec3(1.0 / Gamma));
+#endif
+
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,125 @@
+// Post Effects fused into one Full-Screen Pass: every Combination of enabled Effects compiles its own Variant of
+// PostCompositor.frag on first Use, with the Convolution Kernel baked in as Constants
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../imgui/imgui.h"
+#include "../Shader.hpp"
+
+// Bits of an Effect Combination, applied in this Order
+enum PostEffect
+{
+    POST_KERNEL = 1 << 0,       // set by the Compositor from the Kernel Index
+    POST_BLOOM = 1 << 1,
+    POST_EXPOSURE = 1 << 2,
+    POST_INVERSION = 1 << 3,
+    POST_GRAYSCALE = 1 << 4,
+    POST_GAMMA = 1 << 5
+};
+
+// Kernel Index as in HDR.frag: 0::NoEffect 1::Sharpen 2::Blur 3::EdgeDetection
+const int POST_KERNEL_COUNT = 4;
+const float POST_KERNELS[POST_KERNEL_COUNT][9] = {
+    {0, 0, 0, 0, 1, 0, 0, 0, 0},
+    {-1, -1, -1, -1, 9, -1, -1, -1, -1},
+    {1.0f / 16, 2.0f / 16, 1.0f / 16, 2.0f / 16, 4.0f / 16, 2.0f / 16, 1.0f / 16, 2.0f / 16, 1.0f / 16},
+    {1, 1, 1, 1, -8, 1, 1, 1, 1}
+};
+
+class PostCompositor
+{
+public:
+    PostCompositor(const std::string &vertex_path, const std::string &fragment_path)
+    {
+        this->vertex_path = vertex_path;
+        this->fragment_path = fragment_path;
+        viewport_scale = glm::vec2(1.0f);
+        current = 0;
+    }
+
+    void Delete()
+    {
+        for (auto &variant : variants)
+        {
+            glDeleteProgram(variant.second->ID);
+            delete variant.second;
+        }
+        variants.clear();
+    }
+
+    // Dynamic Resolution: the Source fills only this Fraction of its Texture
+    void ViewportScale(glm::vec2 scale)
+    {
+        viewport_scale = scale;
+    }
+
+    // Puts the Variant for the Effects <PostEffect Bits> and Kernel in Use, the Source goes on GL_TEXTURE0
+    Shader *Use(unsigned int effects, int kernel = 0)
+    {
+        effects &= ~POST_KERNEL;
+        if (kernel > 0 && kernel < POST_KERNEL_COUNT)
+            effects |= POST_KERNEL;
+        else
+            kernel = 0;
+        current = effects | kernel << 8;
+
+        Shader *shader;
+        auto found = variants.find(current);
+        if (found == variants.end())
+        {
+            shader = new Shader(vertex_path.c_str(), fragment_path.c_str(), defines(effects, kernel));
+            variants[current] = shader;
+        }
+        else
+            shader = found->second;
+
+        shader->Use();
+        shader->setInt("ScreenTexture", 0);
+        shader->setVec2("viewport_scale", viewport_scale);
+        return shader;
+    }
+
+    void ImGuiStatus()
+    {
+        static const char *names[] = {"Kernel", "Bloom", "Exposure", "Inversion", "Grayscale", "Gamma"};
+        std::string enabled;
+        for (int i = 0; i < 6; ++i)
+            if (current & (1u << i))
+                enabled += (enabled.empty() ? "" : " + ") + std::string(names[i]);
+        ImGui::BulletText("Post Variants:%d Current:%s", (int)variants.size(), enabled.empty() ? "Copy" : enabled.c_str());
+    }
+
+private:
+    std::string vertex_path;
+    std::string fragment_path;
+    std::map<unsigned int, Shader *> variants;     // Effect Bits | Kernel Index << 8
+    glm::vec2 viewport_scale;
+    unsigned int current;
+
+    static std::vector<std::string> defines(unsigned int effects, int kernel)
+    {
+        std::vector<std::string> result;
+        if (effects & POST_KERNEL)
+        {
+            result.push_back("POST_KERNEL");
+            std::string weights = "POST_KERNEL_WEIGHTS ";
+            for (int i = 0; i < 9; ++i)
+                weights += (i ? ", " : "") + std::to_string(POST_KERNELS[kernel][i]);
+            result.push_back(weights);
+        }
+        if (effects & POST_BLOOM)
+            result.push_back("POST_BLOOM");
+        if (effects & POST_EXPOSURE)
+            result.push_back("POST_EXPOSURE");
+        if (effects & POST_INVERSION)
+            result.push_back("POST_INVERSION");
+        if (effects & POST_GRAYSCALE)
+            result.push_back("POST_GRAYSCALE");
+        if (effects & POST_GAMMA)
+            result.push_back("POST_GAMMA");
+        return result;
+    }
+};
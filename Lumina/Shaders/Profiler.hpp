@@ -0,0 +1,206 @@
+// GPU Time per named Section through GL_TIME_ELAPSED Queries, Fragment Counts through GL_SAMPLES_PASSED
+// Results are read a few Frames later so the CPU never waits on the GPU
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+#include "../imgui/imgui.h"
+
+// Frames a Query may stay in Flight before its Slot is reused
+const int PROFILER_LATENCY = 4;
+
+class Profiler
+{
+public:
+    float Smoothing;    // Weight of the newest Result in the shown Average
+
+    Profiler(float smoothing = 0.1f)
+    {
+        Smoothing = smoothing;
+        frame = 0;
+        open = -1;
+        open_samples = -1;
+    }
+
+    void Delete()
+    {
+        for (Section &section : sections)
+        {
+            glDeleteQueries(PROFILER_LATENCY, section.queries);
+            glDeleteQueries(PROFILER_LATENCY, section.sample_queries);
+        }
+    }
+
+    // Sections can't nest <only one GL_TIME_ELAPSED Query may be active>
+    void Begin(const std::string &name)
+    {
+        if (open >= 0)
+        {
+            std::cout << "ERROR::PROFILER::BEGIN:: Section " << sections[open].name << " is still open." << std::endl;
+            return;
+        }
+
+        open = find(name);
+        Section &section = sections[open];
+        int slot = frame % PROFILER_LATENCY;
+        // the Slot's old Result is dropped when the GPU is this far behind
+        section.pending[slot] = true;
+        glBeginQuery(GL_TIME_ELAPSED, section.queries[slot]);
+    }
+
+    void End()
+    {
+        if (open < 0)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        open = -1;
+    }
+
+    // Fragments passing the Depth and Stencil Tests, may run inside a timed Section <not inside another Sample Section>
+    void BeginSamples(const std::string &name)
+    {
+        if (open_samples >= 0)
+        {
+            std::cout << "ERROR::PROFILER::BEGIN_SAMPLES:: Section " << sections[open_samples].name << " is still open." << std::endl;
+            return;
+        }
+
+        open_samples = find(name);
+        Section &section = sections[open_samples];
+        int slot = frame % PROFILER_LATENCY;
+        section.sample_pending[slot] = true;
+        glBeginQuery(GL_SAMPLES_PASSED, section.sample_queries[slot]);
+    }
+
+    void EndSamples()
+    {
+        if (open_samples < 0)
+            return;
+        glEndQuery(GL_SAMPLES_PASSED);
+        open_samples = -1;
+    }
+
+    // Counters shown next to the Timers <Draws, Casters...>, reset by Collect
+    void Count(const std::string &name, int amount)
+    {
+        sections[find(name)].count += amount;
+    }
+
+    // Once per Frame after the last Section
+    void Collect()
+    {
+        for (Section &section : sections)
+        {
+            for (int slot = 0; slot < PROFILER_LATENCY; ++slot)
+            {
+                if (!section.pending[slot])
+                    continue;
+                int available = 0;
+                glGetQueryObjectiv(section.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    continue;
+
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(section.queries[slot], GL_QUERY_RESULT, &ns);
+                double ms = ns / 1000000.0;
+                section.ms = section.measured ? section.ms + Smoothing * (ms - section.ms) : ms;
+                section.measured = true;
+                section.pending[slot] = false;
+            }
+            for (int slot = 0; slot < PROFILER_LATENCY; ++slot)
+            {
+                if (!section.sample_pending[slot])
+                    continue;
+                int available = 0;
+                glGetQueryObjectiv(section.sample_queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    continue;
+
+                GLuint64 samples = 0;
+                glGetQueryObjectui64v(section.sample_queries[slot], GL_QUERY_RESULT, &samples);
+                section.samples = section.sampled ? section.samples + Smoothing * (samples - section.samples) : samples;
+                section.sampled = true;
+                section.sample_pending[slot] = false;
+            }
+            section.last_count = section.count;
+            section.count = 0;
+        }
+        ++frame;
+    }
+
+    double ServeTime(const std::string &name)
+    {
+        for (Section &section : sections)
+            if (section.name == name)
+                return section.ms;
+        return 0.0;
+    }
+
+    double ServeSamples(const std::string &name)
+    {
+        for (Section &section : sections)
+            if (section.name == name)
+                return section.samples;
+        return 0.0;
+    }
+
+    int ServeCount(const std::string &name)
+    {
+        for (Section &section : sections)
+            if (section.name == name)
+                return section.last_count;
+        return 0;
+    }
+
+    void ImGuiStatus()
+    {
+        ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "GPU Profiler:");
+        for (Section &section : sections)
+        {
+            if (section.measured)
+                ImGui::BulletText("%s: %.3fms", section.name.c_str(), section.ms);
+            if (section.sampled)
+                ImGui::BulletText("%s: %.2fM Fragments", section.name.c_str(), section.samples / 1000000.0);
+            if (section.last_count > 0)
+                ImGui::BulletText("%s: %d", section.name.c_str(), section.last_count);
+        }
+    }
+
+private:
+    struct Section
+    {
+        std::string name;
+        unsigned int queries[PROFILER_LATENCY];
+        bool pending[PROFILER_LATENCY] = {};
+        bool measured = false;
+        double ms = 0.0;
+        int count = 0;
+        int last_count = 0;
+        unsigned int sample_queries[PROFILER_LATENCY];
+        bool sample_pending[PROFILER_LATENCY] = {};
+        bool sampled = false;
+        double samples = 0.0;
+    };
+
+    std::vector<Section> sections;
+    int frame;
+    int open;
+    int open_samples;
+
+    // Sections keep the Order they were first used in
+    int find(const std::string &name)
+    {
+        for (size_t i = 0; i < sections.size(); ++i)
+            if (sections[i].name == name)
+                return i;
+
+        sections.push_back(Section());
+        sections.back().name = name;
+        glGenQueries(PROFILER_LATENCY, sections.back().queries);
+        glGenQueries(PROFILER_LATENCY, sections.back().sample_queries);
+        return sections.size() - 1;
+    }
+};
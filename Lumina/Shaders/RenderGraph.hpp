@@ -0,0 +1,445 @@
+// Declarative Frame: Passes name the Resources they read and write, Compile derives the Order from them, culls Passes
+// nobody consumes, and gives every transient Target a Lifetime so the Pool can hand it to a later Pass asking for
+// the same Key. Rebuilt every Frame
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <iostream>
+
+#include "../imgui/imgui.h"
+#include "./RenderTargetPool.hpp"
+#include "./Profiler.hpp"
+
+// Fixed Function State a Pass runs with, applied in full by the Graph before every Pass. Shaders and Texture Units
+// stay with the Pass <it binds what it reads>, Tools it calls may change more of the State for their own Draws
+struct PassState
+{
+    bool depth_test = false;
+    bool blend = false;
+    bool stencil_test = false;
+    GLenum depth_func = GL_LEQUAL;
+    bool depth_write = true;
+    bool color_write = true;
+    GLenum blend_src = GL_SRC_ALPHA;
+    GLenum blend_dst = GL_ONE_MINUS_SRC_ALPHA;
+    GLenum stencil_func = GL_ALWAYS;
+    int stencil_ref = 0;
+    GLenum stencil_pass = GL_KEEP;          // Stencil Op when Stencil and Depth Test pass
+    unsigned int stencil_write = 0xFF;      // Stencil Mask, also for Clears
+};
+
+class RenderGraph;
+
+// Handed to a Pass' Setup to declare what it touches
+class PassBuilder
+{
+public:
+    PassBuilder(RenderGraph *graph, int pass) : graph(graph), pass(pass) {}
+
+    void Read(int resource);
+    void Write(int resource);
+    void State(PassState state);
+    // Never culled <Shadow Map Updates, Uploads...>
+    void SideEffect();
+
+private:
+    RenderGraph *graph;
+    int pass;
+};
+
+class RenderGraph
+{
+    friend class PassBuilder;
+
+public:
+    RenderGraph(RenderTargetPool *pool, Profiler *profiler = nullptr)
+    {
+        this->pool = pool;
+        this->profiler = profiler;
+    }
+
+    // Drops the last Frame's Passes and Resources <Targets were handed back in Execute>
+    void Reset()
+    {
+        passes.clear();
+        resources.clear();
+        order.clear();
+        compiled = false;
+    }
+
+    // a Target living outside the Graph, drawn into through its FrameBuffer <0 is the Default FrameBuffer>
+    int ImportTarget(const std::string &name, unsigned int fbo, int width, int height, unsigned int texture = 0)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.kind = IMPORTED_TARGET;
+        resource.fbo = fbo;
+        resource.texture = texture;
+        resource.width = width;
+        resource.height = height;
+        resources.push_back(resource);
+        return resources.size() - 1;
+    }
+
+    // Data the Passes bind themselves <Shadow Maps, Buffers>, only orders and keeps its Writers
+    int Import(const std::string &name)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.kind = IMPORTED_DATA;
+        resources.push_back(resource);
+        return resources.size() - 1;
+    }
+
+    // Taken from the Pool before its first Pass and given back after its last one
+    int Transient(const std::string &name, int width, int height, GLenum format, int samples = 1)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.kind = TRANSIENT;
+        resource.width = width;
+        resource.height = height;
+        resource.format = format;
+        resource.samples = samples;
+        resources.push_back(resource);
+        return resources.size() - 1;
+    }
+
+    // Passes writing the Resource draw into its lower left width * height only <Dynamic Resolution>
+    void Region(int resource, int width, int height)
+    {
+        resources[resource].region_width = width;
+        resources[resource].region_height = height;
+    }
+
+    // What the Frame is for, every Pass it doesn't depend on is culled
+    void Present(int resource)
+    {
+        resources[resource].output = true;
+    }
+
+    void AddPass(const std::string &name, std::function<void(PassBuilder &)> setup, std::function<void(RenderGraph &)> execute)
+    {
+        Pass pass;
+        pass.name = name;
+        pass.execute = execute;
+        passes.push_back(pass);
+
+        PassBuilder builder(this, passes.size() - 1);
+        setup(builder);
+        compiled = false;
+    }
+
+    void Compile()
+    {
+        cull();
+        sort();
+        lifetimes();
+        compiled = true;
+    }
+
+    void Execute()
+    {
+        if (!compiled)
+            Compile();
+
+        for (size_t step = 0; step < order.size(); ++step)
+        {
+            Pass &pass = passes[order[step]];
+
+            for (size_t r = 0; r < resources.size(); ++r)
+                if (resources[r].kind == TRANSIENT && resources[r].first == (int)step)
+                    resources[r].target = pool->Acquire(resources[r].width, resources[r].height, resources[r].format, resources[r].samples);
+
+            apply(pass);
+            if (profiler)
+                profiler->Begin(pass.name);
+            pass.execute(*this);
+            if (profiler)
+                profiler->End();
+
+            for (size_t r = 0; r < resources.size(); ++r)
+                if (resources[r].kind == TRANSIENT && resources[r].last == (int)step)
+                {
+                    pool->Release(resources[r].target);
+                    resources[r].target = nullptr;
+                }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Inside a Pass: the Pool Target behind a transient Resource
+    RenderTarget *Target(int resource)
+    {
+        return resources[resource].target;
+    }
+
+    // Inside a Pass: the Color Texture behind a Resource
+    unsigned int Texture(int resource)
+    {
+        Resource &r = resources[resource];
+        if (r.kind == TRANSIENT)
+            return r.target ? r.target->texture : 0;
+        return r.texture;
+    }
+
+    // GPU Time of the executed Passes <as smoothed by the Profiler>
+    double ServeTime()
+    {
+        double ms = 0.0;
+        if (profiler)
+            for (int index : order)
+                ms += profiler->ServeTime(passes[index].name);
+        return ms;
+    }
+
+    bool Culled(const std::string &name)
+    {
+        for (Pass &pass : passes)
+            if (pass.name == name)
+                return pass.culled;
+        return true;
+    }
+
+    void ImGuiStatus()
+    {
+        ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Render Graph:");
+        std::string executed, culled;
+        for (int index : order)
+            executed += (executed.empty() ? "" : " > ") + passes[index].name;
+        for (Pass &pass : passes)
+            if (pass.culled)
+                culled += (culled.empty() ? "" : ", ") + pass.name;
+        ImGui::TextWrapped("Order: %s", executed.c_str());
+        ImGui::BulletText("Passes:%d Culled:%d", (int)order.size(), (int)(passes.size() - order.size()));
+        if (!culled.empty())
+            ImGui::TextWrapped("Culled: %s", culled.c_str());
+    }
+
+private:
+    enum ResourceKind
+    {
+        IMPORTED_TARGET,
+        IMPORTED_DATA,
+        TRANSIENT
+    };
+
+    struct Resource
+    {
+        std::string name;
+        ResourceKind kind;
+        unsigned int fbo = 0;
+        unsigned int texture = 0;
+        int width = 0;
+        int height = 0;
+        GLenum format = GL_RGBA8;
+        int samples = 1;
+        int region_width = 0;       // 0 draws the whole Target
+        int region_height = 0;
+        bool output = false;
+
+        // Steps of the compiled Order, -1 when no live Pass touches it
+        int first = -1;
+        int last = -1;
+        RenderTarget *target = nullptr;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        std::function<void(RenderGraph &)> execute;
+        std::vector<int> reads;
+        std::vector<int> writes;
+        PassState state;
+        bool side_effect = false;
+        bool culled = false;
+    };
+
+    RenderTargetPool *pool;
+    Profiler *profiler;
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<int> order;
+    bool compiled = false;
+
+    static bool contains(const std::vector<int> &list, int value)
+    {
+        for (int v : list)
+            if (v == value)
+                return true;
+        return false;
+    }
+
+    // A Pass lives if it has Side Effects, writes an Output or writes something a living Pass reads
+    void cull()
+    {
+        std::vector<int> stack;
+        for (size_t p = 0; p < passes.size(); ++p)
+        {
+            passes[p].culled = true;
+            bool live = passes[p].side_effect;
+            for (int w : passes[p].writes)
+                live = live || resources[w].output;
+            if (live)
+            {
+                passes[p].culled = false;
+                stack.push_back(p);
+            }
+        }
+
+        // only Writers declared before a Reader feed it <sort>
+        while (!stack.empty())
+        {
+            int reader = stack.back();
+            Pass &pass = passes[reader];
+            stack.pop_back();
+            for (int r : pass.reads)
+                for (int p = 0; p < reader; ++p)
+                {
+                    if (!passes[p].culled || !contains(passes[p].writes, r))
+                        continue;
+                    passes[p].culled = false;
+                    stack.push_back(p);
+                }
+        }
+    }
+
+    // Per Resource in Declaration Order: a Pass reads what the last Writer declared before it wrote, and the next
+    // Writer waits for every Reader in between. Readers declared before the first Writer see the Contents from
+    // before the Frame. The rest is free and falls back to the Order of Declaration
+    void sort()
+    {
+        std::vector<std::vector<int>> after(passes.size());
+        std::vector<int> incoming(passes.size(), 0);
+        auto edge = [&](int from, int to) {
+            if (from == to || passes[from].culled || passes[to].culled || contains(after[from], to))
+                return;
+            after[from].push_back(to);
+            ++incoming[to];
+        };
+
+        for (size_t r = 0; r < resources.size(); ++r)
+        {
+            int writer = -1;
+            std::vector<int> readers;   // since the last Writer
+            for (size_t p = 0; p < passes.size(); ++p)
+            {
+                if (passes[p].culled)
+                    continue;
+                bool writes = contains(passes[p].writes, r);
+                bool reads = contains(passes[p].reads, r);
+                if (writer >= 0 && (writes || reads))
+                    edge(writer, p);
+                if (writes)
+                {
+                    for (int reader : readers)
+                        edge(reader, p);
+                    readers.clear();
+                    writer = p;
+                }
+                else if (reads)
+                    readers.push_back(p);
+            }
+        }
+
+        order.clear();
+        std::vector<bool> done(passes.size(), false);
+        for (size_t p = 0; p < passes.size(); ++p)
+            done[p] = passes[p].culled;
+        while (true)
+        {
+            int next = -1;
+            for (size_t p = 0; p < passes.size() && next < 0; ++p)
+                if (!done[p] && incoming[p] == 0)
+                    next = p;
+            if (next < 0)
+                break;
+            done[next] = true;
+            order.push_back(next);
+            for (int to : after[next])
+                --incoming[to];
+        }
+
+        for (size_t p = 0; p < passes.size(); ++p)
+            if (!done[p])
+            {
+                std::cout << "ERROR::RENDER_GRAPH::COMPILE:: Pass " << passes[p].name << " is part of a Cycle and is skipped." << std::endl;
+                passes[p].culled = true;
+            }
+    }
+
+    void lifetimes()
+    {
+        for (Resource &resource : resources)
+            resource.first = resource.last = -1;
+
+        for (size_t step = 0; step < order.size(); ++step)
+        {
+            Pass &pass = passes[order[step]];
+            auto touch = [&](int r) {
+                if (resources[r].first < 0)
+                    resources[r].first = step;
+                resources[r].last = step;
+            };
+            for (int r : pass.reads)
+                touch(r);
+            for (int w : pass.writes)
+                touch(w);
+        }
+    }
+
+    // Binds the first written Target with its Viewport <or Region> and sets the declared State
+    void apply(Pass &pass)
+    {
+        for (int w : pass.writes)
+        {
+            Resource &resource = resources[w];
+            if (resource.kind == IMPORTED_DATA)
+                continue;
+            glBindFramebuffer(GL_FRAMEBUFFER, resource.kind == TRANSIENT ? resource.target->ID : resource.fbo);
+            if (resource.region_width > 0)
+                glViewport(0, 0, resource.region_width, resource.region_height);
+            else
+                glViewport(0, 0, resource.width, resource.height);
+            break;
+        }
+
+        // Passes may leave any State behind, so all of it is set every Time
+        PassState &state = pass.state;
+        state.depth_test ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+        state.blend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+        state.stencil_test ? glEnable(GL_STENCIL_TEST) : glDisable(GL_STENCIL_TEST);
+        glDepthFunc(state.depth_func);
+        glDepthMask(state.depth_write ? GL_TRUE : GL_FALSE);
+        GLboolean color = state.color_write ? GL_TRUE : GL_FALSE;
+        glColorMask(color, color, color, color);
+        glBlendFunc(state.blend_src, state.blend_dst);
+        glStencilFunc(state.stencil_func, state.stencil_ref, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, state.stencil_pass);
+        glStencilMask(state.stencil_write);
+    }
+};
+
+inline void PassBuilder::Read(int resource)
+{
+    if (!RenderGraph::contains(graph->passes[pass].reads, resource))
+        graph->passes[pass].reads.push_back(resource);
+}
+
+inline void PassBuilder::Write(int resource)
+{
+    if (!RenderGraph::contains(graph->passes[pass].writes, resource))
+        graph->passes[pass].writes.push_back(resource);
+}
+
+inline void PassBuilder::State(PassState state)
+{
+    graph->passes[pass].state = state;
+}
+
+inline void PassBuilder::SideEffect()
+{
+    graph->passes[pass].side_effect = true;
+}
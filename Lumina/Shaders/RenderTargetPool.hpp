@@ -0,0 +1,260 @@
+// Transient Render Targets shared between Passes: a Target released by one Pass is handed to the next Pass asking for
+// the same Size, Format and Samples. Only exact Keys are reused, Targets of different Formats or Sizes never share
+// Memory <core GL has no Way to place two Textures in one Allocation>, so e.g. SSAO R8 and Bloom RGB16F stay apart.
+// Callers get Reuse by giving Targets with disjoint Lifetimes the same Key
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../imgui/imgui.h"
+#include "./FrameBuffer.hpp"
+
+// Frames a free Target is kept before its Memory is given back <toggled Effects don't reallocate every Frame>
+const int RENDER_TARGET_IDLE_FRAMES = 120;
+
+// One Color Attachment and its FrameBuffer, owned by the Pool
+struct RenderTarget
+{
+    unsigned int ID;        // FrameBuffer
+    unsigned int texture;
+    int width;
+    int height;
+    GLenum format;
+    int samples;
+};
+
+class RenderTargetPool
+{
+public:
+    RenderTargetPool()
+    {
+        frame = 0;
+        allocated_bytes = 0;
+        peak_bytes = 0;
+        requested_bytes = 0;
+        last_requested_bytes = 0;
+        peak_requested_bytes = 0;
+        live_bytes = 0;
+        peak_live_bytes = 0;
+
+        // one Screen Quad for every Pass instead of a VAO per FrameBuffer
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertces), &Vertces, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void Delete()
+    {
+        for (Entry &entry : entries)
+            destroy(entry);
+        entries.clear();
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+    }
+
+    // The Target stays the Caller's until Release <its Contents are undefined on Acquire>
+    RenderTarget *Acquire(int width, int height, GLenum format, int samples = 1)
+    {
+        requested_bytes += bytes(width, height, format, samples);
+
+        Entry *picked = nullptr;
+        for (Entry &entry : entries)
+        {
+            RenderTarget &target = *entry.target;
+            if (entry.in_use || target.width != width || target.height != height || target.format != format || target.samples != samples)
+                continue;
+            picked = &entry;
+            break;
+        }
+
+        if (!picked)
+        {
+            entries.push_back(create(width, height, format, samples));
+            picked = &entries.back();
+        }
+
+        picked->in_use = true;
+        picked->last_used = frame;
+        live_bytes += picked->bytes;
+        peak_live_bytes = std::max(peak_live_bytes, live_bytes);
+        return picked->target;
+    }
+
+    // Hands the Memory to the next Pass asking for the same Key
+    void Release(RenderTarget *target)
+    {
+        if (!target)
+            return;
+        for (Entry &entry : entries)
+        {
+            if (entry.target != target || !entry.in_use)
+                continue;
+            entry.in_use = false;
+            live_bytes -= entry.bytes;
+            return;
+        }
+    }
+
+    // Once per Frame: frees Targets nobody asked for in a while and rolls the Statistics over
+    void EndFrame()
+    {
+        for (size_t i = 0; i < entries.size();)
+        {
+            if (!entries[i].in_use && frame - entries[i].last_used > RENDER_TARGET_IDLE_FRAMES)
+            {
+                destroy(entries[i]);
+                entries.erase(entries.begin() + i);
+            }
+            else
+                ++i;
+        }
+
+        last_requested_bytes = requested_bytes;
+        peak_requested_bytes = std::max(peak_requested_bytes, requested_bytes);
+        requested_bytes = 0;
+        ++frame;
+    }
+
+    // Binds a Target for Drawing, 0 is the Default FrameBuffer
+    void Bind(RenderTarget *target)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, target ? target->ID : 0);
+    }
+
+    // Screen Quad with the Texture on Unit 0 <same Layout as FrameBuffer::Draw>
+    void Draw(unsigned int texture = 0)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindVertexArray(0);
+    }
+
+    size_t ServeAllocatedBytes() { return allocated_bytes; }
+    size_t ServePeakBytes() { return peak_bytes; }
+    // Memory the last Frame's Acquires would take with one Target each <no Reuse>
+    size_t ServeRequestedBytes() { return last_requested_bytes; }
+    size_t ServePeakRequestedBytes() { return peak_requested_bytes; }
+    size_t ServeTargets() { return entries.size(); }
+
+    // Color Attachment Size by Format, Driver Padding isn't counted
+    static size_t TexelBytes(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_R8:                 return 1;
+        case GL_RG8:
+        case GL_R16F:               return 2;
+        case GL_RGB8:               return 3;
+        case GL_RGBA8:
+        case GL_RG16F:
+        case GL_R32F:
+        case GL_R11F_G11F_B10F:
+        case GL_RGB10_A2:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH_COMPONENT32F: return 4;
+        case GL_RGB16F:             return 6;
+        case GL_RGBA16F:
+        case GL_RG32F:              return 8;
+        case GL_RGB32F:             return 12;
+        case GL_RGBA32F:            return 16;
+        default:                    return 4;
+        }
+    }
+
+    void ImGuiStatus()
+    {
+        const float mb = 1024.0f * 1024.0f;
+        ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Render Target Pool:");
+        ImGui::BulletText("Targets:%d Allocated:%.1fMB Peak:%.1fMB", (int)entries.size(), allocated_bytes / mb, peak_bytes / mb);
+        ImGui::BulletText("Peak in Use:%.1fMB Without Reuse:%.1fMB", peak_live_bytes / mb, peak_requested_bytes / mb);
+        ImGui::BulletText("Reuse: same Size, Format and Samples only");
+    }
+
+private:
+    struct Entry
+    {
+        RenderTarget *target;
+        size_t bytes;
+        bool in_use;
+        int last_used;
+    };
+
+    std::vector<Entry> entries;
+    unsigned int VAO;
+    unsigned int VBO;
+    int frame;
+
+    size_t allocated_bytes;
+    size_t peak_bytes;
+    size_t requested_bytes;
+    size_t last_requested_bytes;
+    size_t peak_requested_bytes;
+    size_t live_bytes;
+    size_t peak_live_bytes;
+
+    static size_t bytes(int width, int height, GLenum format, int samples)
+    {
+        return (size_t)width * height * std::max(samples, 1) * TexelBytes(format);
+    }
+
+    // Color only <the Passes using the Pool are Screen Quads without Depth Test>
+    Entry create(int width, int height, GLenum format, int samples)
+    {
+        RenderTarget *target = new RenderTarget{0, 0, width, height, format, samples};
+        GLenum texture_target = samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+
+        glGenTextures(1, &target->texture);
+        glBindTexture(texture_target, target->texture);
+        if (samples > 1)
+            glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, format, width, height, GL_TRUE);
+        else
+        {
+            glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(texture_target, 0);
+
+        glGenFramebuffers(1, &target->ID);
+        glBindFramebuffer(GL_FRAMEBUFFER, target->ID);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture_target, target->texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::RENDER_TARGET_POOL::CREATE:: FrameBuffer is NOT Complete." << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        Entry entry;
+        entry.target = target;
+        entry.bytes = bytes(width, height, format, samples);
+        entry.in_use = false;
+        entry.last_used = frame;
+
+        allocated_bytes += entry.bytes;
+        peak_bytes = std::max(peak_bytes, allocated_bytes);
+        return entry;
+    }
+
+    void destroy(Entry &entry)
+    {
+        glDeleteFramebuffers(1, &entry.target->ID);
+        glDeleteTextures(1, &entry.target->texture);
+        allocated_bytes -= entry.bytes;
+        if (entry.in_use)
+            live_bytes -= entry.bytes;
+        delete entry.target;
+    }
+};
@@ -18,18 +18,24 @@ layout (std140) uniform Matrices {
 };
 
 uniform sampler2D SSAONoise;
-uniform sampler2D gPosition_View;
-uniform sampler2D gNormal_View;
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;      // octahedral World Normal
 uniform vec3 samplers[SSAO_KERNAL_SIZE];
 uniform int SRC_Width;
 uniform int SRC_Height;
+uniform vec2 viewport_scale = vec2(1.0);    // texCoords arrive scaled <HDR.vert>
 
-vec2 NOISE_SCALE = vec2(SRC_Width/SSAO_NOISE_SIZE, SRC_Height/SSAO_NOISE_SIZE);
+float LinearDepth(float depth);
+vec3 ViewPosition(vec2 uv, float depth);
+vec3 DecodeNormal(vec2 encoded);
 
 void main() {
-    vec3 fragpos = texture(gPosition_View, fs_in.texCoords).rgb;
-    vec3 normal = texture(gNormal_View, fs_in.texCoords).rgb;
-    vec3 noise_vec = texture(SSAONoise, fs_in.texCoords * NOISE_SCALE).rgb;
+    vec3 fragpos = ViewPosition(fs_in.texCoords / viewport_scale, texture(gDepth, fs_in.texCoords).r);
+    vec3 normal = normalize(mat3(view) * DecodeNormal(texture(gNormal, fs_in.texCoords).rg));
+    // one Noise Tile per SSAO_NOISE_SIZE Pixels at any internal Resolution
+    vec3 noise_vec = texture(SSAONoise, gl_FragCoord.xy / float(SSAO_NOISE_SIZE)).rgb;
+    // Samples stay inside the Region, the Texels past it hold stale Data
+    vec2 region_max = viewport_scale - 0.5 / vec2(textureSize(gDepth, 0));
 
     vec3 tangent = normalize(noise_vec - normal * dot(noise_vec, normal));
     vec3 bitangent = cross(tangent, normal);
@@ -46,7 +52,7 @@ void main() {
         sample_coords.xyz /= sample_coords.w;
         sample_coords.xyz = sample_coords.xyz * 0.5 + 0.5;// -> NCD
 
-        float sample_depth = texture(gPosition_View, sample_coords.xy).w;
+        float sample_depth = LinearDepth(texture(gDepth, clamp(sample_coords.xy * viewport_scale, vec2(0.0), region_max)).r);
         float smooth_occlusion_factor = smoothstep(0.0, 1.0, abs(SAMPLE_RADIUS_OFFSET - sample_depth / sample_coords.w));
         occlusion += sample_depth >= sample_coords.w ? smooth_occlusion_factor : 0.0;
         occlusion -= sample_coords.w == 0 ? 1.0 : 0.0;
@@ -54,4 +60,24 @@ void main() {
 
     occlusion /= SSAO_KERNAL_SIZE;
     FragColor = occlusion;
+}
+
+// Distance along the View Axis <same perspective Projection as LightingPass.frag>
+float LinearDepth(float depth) {
+    return projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+}
+
+vec3 ViewPosition(vec2 uv, float depth) {
+    vec2 ndc = uv * 2.0 - 1.0;
+    float z = -LinearDepth(depth);
+    vec2 xy = -z * (ndc + vec2(projection[2][0], projection[2][1])) / vec2(projection[0][0], projection[1][1]);
+    return vec3(xy, z);
+}
+
+vec3 DecodeNormal(vec2 encoded) {
+    encoded = encoded * 2.0 - 1.0;
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
 }
\ No newline at end of file
@@ -3,27 +3,55 @@
 #include <cmath>
 #include <random>
 
+#include "../imgui/imgui.h"
 #include "FrameBuffer.hpp"
 #include "GBuffer.hpp"
+#include "RenderTargetPool.hpp"
 #include "../Shader.hpp"
 
+// Ways to get the Occlusion the Lighting Passes multiply their Ambient with
+enum AOMode
+{
+    AO_SSAO,    // Hemisphere Kernel at full Resolution, box blurred
+    AO_GTAO     // Horizon based at half Resolution, accumulated over Frames and upsampled
+};
+
 class SSAOtools
 {
 public:
-    SSAOtools(int width, int height, GBuffer* gbuffer, Shader* shader, int _kernal_size = 64, int _noise_size = 4) :
-    SSAOfb(width, height, 1, 1, true),
-    SSAOBlurfb(width, height, 1, 1, true),
-    Blurshader("./Shaders/HDR.vert","./Shaders/SSAOBlur.frag")
+    AOMode mode = AO_SSAO;
+    float GTAORadius = 1.0f;    // World Units
+
+    // Occlusion Targets come from the Pool while SSAO runs
+    SSAOtools(int width, int height, GBuffer* gbuffer, Shader* shader, RenderTargetPool* pool, int _kernal_size = 64, int _noise_size = 4) :
+    Blurshader("./Shaders/HDR.vert","./Shaders/SSAOBlur.frag"),
+    GTAODownsampleShader("./Shaders/HDR.vert", "./Shaders/GTAODownsample.frag"),
+    GTAOShader("./Shaders/HDR.vert", "./Shaders/GTAO.frag"),
+    GTAOTemporalShader("./Shaders/HDR.vert", "./Shaders/GTAOTemporal.frag"),
+    GTAOUpsampleShader("./Shaders/HDR.vert", "./Shaders/GTAOUpsample.frag")
     {
         SRCWidth = width;
         SRCHeight = height;
         gBuffer = gbuffer;
         SSAOPassShader = shader;
+        Pool = pool;
         SSAOkernalsize = _kernal_size;
         SSAOnoisesize = _noise_size;
 
         buildSSAOkernal_SSAOnoise();
-        buildSSAOframebuffers();
+
+        for (Shader* shader : {&GTAODownsampleShader, &GTAOShader, &GTAOTemporalShader, &GTAOUpsampleShader})
+        {
+            shader->Use();
+            shader->setUniformBlock("Matrices", 0);
+        }
+    }
+
+    void Delete()
+    {
+        Release();
+        releaseHistory();
+        glDeleteTextures(1, &SSAONoiseTexture);
     }
 
     // Caution: This Func will NOT Set uniform_block of the Shader
@@ -35,50 +63,216 @@ public:
             SSAOPassShader->setVec3("samplers[" + std::to_string(i) + "]", SSAOkernal[i]);
     }
 
+    // Window Resizes <ShaderConfig has to run again afterwards>
+    void Resize(int width, int height)
+    {
+        SRCWidth = width;
+        SRCHeight = height;
+        releaseHistory();
+    }
+
+    // Half of the native Size <GTAO Targets>
+    int ServeHalfWidth() { return (SRCWidth + 1) / 2; }
+    int ServeHalfHeight() { return (SRCHeight + 1) / 2; }
+
+    // Dynamic Resolution: SSAO and its Blur read only this Fraction of the G-Buffer and Occlusion Textures
+    void ViewportScale(glm::vec2 scale)
+    {
+        SSAOPassShader->Use();
+        SSAOPassShader->setVec2("viewport_scale", scale);
+        Blurshader.Use();
+        Blurshader.setVec2("viewport_scale", scale);
+    }
+
     void LightingPass_Shader_Config(Shader* _lighting_pass_shader, bool _apply_bulr)
+    {
+        RenderTarget* target = _apply_bulr ? SSAOBlurfb : SSAOfb;
+        LightingPass_Shader_Config(_lighting_pass_shader, target ? target->texture : 0);
+    }
+
+    // Occlusion Texture from somewhere else <a Render Graph Resource>
+    void LightingPass_Shader_Config(Shader* _lighting_pass_shader, unsigned int _ssao_texture)
     {
         _lighting_pass_shader->setInt("ssao_compoent.SSAOTexture", 6);
         glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, _apply_bulr ? BlurTexture : SSAOfbTexture);
+        glBindTexture(GL_TEXTURE_2D, _ssao_texture);
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    // SSAO and its Blur into Pool Targets held until Release
     void Draw()
+    {
+        Release();
+        SSAOfb = Pool->Acquire(SRCWidth, SRCHeight, GL_R8);
+        SSAOBlurfb = Pool->Acquire(SRCWidth, SRCHeight, GL_R8);
+        Occlusion(SSAOfb);
+        Blur(SSAOfb, SSAOBlurfb);
+    }
+
+    // SSAOPassShader should be in Use
+    void Occlusion(RenderTarget* target)
     {
         SSAOPassShader->setInt("SSAONoise", 1);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, SSAONoiseTexture);
 
-        SSAOPassShader->setInt("gPosition_View", 2);
+        SSAOPassShader->setInt("gDepth", 2);
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gBuffer->gPosition_View);
+        glBindTexture(GL_TEXTURE_2D, gBuffer->gDepth);
 
-        SSAOPassShader->setInt("gNormal_View", 3);
+        SSAOPassShader->setInt("gNormal", 3);
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, gBuffer->gNormal_View);
+        glBindTexture(GL_TEXTURE_2D, gBuffer->gNormal);
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, 0);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, SSAOfb.ID);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        SSAOfb.Draw();
+        Pool->Bind(target);
+        glClear(GL_COLOR_BUFFER_BIT);
+        Pool->Draw();
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 
-        // Blur
+    void Blur(RenderTarget* source, RenderTarget* target)
+    {
         Blurshader.Use();
 
-        glBindFramebuffer(GL_FRAMEBUFFER, SSAOBlurfb.ID);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        SSAOBlurfb.Draw(SSAOfbTexture);
+        Pool->Bind(target);
+        glClear(GL_COLOR_BUFFER_BIT);
+        Pool->Draw(source->texture);
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    // Once per Frame before the GTAO Passes: Reprojection needs last Frame's Matrices and internal Size
+    void GTAOFrame(const glm::mat4& view, const glm::mat4& projection, int render_width, int render_height)
+    {
+        previous_view_projection = view_projection;
+        previous_render_size = render_size;
+        view_projection = projection * view;
+        render_size = glm::ivec2(render_width, render_height);
+        ++frame;
+
+        // History survives the Frame, so it stays out of the Graph's transient Targets
+        if (!history[0])
+        {
+            history[0] = Pool->Acquire(ServeHalfWidth(), ServeHalfHeight(), GL_RGBA16F);
+            history[1] = Pool->Acquire(ServeHalfWidth(), ServeHalfHeight(), GL_RGBA16F);
+            accumulated = false;
+        }
+        // a Frame without GTAO leaves a History that no longer matches
+        history_valid = accumulated;
+        accumulated = false;
+        current = 1 - current;
+    }
+
+    // Linear Depth and octahedral View Normal at half Resolution <RGB16F Target>
+    void GTAODownsample(RenderTarget* depth_normal)
+    {
+        GTAODownsampleShader.Use();
+        GTAODownsampleShader.setIVec2("render_size", render_size);
+        GTAODownsampleShader.setInt("gDepth", 2);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, gBuffer->gDepth);
+        GTAODownsampleShader.setInt("gNormal", 3);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, gBuffer->gNormal);
+        glActiveTexture(GL_TEXTURE0);
+
+        Pool->Bind(depth_normal);
+        Pool->Draw();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // raw Visibility at half Resolution, noisy until accumulated
+    void GTAOHorizons(RenderTarget* depth_normal, RenderTarget* target)
+    {
+        GTAOShader.Use();
+        GTAOShader.setIVec2("render_size", render_size);
+        GTAOShader.setFloat("radius", GTAORadius);
+        GTAOShader.setInt("frame", frame);
+        GTAOShader.setInt("depth_normal", 0);
+
+        Pool->Bind(target);
+        Pool->Draw(depth_normal->texture);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Blends the raw Visibility into the History, sets its own Viewport <the History isn't a Graph Target>
+    void GTAOTemporal(RenderTarget* depth_normal, RenderTarget* raw)
+    {
+        GTAOTemporalShader.Use();
+        GTAOTemporalShader.setIVec2("render_size", render_size);
+        GTAOTemporalShader.setIVec2("previous_render_size", previous_render_size);
+        GTAOTemporalShader.setMat4("previous_view_projection", previous_view_projection);
+        GTAOTemporalShader.setBool("history_valid", history_valid);
+        GTAOTemporalShader.setInt("depth_normal", 1);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, depth_normal->texture);
+        GTAOTemporalShader.setInt("raw_ao", 2);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, raw->texture);
+        GTAOTemporalShader.setInt("history", 3);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, history[1 - current]->texture);
+        glActiveTexture(GL_TEXTURE0);
+
+        Pool->Bind(history[current]);
+        glViewport(0, 0, (render_size.x + 1) / 2, (render_size.y + 1) / 2);
+        Pool->Draw();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        accumulated = true;
+    }
+
+    // back to the full internal Resolution along the G-Buffer's Depth and Normals
+    void GTAOUpsample(RenderTarget* depth_normal, RenderTarget* target)
+    {
+        GTAOUpsampleShader.Use();
+        GTAOUpsampleShader.setIVec2("render_size", render_size);
+        GTAOUpsampleShader.setInt("gDepth", 1);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, gBuffer->gDepth);
+        GTAOUpsampleShader.setInt("gNormal", 2);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, gBuffer->gNormal);
+        GTAOUpsampleShader.setInt("depth_normal", 3);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, depth_normal->texture);
+        GTAOUpsampleShader.setInt("history", 4);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, history[current]->texture);
+        glActiveTexture(GL_TEXTURE0);
+
+        Pool->Bind(target);
+        Pool->Draw();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void ImGuiStatus()
+    {
+        int selected = mode;
+        ImGui::Combo("AO Mode", &selected, "SSAO\0GTAO <half Resolution, temporal>\0");
+        mode = (AOMode)selected;
+        if (mode == AO_GTAO)
+        {
+            ImGui::SliderFloat("GTAO Radius", &GTAORadius, 0.1f, 4.0f, "%.2f");
+            ImGui::BulletText("Half Resolution:%d * %d History:%s", (render_size.x + 1) / 2, (render_size.y + 1) / 2, history_valid ? "Reprojected" : "Reset");
+        }
+    }
+
+    // Once the Lighting Passes have read the Occlusion <otherwise the next Draw releases it>
+    void Release()
+    {
+        Pool->Release(SSAOfb);
+        Pool->Release(SSAOBlurfb);
+        SSAOfb = nullptr;
+        SSAOBlurfb = nullptr;
+    }
+
 private:
     int SRCWidth;
     int SRCHeight;
@@ -87,17 +281,40 @@ private:
 
     std::vector<glm::vec3> SSAOkernal;
     std::vector<glm::vec3> SSAOnoise;
-    FrameBuffer SSAOfb;
     GBuffer* gBuffer;
     Shader* SSAOPassShader;
-    
+    RenderTargetPool* Pool;
+
     Shader Blurshader;
-    FrameBuffer SSAOBlurfb;
+    RenderTarget* SSAOfb = nullptr;
+    RenderTarget* SSAOBlurfb = nullptr;
 
-    unsigned int BlurTexture;
-    unsigned int SSAOfbTexture;
     unsigned int SSAONoiseTexture;
 
+    // GTAO
+    Shader GTAODownsampleShader;
+    Shader GTAOShader;
+    Shader GTAOTemporalShader;
+    Shader GTAOUpsampleShader;
+    RenderTarget* history[2] = {nullptr, nullptr};     // Visibility, Depth and Frame Count, ping-ponged
+    int current = 0;
+    int frame = 0;
+    bool accumulated = false;
+    bool history_valid = false;
+    glm::mat4 view_projection = glm::mat4(1.0f);
+    glm::mat4 previous_view_projection = glm::mat4(1.0f);
+    glm::ivec2 render_size = glm::ivec2(1);
+    glm::ivec2 previous_render_size = glm::ivec2(1);
+
+    // Window Resizes: the next GTAOFrame acquires both at the new Size
+    void releaseHistory()
+    {
+        Pool->Release(history[0]);
+        Pool->Release(history[1]);
+        history[0] = nullptr;
+        history[1] = nullptr;
+    }
+
     void buildSSAOnoisetexture()
     {
         glGenTextures(1, &SSAONoiseTexture);
@@ -139,38 +356,4 @@ private:
 
         buildSSAOnoisetexture();
     }
-
-    // SSAOframebuffer builder
-    void buildSSAOframebuffers()
-    {
-        glGenFramebuffers(1, &SSAOfb.ID);
-        glBindFramebuffer(GL_FRAMEBUFFER, SSAOfb.ID);
-
-        glGenTextures(1, &SSAOfbTexture);
-        glBindTexture(GL_TEXTURE_2D, SSAOfbTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SRCWidth, SRCHeight, 0, GL_RGB, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, SSAOfbTexture, 0);
-        SSAOfb.texture_attachments.push_back(SSAOfbTexture);
-
-        glBindTexture(GL_TEXTURE_2D,0);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        SSAOfb.Check();
-
-        glGenFramebuffers(1, &SSAOBlurfb.ID);
-        glBindFramebuffer(GL_FRAMEBUFFER, SSAOBlurfb.ID);
-
-        glGenTextures(1, &BlurTexture);
-        glBindTexture(GL_TEXTURE_2D, BlurTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SRCWidth, SRCHeight, 0, GL_RGB, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, BlurTexture, 0);
-        SSAOBlurfb.texture_attachments.push_back(BlurTexture);
-
-        glBindTexture(GL_TEXTURE_2D,0);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        SSAOBlurfb.Check();
-    }
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+#version 330 core
+// Contrast adaptive Sharpen after the Upscale: a 5 Tap Cross whose negative Lobe is limited so no Channel clips
+
+in VS_OUT {
+    vec2 texCoords;
+} fs_in;
+
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform float sharpness;    // 0 ~ 1
+
+// Strongest Lobe that keeps the Result inside the Neighbourhood
+const float LOBE_LIMIT = 0.25 - 1.0 / 16.0;
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 limit = textureSize(source, 0) - 1;
+    vec3 b = texelFetch(source, clamp(texel + ivec2(0, 1), ivec2(0), limit), 0).rgb;
+    vec3 d = texelFetch(source, clamp(texel - ivec2(1, 0), ivec2(0), limit), 0).rgb;
+    vec3 e = texelFetch(source, texel, 0).rgb;
+    vec3 f = texelFetch(source, clamp(texel + ivec2(1, 0), ivec2(0), limit), 0).rgb;
+    vec3 h = texelFetch(source, clamp(texel - ivec2(0, 1), ivec2(0), limit), 0).rgb;
+
+    vec3 lo = min(min(b, d), min(f, h));
+    vec3 hi = max(max(b, d), max(f, h));
+
+    // Lobe per Channel that would just reach 0 or 1
+    vec3 hit_lo = lo / (4.0 * hi + 1e-4);
+    vec3 hit_hi = (1.0 - hi) / (4.0 * lo - 4.0 - 1e-4);
+    vec3 lobes = max(-hit_lo, hit_hi);
+    float lobe = max(-LOBE_LIMIT, min(max(lobes.r, max(lobes.g, lobes.b)), 0.0)) * sharpness;
+
+    FragColor = vec4((lobe * (b + d + f + h) + e) / (4.0 * lobe + 1.0), 1.0);
+}
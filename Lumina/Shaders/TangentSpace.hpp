@@ -0,0 +1,448 @@
+// Parallel Normal and Tangent Generation <replaces aiProcess_GenSmoothNormals and aiProcess_CalcTangentSpace>
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TANGENT_SPACE_SSE
+#endif
+
+#include "glm/glm.hpp"
+#include "Mesh.hpp"
+
+// Meshes above this many Triangles are split across all Threads, smaller ones run one per Thread
+#define TANGENT_SPACE_SPLIT_TRIANGLES 16384
+
+struct TangentSpaceInput
+{
+    std::vector<Vertex> *vertices;
+    std::vector<unsigned int> *indices;
+    bool normals;   // regenerate Normals too <angle-weighted, welded by Position>
+};
+
+// Follows the MikkTSpace Conventions: per-Triangle Tangents from the UV Gradient, projected into each Vertex Normal Plane,
+// weighted by Corner Angle and shared between Corners with the same Position, Normal and UV. BiTangent = sign * cross(N, T)
+class TangentSpace
+{
+public:
+    struct Difference
+    {
+        float normal_mean;  // Degrees
+        float normal_max;
+        float tangent_mean;
+        float tangent_max;
+        float sign_mismatch;    // Fraction of Vertices whose BiTangent points the other way
+        int vertices;
+    };
+
+    static void Generate(std::vector<TangentSpaceInput> &meshes, int threads = 0)
+    {
+        if (threads <= 0)
+            threads = std::max((int)std::thread::hardware_concurrency(), 1);
+
+        // Big Meshes first, each using every Thread over Triangle Ranges
+        std::vector<int> small;
+        for (int i = 0; i < (int)meshes.size(); ++i)
+        {
+            if (meshes[i].indices->size() / 3 > TANGENT_SPACE_SPLIT_TRIANGLES)
+                process(meshes[i], threads);
+            else
+                small.push_back(i);
+        }
+
+        // the rest are pulled one Mesh at a Time by each Worker
+        std::atomic<int> next(0);
+        auto worker = [&]()
+        {
+            for (int i = next++; i < (int)small.size(); i = next++)
+                process(meshes[small[i]], 1);
+        };
+        int workers = std::min(threads, (int)small.size());
+        std::vector<std::thread> pool;
+        for (int i = 1; i < workers; ++i)
+            pool.emplace_back(worker);
+        worker();
+        for (std::thread &thread : pool)
+            thread.join();
+    }
+
+    static void Generate(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, bool normals, int threads = 0)
+    {
+        std::vector<TangentSpaceInput> meshes = {{&vertices, &indices, normals}};
+        Generate(meshes, threads);
+    }
+
+    // Vertex Arrays must share the same Layout <e.g. one Model loaded twice with different Options>
+    static Difference Compare(const std::vector<Vertex> &reference, const std::vector<Vertex> &result)
+    {
+        Difference difference = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0};
+        size_t count = std::min(reference.size(), result.size());
+        int mismatched = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            float normal = angleBetween(reference[i].Normal, result[i].Normal);
+            float tangent = angleBetween(reference[i].Tangent, result[i].Tangent);
+            difference.normal_mean += normal;
+            difference.tangent_mean += tangent;
+            difference.normal_max = std::max(difference.normal_max, normal);
+            difference.tangent_max = std::max(difference.tangent_max, tangent);
+            if (glm::dot(reference[i].BiTangent, result[i].BiTangent) < 0.0f)
+                ++mismatched;
+        }
+        if (count > 0)
+        {
+            difference.normal_mean /= count;
+            difference.tangent_mean /= count;
+            difference.sign_mismatch = (float)mismatched / count;
+        }
+        difference.vertices = (int)count;
+        return difference;
+    }
+
+private:
+    struct TriangleFrame
+    {
+        glm::vec3 normal;   // unit
+        glm::vec3 tangent;  // unit, zero for degenerate UVs
+        float sign;         // UV Orientation
+        float angle[3];
+    };
+
+    // Bitwise Key: Corners are only welded when the Attributes match exactly
+    struct WeldKey
+    {
+        float value[8];
+        bool operator==(const WeldKey &other) const
+        {
+            return std::memcmp(value, other.value, sizeof(value)) == 0;
+        }
+    };
+
+    struct WeldHash
+    {
+        size_t operator()(const WeldKey &key) const
+        {
+            unsigned int bits[8];
+            std::memcpy(bits, key.value, sizeof(bits));
+            size_t hash = 2166136261u;
+            for (unsigned int bit : bits)
+                hash = (hash ^ bit) * 16777619u;
+            return hash;
+        }
+    };
+
+    // Compressed Lists <items of list i are items[offsets[i] .. offsets[i + 1]]>
+    struct Lists
+    {
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned int> items;
+    };
+
+    template <typename Func>
+    static void parallelFor(size_t count, int threads, Func func)
+    {
+        if (threads <= 1 || count < 4096)
+        {
+            func((size_t)0, count);
+            return;
+        }
+
+        size_t chunk = (count + threads - 1) / threads;
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threads; ++i)
+        {
+            size_t begin = std::min(chunk * i, count);
+            size_t end = std::min(begin + chunk, count);
+            if (begin < end)
+                pool.emplace_back(func, begin, end);
+        }
+        func((size_t)0, std::min(chunk, count));
+        for (std::thread &thread : pool)
+            thread.join();
+    }
+
+    static float angleBetween(glm::vec3 a, glm::vec3 b)
+    {
+        float length = std::sqrt(glm::dot(a, a) * glm::dot(b, b));
+        if (length <= 0.0f)
+            return 0.0f;
+        return glm::degrees(std::acos(std::clamp(glm::dot(a, b) / length, -1.0f, 1.0f)));
+    }
+
+    static Lists invert(const std::vector<unsigned int> &owner, size_t lists)
+    {
+        Lists result;
+        result.offsets.assign(lists + 1, 0);
+        for (unsigned int id : owner)
+            ++result.offsets[id + 1];
+        for (size_t i = 0; i < lists; ++i)
+            result.offsets[i + 1] += result.offsets[i];
+
+        result.items.resize(owner.size());
+        std::vector<unsigned int> cursor(result.offsets.begin(), result.offsets.end() - 1);
+        for (unsigned int i = 0; i < (unsigned int)owner.size(); ++i)
+            result.items[cursor[owner[i]]++] = i;
+        return result;
+    }
+
+    // Group id per Vertex <with_normal_uv false welds by Position only>
+    static std::vector<unsigned int> weld(const std::vector<Vertex> &vertices, bool with_normal_uv, size_t &groups)
+    {
+        std::unordered_map<WeldKey, unsigned int, WeldHash> lookup;
+        lookup.reserve(vertices.size());
+        std::vector<unsigned int> group(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const Vertex &avertex = vertices[i];
+            WeldKey key = {{avertex.Position.x, avertex.Position.y, avertex.Position.z, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}};
+            if (with_normal_uv)
+            {
+                key.value[3] = avertex.Normal.x;
+                key.value[4] = avertex.Normal.y;
+                key.value[5] = avertex.Normal.z;
+                key.value[6] = avertex.Texcoords.x;
+                key.value[7] = avertex.Texcoords.y;
+            }
+            group[i] = lookup.emplace(key, (unsigned int)lookup.size()).first->second;
+        }
+        groups = lookup.size();
+        return group;
+    }
+
+    static void frameScalar(const std::vector<Vertex> &vertices, const unsigned int *corner, TriangleFrame &frame)
+    {
+        const Vertex &v0 = vertices[corner[0]];
+        const Vertex &v1 = vertices[corner[1]];
+        const Vertex &v2 = vertices[corner[2]];
+
+        glm::vec3 d1 = v1.Position - v0.Position;
+        glm::vec3 d2 = v2.Position - v0.Position;
+        glm::vec3 d3 = v2.Position - v1.Position;
+        glm::vec2 t21 = v1.Texcoords - v0.Texcoords;
+        glm::vec2 t31 = v2.Texcoords - v0.Texcoords;
+
+        glm::vec3 normal = glm::cross(d1, d2);
+        float length = glm::length(normal);
+        frame.normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+
+        float area = t21.x * t31.y - t21.y * t31.x;
+        glm::vec3 os = t31.y * d1 - t21.y * d2;
+        float os_length = glm::length(os);
+        frame.sign = area > 0.0f ? 1.0f : -1.0f;
+        frame.tangent = std::abs(area) > 1e-20f && os_length > 0.0f ? os * (frame.sign / os_length) : glm::vec3(0.0f);
+
+        frame.angle[0] = cornerAngle(d1, d2);
+        frame.angle[1] = cornerAngle(-d1, d3);
+        frame.angle[2] = cornerAngle(-d2, -d3);
+    }
+
+    static float cornerAngle(glm::vec3 a, glm::vec3 b)
+    {
+        float length = std::sqrt(glm::dot(a, a) * glm::dot(b, b));
+        return length > 0.0f ? std::acos(std::clamp(glm::dot(a, b) / length, -1.0f, 1.0f)) : 0.0f;
+    }
+
+#ifdef TANGENT_SPACE_SSE
+    // Four Triangles per Iteration in SoA Registers <only acos stays scalar>
+    static void frameSSE(const std::vector<Vertex> &vertices, const unsigned int *corner, TriangleFrame *frames)
+    {
+        alignas(16) float p[3][3][4];
+        alignas(16) float uv[3][2][4];
+        for (int t = 0; t < 4; ++t)
+            for (int k = 0; k < 3; ++k)
+            {
+                const Vertex &avertex = vertices[corner[t * 3 + k]];
+                p[k][0][t] = avertex.Position.x;
+                p[k][1][t] = avertex.Position.y;
+                p[k][2][t] = avertex.Position.z;
+                uv[k][0][t] = avertex.Texcoords.x;
+                uv[k][1][t] = avertex.Texcoords.y;
+            }
+
+        __m128 d1[3], d2[3], d3[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            __m128 p0 = _mm_load_ps(p[0][c]);
+            __m128 p1 = _mm_load_ps(p[1][c]);
+            __m128 p2 = _mm_load_ps(p[2][c]);
+            d1[c] = _mm_sub_ps(p1, p0);
+            d2[c] = _mm_sub_ps(p2, p0);
+            d3[c] = _mm_sub_ps(p2, p1);
+        }
+
+        // Face Normal
+        __m128 n[3];
+        n[0] = _mm_sub_ps(_mm_mul_ps(d1[1], d2[2]), _mm_mul_ps(d1[2], d2[1]));
+        n[1] = _mm_sub_ps(_mm_mul_ps(d1[2], d2[0]), _mm_mul_ps(d1[0], d2[2]));
+        n[2] = _mm_sub_ps(_mm_mul_ps(d1[0], d2[1]), _mm_mul_ps(d1[1], d2[0]));
+        __m128 zero = _mm_setzero_ps();
+        __m128 n_length = _mm_sqrt_ps(dot3(n, n));
+        __m128 n_valid = _mm_cmpgt_ps(n_length, zero);
+        __m128 n_scale = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(n_length, _mm_set1_ps(1e-30f))), n_valid);
+
+        // UV Gradient
+        __m128 t21x = _mm_sub_ps(_mm_load_ps(uv[1][0]), _mm_load_ps(uv[0][0]));
+        __m128 t21y = _mm_sub_ps(_mm_load_ps(uv[1][1]), _mm_load_ps(uv[0][1]));
+        __m128 t31x = _mm_sub_ps(_mm_load_ps(uv[2][0]), _mm_load_ps(uv[0][0]));
+        __m128 t31y = _mm_sub_ps(_mm_load_ps(uv[2][1]), _mm_load_ps(uv[0][1]));
+        __m128 area = _mm_sub_ps(_mm_mul_ps(t21x, t31y), _mm_mul_ps(t21y, t31x));
+        __m128 sign = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(area, zero), _mm_set1_ps(1.0f)), _mm_andnot_ps(_mm_cmpgt_ps(area, zero), _mm_set1_ps(-1.0f)));
+
+        __m128 os[3];
+        for (int c = 0; c < 3; ++c)
+            os[c] = _mm_sub_ps(_mm_mul_ps(t31y, d1[c]), _mm_mul_ps(t21y, d2[c]));
+        __m128 os_length = _mm_sqrt_ps(dot3(os, os));
+        __m128 abs_area = _mm_andnot_ps(_mm_set1_ps(-0.0f), area);
+        __m128 os_valid = _mm_and_ps(_mm_cmpgt_ps(abs_area, _mm_set1_ps(1e-20f)), _mm_cmpgt_ps(os_length, zero));
+        __m128 os_scale = _mm_and_ps(_mm_div_ps(sign, _mm_max_ps(os_length, _mm_set1_ps(1e-30f))), os_valid);
+
+        // Corner Cosines
+        __m128 len1 = dot3(d1, d1);
+        __m128 len2 = dot3(d2, d2);
+        __m128 len3 = dot3(d3, d3);
+        __m128 cos0 = cosine(dot3(d1, d2), _mm_mul_ps(len1, len2));
+        __m128 cos1 = cosine(_mm_sub_ps(zero, dot3(d1, d3)), _mm_mul_ps(len1, len3));
+        __m128 cos2 = cosine(dot3(d2, d3), _mm_mul_ps(len2, len3));
+
+        alignas(16) float out[13][4];
+        for (int c = 0; c < 3; ++c)
+        {
+            _mm_store_ps(out[c], _mm_mul_ps(n[c], n_scale));
+            _mm_store_ps(out[3 + c], _mm_mul_ps(os[c], os_scale));
+        }
+        _mm_store_ps(out[6], sign);
+        _mm_store_ps(out[7], cos0);
+        _mm_store_ps(out[8], cos1);
+        _mm_store_ps(out[9], cos2);
+        _mm_store_ps(out[10], _mm_cmpgt_ps(_mm_mul_ps(len1, len2), zero));
+        _mm_store_ps(out[11], _mm_cmpgt_ps(_mm_mul_ps(len1, len3), zero));
+        _mm_store_ps(out[12], _mm_cmpgt_ps(_mm_mul_ps(len2, len3), zero));
+
+        for (int t = 0; t < 4; ++t)
+        {
+            TriangleFrame &frame = frames[t];
+            frame.normal = glm::vec3(out[0][t], out[1][t], out[2][t]);
+            frame.tangent = glm::vec3(out[3][t], out[4][t], out[5][t]);
+            frame.sign = out[6][t];
+            // Corners with a zero-length Edge weigh nothing <same as the scalar Path>
+            for (int k = 0; k < 3; ++k)
+                frame.angle[k] = out[10 + k][t] != 0.0f ? std::acos(out[7 + k][t]) : 0.0f;
+        }
+    }
+
+    static __m128 dot3(const __m128 *a, const __m128 *b)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_mul_ps(a[2], b[2]));
+    }
+
+    static __m128 cosine(__m128 dot, __m128 length2)
+    {
+        __m128 length = _mm_sqrt_ps(length2);
+        __m128 value = _mm_div_ps(dot, _mm_max_ps(length, _mm_set1_ps(1e-30f)));
+        return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+    }
+#endif
+
+    static void computeFrames(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, std::vector<TriangleFrame> &frames, size_t begin, size_t end)
+    {
+        size_t t = begin;
+#ifdef TANGENT_SPACE_SSE
+        for (; t + 4 <= end; t += 4)
+            frameSSE(vertices, &indices[t * 3], &frames[t]);
+#endif
+        for (; t < end; ++t)
+            frameScalar(vertices, &indices[t * 3], frames[t]);
+    }
+
+    static void process(TangentSpaceInput &input, int threads)
+    {
+        std::vector<Vertex> &vertices = *input.vertices;
+        std::vector<unsigned int> &indices = *input.indices;
+        size_t triangles = indices.size() / 3;
+        if (vertices.empty() || triangles == 0)
+            return;
+
+        std::vector<TriangleFrame> frames(triangles);
+        parallelFor(triangles, threads, [&](size_t begin, size_t end)
+                    { computeFrames(vertices, indices, frames, begin, end); });
+
+        // Corner c belongs to Vertex indices[c]
+        std::vector<unsigned int> corner_owner(indices.begin(), indices.begin() + triangles * 3);
+        Lists corners = invert(corner_owner, vertices.size());
+
+        if (input.normals)
+        {
+            size_t groups;
+            std::vector<unsigned int> group = weld(vertices, false, groups);
+            Lists members = invert(group, groups);
+            parallelFor(groups, threads, [&](size_t begin, size_t end)
+                        {
+                            for (size_t g = begin; g < end; ++g)
+                            {
+                                glm::vec3 normal = glm::vec3(0.0f);
+                                for (unsigned int m = members.offsets[g]; m < members.offsets[g + 1]; ++m)
+                                {
+                                    unsigned int v = members.items[m];
+                                    for (unsigned int c = corners.offsets[v]; c < corners.offsets[v + 1]; ++c)
+                                    {
+                                        unsigned int corner = corners.items[c];
+                                        TriangleFrame &frame = frames[corner / 3];
+                                        normal += frame.normal * frame.angle[corner % 3];
+                                    }
+                                }
+                                float length = glm::length(normal);
+                                normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+                                for (unsigned int m = members.offsets[g]; m < members.offsets[g + 1]; ++m)
+                                    vertices[members.items[m]].Normal = normal;
+                            } });
+        }
+
+        size_t groups;
+        std::vector<unsigned int> group = weld(vertices, true, groups);
+        Lists members = invert(group, groups);
+        parallelFor(groups, threads, [&](size_t begin, size_t end)
+                    {
+                        for (size_t g = begin; g < end; ++g)
+                        {
+                            glm::vec3 normal = vertices[members.items[members.offsets[g]]].Normal;
+                            glm::vec3 tangent = glm::vec3(0.0f);
+                            float orientation = 0.0f;
+                            for (unsigned int m = members.offsets[g]; m < members.offsets[g + 1]; ++m)
+                            {
+                                unsigned int v = members.items[m];
+                                for (unsigned int c = corners.offsets[v]; c < corners.offsets[v + 1]; ++c)
+                                {
+                                    unsigned int corner = corners.items[c];
+                                    TriangleFrame &frame = frames[corner / 3];
+                                    glm::vec3 projected = frame.tangent - normal * glm::dot(normal, frame.tangent);
+                                    float length = glm::length(projected);
+                                    if (length <= 0.0f)
+                                        continue;
+                                    float weight = frame.angle[corner % 3];
+                                    tangent += projected * (weight / length);
+                                    orientation += frame.sign * weight;
+                                }
+                            }
+
+                            float length = glm::length(tangent);
+                            if (length > 0.0f)
+                                tangent /= length;
+                            else
+                                tangent = glm::normalize(glm::cross(normal, std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f)));
+                            glm::vec3 bitangent = glm::cross(normal, tangent) * (orientation < 0.0f ? -1.0f : 1.0f);
+
+                            for (unsigned int m = members.offsets[g]; m < members.offsets[g + 1]; ++m)
+                            {
+                                vertices[members.items[m]].Tangent = tangent;
+                                vertices[members.items[m]].BiTangent = bitangent;
+                            }
+                        } });
+    }
+};
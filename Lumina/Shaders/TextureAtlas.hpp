@@ -0,0 +1,317 @@
+// Import-Time Atlas Builder: packs small Material Textures into shared Pages so Meshes can be batched
+// Every Page holds one Internal Format <sRGB and linear Textures never share a Page>
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../imgui/imstb_rectpack.h"
+#include "Mesh.hpp"
+
+class TextureAtlas
+{
+public:
+    int MaxTextureSize; // only Textures up to this size are packed
+    int AtlasSize;
+    int SafeLevels;     // Mips that never bleed between Rects <Rects are aligned and padded to 2^SafeLevels>
+
+    std::vector<unsigned int> pages;
+    int packed_textures;
+    int batched_meshes;
+
+    TextureAtlas(int max_texture_size = 256, int atlas_size = 2048, int safe_levels = 3)
+    {
+        MaxTextureSize = max_texture_size;
+        AtlasSize = atlas_size;
+        SafeLevels = safe_levels;
+        packed_textures = 0;
+        batched_meshes = 0;
+    }
+
+    // Only Meshes with a single diffuse Texture and UVs inside [0, 1] are remapped <repeating UVs can't live in an Atlas>
+    // PMX Toon Ramps and Sphere Maps <.sph/.spa> aren't packed: the Loader keeps them as PMXMaterial Indices and
+    // never creates Textures for them, so there is nothing on the GPU to pack until a Shader samples them
+    void Build(std::vector<Mesh> &meshes, std::vector<Texture> &textures_loaded)
+    {
+        int gutter = 1 << SafeLevels;
+
+        // Candidates
+        std::vector<PackedTexture> packed;
+        std::vector<bool> candidate(meshes.size(), false);
+        for (int i = 0; i < (int)meshes.size(); ++i)
+        {
+            Mesh &amesh = meshes[i];
+            if (amesh.textures.size() != 1 || amesh.textures[0].type != "texture_diffuse" || !unitUVs(amesh))
+                continue;
+
+            unsigned int id = amesh.textures[0].id;
+            if (findPacked(packed, id) < 0)
+            {
+                PackedTexture texture;
+                texture.id = id;
+                glBindTexture(GL_TEXTURE_2D, id);
+                glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &texture.width);
+                glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &texture.height);
+                GLint internalformat;
+                glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalformat);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                texture.format = pageFormat(internalformat);
+                if (texture.width > MaxTextureSize || texture.height > MaxTextureSize || texture.format == GL_NONE)
+                    continue;
+                texture.page = -1;
+                packed.push_back(texture);
+            }
+            candidate[i] = true;
+        }
+
+        if (packed.empty())
+            return;
+
+        // Packing <one Group of Pages per Format, multiple Pages when one is full>
+        std::vector<stbrp_rect> rects(packed.size());
+        std::vector<GLenum> formats;
+        for (int i = 0; i < (int)packed.size(); ++i)
+        {
+            rects[i].id = i;
+            rects[i].w = (stbrp_coord)alignUp(packed[i].width + 2 * gutter, gutter);
+            rects[i].h = (stbrp_coord)alignUp(packed[i].height + 2 * gutter, gutter);
+            if (std::find(formats.begin(), formats.end(), packed[i].format) == formats.end())
+                formats.push_back(packed[i].format);
+        }
+
+        std::vector<stbrp_node> nodes(AtlasSize);
+        for (GLenum format : formats)
+        {
+            std::vector<stbrp_rect> remaining;
+            for (stbrp_rect &rect : rects)
+                if (packed[rect.id].format == format)
+                    remaining.push_back(rect);
+            packFormat(remaining, nodes, packed, format, gutter);
+        }
+
+        // UV Remapping
+        for (int i = 0; i < (int)meshes.size(); ++i)
+        {
+            if (!candidate[i])
+                continue;
+            int slot = findPacked(packed, meshes[i].textures[0].id);
+            if (slot < 0 || packed[slot].page < 0)
+            {
+                candidate[i] = false;
+                continue;
+            }
+
+            PackedTexture &texture = packed[slot];
+            glm::vec2 offset = glm::vec2(texture.x, texture.y) / (float)AtlasSize;
+            glm::vec2 scale = glm::vec2(texture.width, texture.height) / (float)AtlasSize;
+            for (Vertex &avertex : meshes[i].vertices)
+                avertex.Texcoords = offset + glm::clamp(avertex.Texcoords, 0.0f, 1.0f) * scale;
+
+            Texture atlas;
+            atlas.id = pages[texture.page];
+            atlas.type = "texture_diffuse";
+            atlas.path = aiString(); // no Source File <TextureResidency skips it>
+            meshes[i].textures[0] = atlas;
+        }
+
+        mergeBatches(meshes, candidate);
+
+        // Release Originals that no Mesh references anymore
+        for (PackedTexture &texture : packed)
+        {
+            if (texture.page < 0 || referenced(meshes, texture.id))
+                continue;
+            glDeleteTextures(1, &texture.id);
+            textures_loaded.erase(std::remove_if(textures_loaded.begin(), textures_loaded.end(), [&](Texture &t)
+                                                 { return t.id == texture.id; }),
+                                  textures_loaded.end());
+            ++packed_textures;
+        }
+
+#ifdef _MODEL_DEBUG
+        std::cout << std::endl;
+        std::cout << "MANUAL_DEBUG::TEXTURE_ATLAS" << std::endl;
+        std::cout << "Pages: " << pages.size() << " (" << AtlasSize << " * " << AtlasSize << ")" << std::endl;
+        std::cout << "Packed Textures: " << packed_textures << std::endl;
+        std::cout << "Batched Meshes: " << batched_meshes << std::endl;
+#endif
+    }
+
+private:
+    struct PackedTexture
+    {
+        unsigned int id;
+        int width;
+        int height;
+        GLenum format; // sized Internal Format of the Original, the Page gets the same
+        int page;
+        int x; // Texel origin inside the Page <gutter excluded>
+        int y;
+    };
+
+    // 8 Bit Formats the Pages can hold, GL_NONE leaves the Texture unpacked
+    static GLenum pageFormat(GLint internalformat)
+    {
+        switch (internalformat)
+        {
+        case GL_RED: case GL_R8: return GL_R8;
+        case GL_RGB: case GL_RGB8: return GL_RGB8;
+        case GL_RGBA: case GL_RGBA8: return GL_RGBA8;
+        case GL_SRGB: case GL_SRGB8: return GL_SRGB8;
+        case GL_SRGB_ALPHA: case GL_SRGB8_ALPHA8: return GL_SRGB8_ALPHA8;
+        default: return GL_NONE;
+        }
+    }
+
+    static int alignUp(int value, int alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static int findPacked(std::vector<PackedTexture> &packed, unsigned int id)
+    {
+        for (int i = 0; i < (int)packed.size(); ++i)
+            if (packed[i].id == id)
+                return i;
+        return -1;
+    }
+
+    static bool unitUVs(Mesh &amesh)
+    {
+        const float eps = 1e-3f;
+        for (Vertex &avertex : amesh.vertices)
+            if (avertex.Texcoords.x < -eps || avertex.Texcoords.x > 1.0f + eps || avertex.Texcoords.y < -eps || avertex.Texcoords.y > 1.0f + eps)
+                return false;
+        return true;
+    }
+
+    static bool referenced(std::vector<Mesh> &meshes, unsigned int id)
+    {
+        for (Mesh &amesh : meshes)
+            for (Texture &atexture : amesh.textures)
+                if (atexture.id == id)
+                    return true;
+        return false;
+    }
+
+    // Fills Pages with the Rects of one Format until all are placed or one doesn't fit an empty Page
+    void packFormat(std::vector<stbrp_rect> &remaining, std::vector<stbrp_node> &nodes, std::vector<PackedTexture> &packed, GLenum format, int gutter)
+    {
+        while (!remaining.empty())
+        {
+            stbrp_context context;
+            stbrp_init_target(&context, AtlasSize, AtlasSize, nodes.data(), (int)nodes.size());
+            stbrp_pack_rects(&context, remaining.data(), (int)remaining.size());
+
+            std::vector<stbrp_rect> next;
+            bool any = false;
+            for (stbrp_rect &rect : remaining)
+            {
+                if (!rect.was_packed)
+                {
+                    next.push_back(rect);
+                    continue;
+                }
+                PackedTexture &texture = packed[rect.id];
+                texture.page = (int)pages.size();
+                texture.x = rect.x + gutter;
+                texture.y = rect.y + gutter;
+                any = true;
+            }
+
+            if (!any)
+                break;
+            pages.push_back(buildPage((int)pages.size(), packed, gutter, format));
+            remaining.swap(next);
+        }
+    }
+
+    // Gutters repeat the Edge Texels <same as GL_CLAMP_TO_EDGE on the Originals>
+    // Texels are copied as stored, so sRGB Pages keep their Encoding
+    unsigned int buildPage(int page, std::vector<PackedTexture> &packed, int gutter, GLenum format)
+    {
+        std::vector<unsigned char> pixels((size_t)AtlasSize * AtlasSize * 4, 0);
+        std::vector<unsigned char> source;
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        for (PackedTexture &texture : packed)
+        {
+            if (texture.page != page)
+                continue;
+
+            source.resize((size_t)texture.width * texture.height * 4);
+            glBindTexture(GL_TEXTURE_2D, texture.id);
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, source.data());
+
+            for (int y = -gutter; y < texture.height + gutter; ++y)
+                for (int x = -gutter; x < texture.width + gutter; ++x)
+                {
+                    int sx = std::clamp(x, 0, texture.width - 1);
+                    int sy = std::clamp(y, 0, texture.height - 1);
+                    size_t dst = ((size_t)(texture.y + y) * AtlasSize + (texture.x + x)) * 4;
+                    size_t src = ((size_t)sy * texture.width + sx) * 4;
+                    std::copy(source.begin() + src, source.begin() + src + 4, pixels.begin() + dst);
+                }
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, AtlasSize, AtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        // Coarser Mips would mix neighbouring Rects
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, SafeLevels);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        return textureID;
+    }
+
+    // Meshes sharing a Page become one Mesh <one Draw> placed where the first Member was
+    void mergeBatches(std::vector<Mesh> &meshes, std::vector<bool> &candidate)
+    {
+        std::vector<Mesh> merged;
+        std::vector<bool> emitted(pages.size(), false);
+
+        for (int i = 0; i < (int)meshes.size(); ++i)
+        {
+            if (!candidate[i])
+            {
+                merged.push_back(meshes[i]);
+                continue;
+            }
+
+            unsigned int page = meshes[i].textures[0].id;
+            int page_index = (int)(std::find(pages.begin(), pages.end(), page) - pages.begin());
+            if (emitted[page_index])
+                continue;
+            emitted[page_index] = true;
+
+            std::vector<Vertex> vertices;
+            std::vector<unsigned int> indices;
+            int members = 0;
+            for (int j = i; j < (int)meshes.size(); ++j)
+            {
+                if (!candidate[j] || meshes[j].textures[0].id != page)
+                    continue;
+
+                unsigned int base = (unsigned int)vertices.size();
+                vertices.insert(vertices.end(), meshes[j].vertices.begin(), meshes[j].vertices.end());
+                for (unsigned int index : meshes[j].indices)
+                    indices.push_back(base + index);
+                meshes[j].Delete();
+                ++members;
+            }
+
+            batched_meshes += members;
+            merged.push_back(Mesh(vertices, indices, meshes[i].textures));
+        }
+
+        meshes.swap(merged);
+    }
+};
@@ -0,0 +1,606 @@
+// Keeps Model Textures within a VRAM Budget by Streaming Mip Levels in and out
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+#include "../imgui/imgui.h"
+#include "../Camera.hpp"
+#include "Model.hpp"
+
+class TextureResidency
+{
+public:
+    int Budget_MB;
+    int UploadsPerFrame;    // Rebuilds allowed per Frame <avoid hitches>
+    float MipBias;          // > 0 prefers blurrier Textures
+    int MinResidentSize;    // Mips smaller than this are never evicted
+
+    TextureResidency(int budget_mb = 256, int uploads_per_frame = 2)
+    {
+        Budget_MB = budget_mb;
+        UploadsPerFrame = uploads_per_frame;
+        MipBias = 0.0f;
+        MinResidentSize = 16;
+        frame = 0;
+        streamed_in = 0;
+        streamed_out = 0;
+        decoding = 0;
+        stream_failures = 0;
+        stopping = false;
+        worker = std::thread([this]()
+                             { decodeLoop(); });
+    }
+
+    ~TextureResidency()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stopping = true;
+        }
+        queue_ready.notify_one();
+        worker.join();
+    }
+
+    // Register every Texture of the Model <the Transform is used for Screen-Space Estimation>
+    // Textures without a Source File <Atlas Pages> stay fully resident
+    void Track(Model *model, glm::mat4 transform)
+    {
+        TrackedModel tracked;
+        tracked.model = model;
+        tracked.transform = transform;
+        trackedmodels.push_back(tracked);
+
+        for (Mesh &amesh : model->ServeMeshes())
+            for (Texture &atexture : amesh.textures)
+                if (atexture.path.length > 0 && find(atexture.id) < 0)
+                    entries.push_back(buildEntry(atexture, model->ServeDirectory()));
+    }
+
+    // Layers of a GL_TEXTURE_2D_ARRAY <MaterialSystem> share one Mip Chain, so they stream together:
+    // the Array is rebuilt with the finest Level any Layer needs. *array is the Owner's Name and is rewritten on
+    // every Rebuild, views[i] replaced the tracked Texture sources[i] and is rebuilt and patched into the Meshes too
+    // Returns false when a Layer isn't tracked <no Source File>, the Array then stays fully resident
+    bool TrackArray(unsigned int *array, const std::vector<unsigned int> &sources, const std::vector<unsigned int> &views, int levels)
+    {
+        ArrayEntry tracked;
+        tracked.id = array;
+        tracked.levels = levels;
+        tracked.resident_top = 0;
+        tracked.pending_top = -1;
+        tracked.decoded_count = 0;
+        tracked.failed = false;
+        for (unsigned int source : sources)
+        {
+            int slot = find(source);
+            if (slot < 0)
+                return false;
+            tracked.layers.push_back(slot);
+        }
+
+        for (int layer = 0; layer < (int)views.size(); ++layer)
+        {
+            entries[tracked.layers[layer]].id = views[layer];
+            entries[tracked.layers[layer]].array = (int)arrays.size();
+        }
+        arrays.push_back(tracked);
+        return true;
+    }
+
+    void SetTransform(Model *model, glm::mat4 transform)
+    {
+        for (TrackedModel &tracked : trackedmodels)
+            if (tracked.model == model)
+                tracked.transform = transform;
+    }
+
+    // Call once per Frame before Drawing
+    void Update(Camera &camera, int screen_height)
+    {
+        ++frame;
+
+        for (Entry &entry : entries)
+            entry.required_top = entry.levels - 1;
+
+        estimateRequiredLevels(camera, screen_height);
+        fitBudget();
+        shareArrayLevels();
+        stream();
+    }
+
+    size_t ResidentBytes()
+    {
+        size_t sum = 0;
+        for (Entry &entry : entries)
+            sum += chainBytes(entry, entry.resident_top);
+        return sum;
+    }
+
+    // Draws into the current ImGui Window
+    void ImGuiStatus()
+    {
+        float used_mb = ResidentBytes() / (1024.0f * 1024.0f);
+
+        ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "Texture Residency:");
+        ImGui::SliderInt("Texture Budget (MB)", &Budget_MB, 16, 2048);
+        ImGui::SliderFloat("Texture Mip Bias", &MipBias, -1.0f, 4.0f, "%.1f");
+        ImGui::ProgressBar(std::min(used_mb / (float)Budget_MB, 1.0f), ImVec2(-1.0f, 0.0f));
+        ImGui::BulletText("Resident:%.1fMB / %dMB", used_mb, Budget_MB);
+        ImGui::BulletText("Textures:%d Streamed In:%d Out:%d", (int)entries.size(), streamed_in, streamed_out);
+        ImGui::BulletText("Decoding:%d Failed:%d", decoding, stream_failures);
+    }
+
+private:
+    struct TrackedModel
+    {
+        Model *model;
+        glm::mat4 transform;
+    };
+
+    struct Entry
+    {
+        unsigned int id;
+        std::string name;
+        std::string directory;
+        bool gamma;
+        int width;  // Level 0 size on disk
+        int height;
+        int channels;
+        int levels;
+        int resident_top;   // finest Mip currently on the GPU
+        int required_top;   // finest Mip the Screen needs
+        int target_top;     // after fitting the Budget
+        unsigned long long last_used;
+        int array;          // ArrayEntry the Texture is a Layer of, -1 when it has its own Storage
+        int pending_top;    // Level queued on the Worker, -1 when nothing is
+        bool failed;        // the File couldn't be decoded, the Texture keeps what it has
+    };
+
+    struct ArrayEntry
+    {
+        unsigned int *id;
+        std::vector<int> layers;    // Entries
+        int levels;                 // full Chain
+        int resident_top;
+        int pending_top;
+        std::vector<TextureLevels> decoded; // per Layer, the Rebuild waits for all of them
+        int decoded_count;
+        bool failed;
+    };
+
+    // Disk Reads and the Box Filter run on the Worker, only the Upload stays on the Render Thread
+    struct DecodeJob
+    {
+        int entry;
+        int top;
+        std::string name;
+        std::string directory;
+        bool gamma;
+    };
+
+    struct DecodeResult
+    {
+        int entry;
+        int top;
+        bool ok;
+        TextureLevels levels;
+    };
+
+    std::vector<TrackedModel> trackedmodels;
+    std::vector<Entry> entries;
+    std::vector<ArrayEntry> arrays;
+    unsigned long long frame;
+    int streamed_in;
+    int streamed_out;
+    int decoding;
+    int stream_failures;
+
+    std::thread worker;
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::deque<DecodeJob> jobs;         // guarded by queue_mutex
+    std::deque<DecodeResult> results;   // guarded by queue_mutex
+    std::deque<DecodeResult> completed; // Render Thread only, waiting for Upload Budget
+    bool stopping;                      // guarded by queue_mutex
+
+    void decodeLoop()
+    {
+        while (true)
+        {
+            DecodeJob job;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_ready.wait(lock, [this]()
+                                 { return stopping || !jobs.empty(); });
+                if (stopping)
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            DecodeResult result;
+            result.entry = job.entry;
+            result.top = job.top;
+            result.ok = TextureLevelsDecode(job.name.c_str(), job.directory, job.gamma, job.top, result.levels);
+
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            results.push_back(std::move(result));
+        }
+    }
+
+    void enqueue(int slot, int top)
+    {
+        Entry &entry = entries[slot];
+        entry.pending_top = top;
+        ++decoding;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            jobs.push_back({slot, top, entry.name, entry.directory, entry.gamma});
+        }
+        queue_ready.notify_one();
+    }
+
+    int find(unsigned int id)
+    {
+        for (int i = 0; i < (int)entries.size(); ++i)
+            if (entries[i].id == id)
+                return i;
+        return -1;
+    }
+
+    Entry buildEntry(Texture &texture, std::string directory)
+    {
+        Entry entry;
+        entry.id = texture.id;
+        entry.name = texture.path.C_Str();
+        entry.directory = directory;
+        entry.gamma = texture.type == "texture_diffuse";
+
+        int internalformat = 0;
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &entry.width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &entry.height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalformat);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (internalformat == GL_RED || internalformat == GL_R8)
+            entry.channels = 1;
+        else if (internalformat == GL_RGB || internalformat == GL_RGB8 || internalformat == GL_SRGB || internalformat == GL_SRGB8)
+            entry.channels = 3;
+        else
+            entry.channels = 4;
+
+        entry.levels = 1 + (int)std::floor(std::log2((float)std::max(std::max(entry.width, entry.height), 1)));
+        entry.resident_top = 0;
+        entry.required_top = 0;
+        entry.target_top = 0;
+        entry.last_used = 0;
+        entry.array = -1;
+        entry.pending_top = -1;
+        entry.failed = false;
+        return entry;
+    }
+
+    int lowestEvictable(Entry &entry)
+    {
+        int top = entry.levels - 1;
+        while (top > 0 && (std::max(entry.width, entry.height) >> top) < MinResidentSize)
+            --top;
+        return top;
+    }
+
+    size_t chainBytes(Entry &entry, int top)
+    {
+        size_t sum = 0;
+        for (int mip = top; mip < entry.levels; ++mip)
+            sum += (size_t)std::max(entry.width >> mip, 1) * std::max(entry.height >> mip, 1) * entry.channels;
+        return sum;
+    }
+
+    // Projected Size of each Mesh's Bounds decides how many Texels it can show
+    void estimateRequiredLevels(Camera &camera, int screen_height)
+    {
+        float tan_half_fov = std::tan(glm::radians(camera.Fov) * 0.5f);
+
+        for (TrackedModel &tracked : trackedmodels)
+            for (Mesh &amesh : tracked.model->ServeMeshes())
+            {
+                glm::vec3 center = glm::vec3(tracked.transform * glm::vec4((amesh.AABB_min + amesh.AABB_max) * 0.5f, 1.0f));
+                glm::vec3 extent = glm::vec3(tracked.transform * glm::vec4(amesh.AABB_max - amesh.AABB_min, 0.0f));
+                float radius = glm::length(extent) * 0.5f;
+
+                glm::vec3 cam2center = center - camera.Position;
+                float distance = std::max(glm::length(cam2center) - radius, camera.Znear);
+                bool visible = glm::dot(cam2center, camera.Front) > -radius;
+                if (!visible)
+                    continue;
+
+                // Assume the UV Range [0, 1] spans the Mesh once
+                float diameter_px = std::max(radius / (distance * tan_half_fov) * screen_height, 1.0f);
+
+                for (Texture &atexture : amesh.textures)
+                {
+                    int slot = find(atexture.id);
+                    if (slot < 0)
+                        continue;
+
+                    Entry &entry = entries[slot];
+                    int top = (int)std::floor(std::log2(std::max(entry.width, entry.height) / diameter_px) + MipBias);
+                    top = std::clamp(top, 0, lowestEvictable(entry));
+                    entry.required_top = std::min(entry.required_top, top);
+                    entry.last_used = frame;
+                }
+            }
+
+        // Textures not seen this Frame keep their Levels until the Budget asks for them
+        for (Entry &entry : entries)
+            entry.target_top = entry.last_used == frame ? entry.required_top : entry.resident_top;
+    }
+
+    // Evict Levels of the least recently used Textures until everything fits
+    void fitBudget()
+    {
+        size_t budget = (size_t)Budget_MB * 1024 * 1024;
+        size_t total = 0;
+        for (Entry &entry : entries)
+            total += chainBytes(entry, entry.target_top);
+
+        std::vector<int> order(entries.size());
+        for (int i = 0; i < (int)order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [this](int a, int b)
+                  { return entries[a].last_used != entries[b].last_used ? entries[a].last_used < entries[b].last_used : chainBytes(entries[a], entries[a].target_top) > chainBytes(entries[b], entries[b].target_top); });
+
+        bool evicted = true;
+        while (total > budget && evicted)
+        {
+            evicted = false;
+            for (int slot : order)
+            {
+                Entry &entry = entries[slot];
+                if (entry.target_top >= lowestEvictable(entry))
+                    continue;
+
+                total -= chainBytes(entry, entry.target_top) - chainBytes(entry, entry.target_top + 1);
+                ++entry.target_top;
+                evicted = true;
+                break;
+            }
+        }
+    }
+
+    // a Layer only keeps the Levels its Array keeps <the finest any Layer needs wins over the Budget>
+    void shareArrayLevels()
+    {
+        for (ArrayEntry &array : arrays)
+        {
+            int top = array.levels - 1;
+            for (int slot : array.layers)
+                top = std::min(top, entries[slot].target_top);
+            for (int slot : array.layers)
+                entries[slot].target_top = top;
+        }
+    }
+
+    void stream()
+    {
+        int uploads = 0;
+
+        // Stream out first to release Memory before anything grows
+        for (Entry &entry : entries)
+            if (uploads < UploadsPerFrame && entry.array < 0 && entry.target_top > entry.resident_top)
+            {
+                dropLevels(entry, entry.target_top);
+                ++uploads;
+            }
+        for (ArrayEntry &array : arrays)
+            if (uploads < UploadsPerFrame && array.pending_top < 0 && entries[array.layers[0]].target_top > array.resident_top)
+            {
+                rebuildArray(array, entries[array.layers[0]].target_top);
+                ++uploads;
+            }
+
+        // finished Decodes, uploaded as the Budget allows <a Result is kept only while it is still finer than what's resident>
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            while (!results.empty())
+            {
+                completed.push_back(std::move(results.front()));
+                results.pop_front();
+            }
+        }
+        while (!completed.empty())
+        {
+            DecodeResult &result = completed.front();
+            Entry &entry = entries[result.entry];
+            if (entry.array >= 0)
+            {
+                // Layers only wait for their Siblings, the Rebuild below pays the Upload
+                ArrayEntry &array = arrays[entry.array];
+                int layer = (int)(std::find(array.layers.begin(), array.layers.end(), result.entry) - array.layers.begin());
+                array.decoded[layer] = std::move(result.levels);
+                array.failed = array.failed || !result.ok;
+                ++array.decoded_count;
+            }
+            else
+            {
+                if (uploads >= UploadsPerFrame)
+                    break;
+                if (!result.ok)
+                    markFailed(entry);
+                else if (result.top < entry.resident_top && result.top >= entry.target_top)
+                {
+                    TextureLevelsUpload(entry.id, result.levels);
+                    entry.resident_top = result.top;
+                    ++streamed_in;
+                    ++uploads;
+                }
+            }
+            entry.pending_top = -1;
+            --decoding;
+            completed.pop_front();
+        }
+        for (ArrayEntry &array : arrays)
+            if (array.pending_top >= 0 && array.decoded_count == (int)array.layers.size())
+            {
+                if (uploads >= UploadsPerFrame)
+                    continue;
+                if (array.failed)
+                    for (int slot : array.layers)
+                        markFailed(entries[slot]);
+                else if (array.pending_top < array.resident_top && array.pending_top >= entries[array.layers[0]].target_top)
+                {
+                    rebuildArray(array, array.pending_top, &array.decoded);
+                    ++uploads;
+                }
+                array.pending_top = -1;
+                array.decoded.clear();
+                array.decoded_count = 0;
+            }
+
+        // Streaming in only queues the Decode, a File that failed once is never read again
+        for (ArrayEntry &array : arrays)
+        {
+            int top = entries[array.layers[0]].target_top;
+            if (array.pending_top < 0 && !array.failed && top < array.resident_top)
+            {
+                array.pending_top = top;
+                array.decoded.resize(array.layers.size());
+                array.decoded_count = 0;
+                for (int slot : array.layers)
+                    enqueue(slot, top);
+            }
+        }
+        for (int slot = 0; slot < (int)entries.size(); ++slot)
+        {
+            Entry &entry = entries[slot];
+            if (entry.array < 0 && entry.pending_top < 0 && !entry.failed && entry.target_top < entry.resident_top)
+                enqueue(slot, entry.target_top);
+        }
+    }
+
+    void markFailed(Entry &entry)
+    {
+        if (entry.failed)
+            return;
+        std::cout << "ERROR::TEXTURE_RESIDENCY::STREAM_FAILED::" << entry.directory << '/' << entry.name << " stays at Level " << entry.resident_top << std::endl;
+        entry.failed = true;
+        ++stream_failures;
+    }
+
+    // the coarser Mips are already on the GPU so read them back instead of touching the Disk
+    void dropLevels(Entry &entry, int top)
+    {
+        int source = top - entry.resident_top;
+        int width = std::max(entry.width >> top, 1);
+        int height = std::max(entry.height >> top, 1);
+        GLenum format = entry.channels == 1 ? GL_RED : entry.channels == 3 ? GL_RGB : GL_RGBA;
+        GLenum internalformat;
+        if (entry.channels == 1)
+            internalformat = GL_RED;
+        else if (entry.channels == 3)
+            internalformat = entry.gamma ? GL_SRGB : GL_RGB;
+        else
+            internalformat = entry.gamma ? GL_SRGB_ALPHA : GL_RGBA;
+
+        std::vector<unsigned char> pixels((size_t)width * height * entry.channels);
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, entry.id);
+        glGetTexImage(GL_TEXTURE_2D, source, format, GL_UNSIGNED_BYTE, pixels.data());
+        glTexImage2D(GL_TEXTURE_2D, 0, internalformat, width, height, 0, format, GL_UNSIGNED_BYTE, pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        entry.resident_top = top;
+        ++streamed_out;
+    }
+
+    // New Storage from Level top on: Levels the old Storage has are copied on the GPU, finer ones come from the Worker's
+    // decoded Layers <required when top is finer than what's resident>
+    // The Layer Views are rebuilt as well, Views of the old Storage would keep it alive
+    void rebuildArray(ArrayEntry &array, int top, const std::vector<TextureLevels> *decoded = nullptr)
+    {
+        Entry &first = entries[array.layers[0]];
+        int width = std::max(first.width >> top, 1);
+        int height = std::max(first.height >> top, 1);
+        int levels = array.levels - top;
+        int layers = (int)array.layers.size();
+
+        GLint internalformat, wrap_s, wrap_t;
+        glGetTextureLevelParameteriv(*array.id, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalformat);
+        glGetTextureParameteriv(first.id, GL_TEXTURE_WRAP_S, &wrap_s);
+        glGetTextureParameteriv(first.id, GL_TEXTURE_WRAP_T, &wrap_t);
+
+        // finer Levels than the old Storage has, uploaded one Layer at a Time
+        std::vector<unsigned int> disk(layers, 0);
+        if (top < array.resident_top)
+            for (int layer = 0; layer < layers; ++layer)
+            {
+                glGenTextures(1, &disk[layer]);
+                TextureLevelsUpload(disk[layer], (*decoded)[layer]);
+            }
+
+        unsigned int rebuilt;
+        glGenTextures(1, &rebuilt);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, rebuilt);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalformat, width, height, layers);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        for (int layer = 0; layer < layers; ++layer)
+            for (int level = 0; level < levels; ++level)
+            {
+                int mip = top + level;
+                int level_width = std::max(width >> level, 1);
+                int level_height = std::max(height >> level, 1);
+                if (mip < array.resident_top)
+                    glCopyImageSubData(disk[layer], GL_TEXTURE_2D, level, 0, 0, 0, rebuilt, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, level_width, level_height, 1);
+                else
+                    glCopyImageSubData(*array.id, GL_TEXTURE_2D_ARRAY, mip - array.resident_top, 0, 0, layer, rebuilt, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, level_width, level_height, 1);
+            }
+        if (top < array.resident_top)
+            glDeleteTextures(layers, disk.data());
+
+        for (int layer = 0; layer < layers; ++layer)
+        {
+            Entry &entry = entries[array.layers[layer]];
+            unsigned int view;
+            glGenTextures(1, &view);
+            glTextureView(view, GL_TEXTURE_2D, rebuilt, internalformat, 0, levels, layer, 1);
+            glTextureParameteri(view, GL_TEXTURE_WRAP_S, wrap_s);
+            glTextureParameteri(view, GL_TEXTURE_WRAP_T, wrap_t);
+            glTextureParameteri(view, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(view, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+            for (TrackedModel &tracked : trackedmodels)
+                for (Mesh &amesh : tracked.model->ServeMeshes())
+                    for (Texture &atexture : amesh.textures)
+                        if (atexture.id == entry.id)
+                            atexture.id = view;
+            glDeleteTextures(1, &entry.id);
+            entry.id = view;
+            entry.resident_top = top;
+        }
+
+        if (top > array.resident_top)
+            ++streamed_out;
+        else
+            ++streamed_in;
+        glDeleteTextures(1, array.id);
+        *array.id = rebuilt;
+        array.resident_top = top;
+    }
+};
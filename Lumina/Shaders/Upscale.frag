@@ -0,0 +1,75 @@
+#version 330 core
+// Edge adaptive spatial Upscale <Dynamic Resolution>: a 4x4 Lanczos-2 Kernel rotated onto the local Gradient,
+// stretched along the Edge so it smooths along it and stays sharp across it, then clamped against Ringing
+
+in VS_OUT {
+    vec2 texCoords;     // 0 ~ 1 over the native Target
+} fs_in;
+
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform ivec2 source_size;      // Pixels holding the Image <lower left of a bigger Texture>
+
+// Along the Edge the Kernel is stretched by up to this Factor
+const float EDGE_STRETCH = 2.0;
+
+float Luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+vec3 Fetch(ivec2 texel) {
+    return texelFetch(source, clamp(texel, ivec2(0), source_size - 1), 0).rgb;
+}
+
+float Lanczos2(float x) {
+    x = abs(x);
+    if (x < 1e-4)
+        return 1.0;
+    if (x >= 2.0)
+        return 0.0;
+    const float PI = 3.14159265;
+    return 2.0 * sin(PI * x) * sin(PI * x * 0.5) / (PI * PI * x * x);
+}
+
+void main() {
+    vec2 position = fs_in.texCoords * vec2(source_size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+
+    // Luma Gradient over the 2x2 Footprint <Sobel-like from the surrounding 4x4>
+    float l[16];
+    vec3 c[16];
+    for (int y = 0; y < 4; ++y)
+        for (int x = 0; x < 4; ++x) {
+            c[y * 4 + x] = Fetch(base + ivec2(x - 1, y - 1));
+            l[y * 4 + x] = Luma(c[y * 4 + x]);
+        }
+    vec2 gradient = vec2(
+        (l[6] + l[10] + l[7] + l[11]) - (l[4] + l[8] + l[5] + l[9]),
+        (l[9] + l[10] + l[13] + l[14]) - (l[1] + l[2] + l[5] + l[6]));
+    gradient += vec2(l[7] - l[4] + l[11] - l[8], l[13] - l[1] + l[14] - l[2]) * 0.5;
+
+    float contrast = max(max(l[5], l[6]), max(l[9], l[10])) - min(min(l[5], l[6]), min(l[9], l[10]));
+    float edge = clamp(length(gradient) / (4.0 * contrast + 1e-4), 0.0, 1.0);
+    vec2 across = length(gradient) > 1e-5 ? normalize(gradient) : vec2(1.0, 0.0);
+    vec2 along = vec2(-across.y, across.x);
+    float stretch = mix(1.0, EDGE_STRETCH, edge * edge);
+
+    vec3 color = vec3(0.0);
+    float weights = 0.0;
+    for (int y = 0; y < 4; ++y)
+        for (int x = 0; x < 4; ++x) {
+            vec2 offset = vec2(x - 1, y - 1) - f;
+            vec2 rotated = vec2(dot(offset, across), dot(offset, along) / stretch);
+            float w = Lanczos2(length(rotated));
+            color += c[y * 4 + x] * w;
+            weights += w;
+        }
+    color /= max(weights, 1e-4);
+
+    // Deringing: the negative Lobes may not leave the Range of the nearest 2x2
+    vec3 lo = min(min(c[5], c[6]), min(c[9], c[10]));
+    vec3 hi = max(max(c[5], c[6]), max(c[9], c[10]));
+    FragColor = vec4(clamp(color, lo, hi), 1.0);
+}
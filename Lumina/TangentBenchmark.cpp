@@ -0,0 +1,124 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <chrono>
+
+#include "lazy.hpp"
+#include "./Shaders/Model.hpp"
+
+// TangentSpace against Assimp's aiProcess_CalcTangentSpace on the same Vertices
+// Both Models go through Assimp so the Vertex Layouts match one to one
+void release(Model &model)
+{
+    for (Mesh &amesh : model.ServeMeshes())
+    {
+        for (Texture &atexture : amesh.textures)
+            glDeleteTextures(1, &atexture.id);
+        amesh.Delete();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "./Model/nanosuit/nanosuit.obj";
+    int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    lazy::glfwCoreEnv(3, 3);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "Tangent Benchmark", NULL, NULL);
+    if(window == NULL)
+    {
+        std::cout << "Failed to Create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+    if(!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to init GLAD" << std::endl;
+        return -1;
+    }
+
+    // Import Time <Textures included, so only the Difference is meaningful>
+    double assimp_ms = 0.0;
+    double native_ms = 0.0;
+    for (int run = 0; run <= runs; ++run)
+    {
+        Model assimp(path.c_str(), 0);
+        Model native(path.c_str(), MODEL_NATIVE_TANGENTS);
+        if (run > 0)
+        {
+            assimp_ms += assimp.ServeLoadTime();
+            native_ms += native.ServeLoadTime();
+        }
+        release(assimp);
+        release(native);
+    }
+
+    // Generation alone on copies of Assimp's Vertices, then the Output Comparison
+    Model reference(path.c_str(), 0);
+    std::vector<std::vector<Vertex>> vertices;
+    std::vector<std::vector<unsigned int>> indices;
+    for (Mesh &amesh : reference.ServeMeshes())
+    {
+        vertices.push_back(amesh.vertices);
+        indices.push_back(amesh.indices);
+    }
+    std::vector<TangentSpaceInput> inputs;
+    for (size_t i = 0; i < vertices.size(); ++i)
+        inputs.push_back({&vertices[i], &indices[i], false});
+
+    double single_ms = 0.0;
+    double parallel_ms = 0.0;
+    for (int run = 0; run < runs; ++run)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        TangentSpace::Generate(inputs, 1);
+        auto middle = std::chrono::high_resolution_clock::now();
+        TangentSpace::Generate(inputs);
+        auto end = std::chrono::high_resolution_clock::now();
+        single_ms += std::chrono::duration<double, std::milli>(middle - start).count();
+        parallel_ms += std::chrono::duration<double, std::milli>(end - middle).count();
+    }
+
+    TangentSpace::Difference total = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0};
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        TangentSpace::Difference difference = TangentSpace::Compare(reference.ServeMeshes()[i].vertices, vertices[i]);
+        total.tangent_mean += difference.tangent_mean * difference.vertices;
+        total.sign_mismatch += difference.sign_mismatch * difference.vertices;
+        total.tangent_max = std::max(total.tangent_max, difference.tangent_max);
+        total.vertices += difference.vertices;
+    }
+
+    // Normals regenerated from scratch against the ones in the File
+    for (TangentSpaceInput &input : inputs)
+        input.normals = true;
+    TangentSpace::Generate(inputs);
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        TangentSpace::Difference difference = TangentSpace::Compare(reference.ServeMeshes()[i].vertices, vertices[i]);
+        total.normal_mean += difference.normal_mean * difference.vertices;
+        total.normal_max = std::max(total.normal_max, difference.normal_max);
+    }
+    if (total.vertices > 0)
+    {
+        total.tangent_mean /= total.vertices;
+        total.sign_mismatch /= total.vertices;
+        total.normal_mean /= total.vertices;
+    }
+
+    std::cout << "Tangent Benchmark: " << path << " (" << runs << " Runs, " << total.vertices << " Vertices)" << std::endl;
+    std::cout << "Import  Assimp: " << assimp_ms / runs << "ms\tNative Tangents: " << native_ms / runs << "ms" << std::endl;
+    std::cout << "Generate  1 Thread: " << single_ms / runs << "ms\t" << std::thread::hardware_concurrency() << " Threads: " << parallel_ms / runs << "ms" << std::endl;
+    std::cout << "Tangent Deviation  Mean: " << total.tangent_mean << "deg\tMax: " << total.tangent_max << "deg\tFlipped BiTangents: " << total.sign_mismatch * 100.0f << "%" << std::endl;
+    std::cout << "Normal Deviation  Mean: " << total.normal_mean << "deg\tMax: " << total.normal_max << "deg" << std::endl;
+
+    release(reference);
+    glfwTerminate();
+    return 0;
+}